@@ -12,10 +12,339 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
 #include "vector.h"
 #include "polygon.h"
 #include "collision.h"
+#include "sampler.h"
+#include "innerfit.h"
+#include "scalecache.h"
+#include "lod.h"
 #include "applications.h"
+#include "parallel.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FIT OPTIONS ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function creates the options for the fitting functions. The seed picks
+ * the positions tried, so the same seed always gives the same answer.
+ * Threads is the number of threads to spread trials over: 0 uses one for each
+ * processor.
+ * 
+ * Positions are picked with the Sobol sampler by default, which covers the 
+ * outside polygon evenly in fewer trials than random positions. Change
+ * "sampler" to use another.
+ * 
+ * By default the fitting functions run every trial. They can instead be made
+ * to stop early and return the best fit found so far, by setting:
+ *  timeLimit      - the number of seconds to run for
+ *  maxEvaluations - the number of findMinScale calls to allow
+ *  cancel         - a flag which stops the fit when set to anything but 0
+ *  progress       - a function called with the best fit after each trial.
+ *                   If it returns anything but EXIT_SUCCESS the fit stops.
+ * 
+ * Setting "cache" to a scaleCache lets findMinScale results be reused, within
+ * a fit and between fits. Results taken from the cache don't count as 
+ * evaluations.
+ * When the fit returns, "evaluations" holds the number of findMinScale calls 
+ * made, and "stopped" is 1 if it stopped before running every trial.
+ */
+fitOptions* buildFitOptions(unsigned long seed, int threads){
+    fitOptions* newOptions = malloc(sizeof(fitOptions));
+    
+    newOptions->seed = seed;
+    newOptions->threads = threads;
+    newOptions->sampler = SAMPLER_SOBOL;
+    newOptions->timeLimit = 0;
+    newOptions->maxEvaluations = 0;
+    newOptions->progress = NULL;
+    newOptions->progressData = NULL;
+    newOptions->cancel = NULL;
+    newOptions->cache = NULL;
+    newOptions->evaluations = 0;
+    newOptions->stopped = 0;
+    newOptions->budget = NULL;
+    
+    return newOptions;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FIT BUDGET TYPE DEFINITION /////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This struct holds the state shared by every thread of one fit for deciding
+ * when to stop: the deadline, the number of evaluations made so far, and the
+ * best fit found so far for reporting progress. It is locked while being
+ * changed, since any thread may update it.
+ */
+typedef struct fitBudget{
+    double deadline;
+    long maxEvaluations;
+    volatile int* cancel;
+    fitProgress progress;
+    void* progressData;
+    long evaluations;
+    int stopped;
+    int done;
+    int total;
+    transformation* best;
+    pthread_mutex_t lock;
+}fitBudget;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// Start Fit Budget ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function is called at the start of a fit that was not called by another
+ * one. It copies the given options (or the defaults, if they're NULL) into
+ * "run", and sets up the budget they describe, starting the clock.
+ */
+static int startFitBudget(fitBudget* budget, fitOptions* options, 
+        fitOptions* run){
+    if(options != NULL){
+        *run = *options;
+    }else{
+        fitOptions* defaults = buildFitOptions((unsigned long)rand(), 0);
+        *run = *defaults;
+        free(defaults);
+    }
+    
+    budget->deadline = 0;
+    if(run->timeLimit > 0){
+        budget->deadline = getTimeSeconds() + run->timeLimit;
+    }
+    budget->maxEvaluations = run->maxEvaluations;
+    budget->cancel = run->cancel;
+    budget->progress = run->progress;
+    budget->progressData = run->progressData;
+    budget->evaluations = 0;
+    budget->stopped = 0;
+    budget->done = 0;
+    budget->total = 0;
+    budget->best = buildTransformation(100, 0, createVector(0.0, 0.0, 0.0));
+    pthread_mutex_init(&budget->lock, NULL);
+    
+    run->budget = budget;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// Finish Fit Budget //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function copies how the fit went back into the caller's options, and 
+ * frees the budget.
+ */
+static int finishFitBudget(fitBudget* budget, fitOptions* options){
+    if(options != NULL){
+        options->evaluations = budget->evaluations;
+        options->stopped = budget->stopped;
+    }
+    free(budget->best->translation);
+    free(budget->best);
+    pthread_mutex_destroy(&budget->lock);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// Check Fit Stop /////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function returns 1 if the fit should stop: because it has been 
+ * cancelled, has run out of time or evaluations, or the progress function
+ * asked it to. Otherwise it returns 0. Once stopped, a fit stays stopped.
+ */
+static int checkFitStop(fitBudget* budget){
+    pthread_mutex_lock(&budget->lock);
+    if(budget->stopped == 0){
+        if(budget->cancel != NULL && *budget->cancel != 0){
+            budget->stopped = 1;
+        }
+        else if(budget->maxEvaluations > 0 && 
+                budget->evaluations >= budget->maxEvaluations){
+            budget->stopped = 1;
+        }
+        else if(budget->deadline > 0 && getTimeSeconds() >= budget->deadline){
+            budget->stopped = 1;
+        }
+    }
+    int stopped = budget->stopped;
+    pthread_mutex_unlock(&budget->lock);
+    return stopped;
+}
+
+/* This function counts one call to findMinScale against the budget.
+ */
+static int countEvaluation(fitBudget* budget){
+    pthread_mutex_lock(&budget->lock);
+    budget->evaluations++;
+    pthread_mutex_unlock(&budget->lock);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// Report Fit Result //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function records that one more trial of a fit has finished, keeps its
+ * result if it is the best so far, and passes the best to the progress 
+ * function if there is one.
+ */
+static int reportFitResult(fitBudget* budget, double scale, double angle, 
+        double x, double y){
+    pthread_mutex_lock(&budget->lock);
+    budget->done++;
+    if(scale < budget->best->scale){
+        budget->best->scale = scale;
+        budget->best->rotationZ = angle;
+        budget->best->translation->x = x;
+        budget->best->translation->y = y;
+    }
+    if(budget->progress != NULL && budget->progress(budget->done, 
+            budget->total, budget->best, budget->progressData) != EXIT_SUCCESS){
+        budget->stopped = 1;
+    }
+    pthread_mutex_unlock(&budget->lock);
+    return(EXIT_SUCCESS);
+}
+
+/* This function returns the number of threads the fitting functions should use
+ * for the given options.
+ */
+static int getFitThreads(fitOptions* options){
+    if(options != NULL && options->threads > 0){
+        return options->threads;
+    }
+    return getProcessorCount();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// TRANSLATION TRIAL TYPE DEFINITIONS /////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* These structs hold the state for the trials of findMinScaleWithTranslation.
+ * 
+ * translationSearch is shared by all threads and is only read during the
+ * trials: it holds the starting polygons that every trial resets to, and an
+ * array with a result slot for every trial.
+ * 
+ * translationWorkspace holds a private copy of both polygons for each thread,
+ * so threads can move and scale them without affecting each other.
+ */
+typedef struct translationResult{
+    double scale;
+    double rotationZ;
+    double x;
+    double y;
+}translationResult;
+
+typedef struct translationWorkspace{
+    polygon* polyInside;
+    polygon* polyOutside;
+}translationWorkspace;
+
+typedef struct translationSearch{
+    polygon* startInside;
+    polygon* startOutside;
+    double precision;
+    sampler* positions;
+    innerFitRegion* fit;
+    fitBudget* budget;
+    fitOptions trialOptions;
+    translationWorkspace* workspaces;
+    translationResult* results;
+}translationSearch;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// Check Trial Fits ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function checks whether a trial's inside polygon is inside the outside
+ * polygon. If the search has an inner-fit region this is a quick check of the 
+ * centre against it, otherwise the full checkInsideBoundingBox is used.
+ */
+static int checkTrialFits(translationSearch* search, polygon* polyInside,
+        polygon* polyOutside){
+    if(search->fit != NULL){
+        return checkInsideInnerFit(search->fit, polyInside->centre);
+    }
+    return checkInsideBoundingBox(polyInside, polyOutside);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// Run Translation Trial //////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function runs a single trial of findMinScaleWithTranslation: it takes
+ * the trial's point from the sampler, which is always inside the inner-fit 
+ * region (or the outside polygon if there isn't one), moves the inside polygon
+ * towards the centre until it fits, and then runs findMinScaleWithRotation
+ * there.
+ * 
+ * Each trial starts from a fresh copy of the starting polygons and its point
+ * depends only on the trial number, so its result doesn't depend on which 
+ * thread ran it or what that thread ran before.
+ */
+static int runTranslationTrial(int trial, int thread, void* data){
+    translationSearch* search = (translationSearch*)data;
+    polygon* polyInside = search->workspaces[thread].polyInside;
+    polygon* polyOutside = search->workspaces[thread].polyOutside;
+    
+    //if the fit has been stopped, don't start any more trials
+    if(checkFitStop(search->budget) == 1){
+        return(EXIT_FAILURE);
+    }
+    
+    //reset this thread's polygons to the starting position
+    copyPolygonTo(polyInside, search->startInside);
+    copyPolygonTo(polyOutside, search->startOutside);
+    
+    //choose this trial's position: inside the region where the inside polygon
+    //fits if one could be built, otherwise anywhere inside the outside polygon
+    polygon* area = polyOutside;
+    if(search->fit != NULL && search->fit->region != NULL){
+        area = search->fit->region;
+    }
+    vector* sample = samplePointInPolygon(search->positions, trial, area);
+    vector* newCentre = createVector(sample->x, sample->y, sample->z);
+
+    translatePolygonTo(polyInside,newCentre);
+
+    double j = 1;
+    //then move it halfway back to the centre each time until polyInside fits.
+    //Points from the fit region fit straight away, unless they're right on the
+    //edge.
+    while(checkTrialFits(search, polyInside, polyOutside) != 1){
+        j = j/2;
+
+        //if J is very small, just return to the centre (avoids infinite loops)
+        if (j <= 0.000001){
+            newCentre->x = area->centre->x;
+            newCentre->y = area->centre->y;
+            newCentre->z = 0.0;
+            translatePolygonTo(polyInside, newCentre);
+            break;
+        }
+        //otherwise find a new point closer to the centre
+        newCentre->x = area->centre->x + (sample->x - area->centre->x)*j;
+        newCentre->y = area->centre->y + (sample->y - area->centre->y)*j;
+        newCentre->z = 0.0;
+        translatePolygonTo(polyInside,newCentre);
+    }
+    
+    //then findMinScaleWithRotation at this point, and store the result in this
+    //trial's slot. The trials are already spread over the threads, so the
+    //angles are tested on this one.
+    transformation* result = findMinScaleWithRotation(polyInside, polyOutside, 
+                                    search->precision, newCentre, 
+                                    &search->trialOptions);
+    
+    search->results[trial].scale = result->scale;
+    search->results[trial].rotationZ = result->rotationZ;
+    search->results[trial].x = newCentre->x;
+    search->results[trial].y = newCentre->y;
+    reportFitResult(search->budget, result->scale, result->rotationZ,
+                    newCentre->x, newCentre->y);
+    
+    //free the created 
+    free(sample);
+    free(newCentre);
+    free(result);
+    
+    return(EXIT_SUCCESS);
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 /////////////// Find Min Scale With Rotation And Translation ///////////////////
@@ -23,89 +352,113 @@
 /*
  * This function calls "FindMinScaleWithRotation multiple times at different 
  * locations a number of times equal to "iterations."
+ * 
+ * The trials are independent, so they are spread across options->threads 
+ * threads, each working on its own copies of the polygons. Once all have run
+ * the smallest scale is picked, with ties going to the earliest trial, so a
+ * given seed always gives the same answer however many threads are used. If
+ * options is NULL, a random seed, the Sobol sampler and one thread per processor
+ * are used.
+ * 
+ * If the options set a time limit, evaluation limit or cancel flag, the trials
+ * stop when it is reached and the best fit found so far is returned. The fit 
+ * centred on the outside polygon always has at least one angle tested, so 
+ * there is always a result.
+ * 
+ * The given polygons are left as they were.
  */
 transformation* findMinScaleWithTranslation(polygon* polyInside, 
-        polygon* polyOutside, double precision, int iterations){
+        polygon* polyOutside, double precision, int iterations,
+        fitOptions* options){
+    
+    fitOptions run;
+    fitBudget budget;
+    startFitBudget(&budget, options, &run);
+    int threads = getFitThreads(&run);
+    int trials = iterations + 1;
+    budget.total = trials + 1;
     
-    //save original scale, rotation, and position for both objects.
-    transformation* polyInsideTransform = buildTransformation(polyInside->transform->scale,
-            polyInside->transform->rotationZ, polyInside->centre);
-    transformation* polyOutsideTransform = buildTransformation(polyOutside->transform->scale,
-            polyOutside->transform->rotationZ, polyOutside->centre);
+    //work on copies of both polygons, so the originals are never moved
+    translationSearch search;
+    search.startInside = copyPolygon(polyInside);
+    search.startOutside = copyPolygon(polyOutside);
+    search.precision = precision;
+    search.positions = buildSampler(run.sampler, run.seed);
+    search.budget = &budget;
+    search.trialOptions = run;
+    search.trialOptions.threads = 1;
     
     //find the minimum scale when the two objects are centred on each other
-    transformation* start = findMinScaleWithRotation(polyInside, polyOutside, 
-                                        precision, polyOutside->centre);
+    transformation* start = findMinScaleWithRotation(search.startInside,
+                    search.startOutside, precision, polyOutside->centre, &run);
+    reportFitResult(&budget, start->scale, start->rotationZ, 
+                    polyOutside->centre->x, polyOutside->centre->y);
     
     double minScale = start->scale;
     double angleAtMin = start->rotationZ;
-    vector* translationAtMin = start->translation;
+    vector* translationAtMin = createVector(polyOutside->centre->x,
+                                            polyOutside->centre->y,
+                                            polyOutside->centre->z);
     
-    //apply this translation, so we're at min scale at centred position to start
-    scalePolygonTo(polyOutside, start->scale);
-    rotatePolygonZTo(polyInside, start->rotationZ);
-    translatePolygonTo(polyInside, start->translation);
+    //set up the starting polygons for the trials: at min scale at centred 
+    //position
+    scalePolygonTo(search.startOutside, start->scale);
+    rotatePolygonZTo(search.startInside, start->rotationZ);
+    translatePolygonTo(search.startInside, polyOutside->centre);
     
-    //for a large number of times
+    //if the outside polygon is convex, work out the region the inside 
+    //polygon's centre can be in at this scale and angle, so trials only pick
+    //positions where it fits
+    search.fit = NULL;
+    if(checkIfConvex(search.startOutside) == 1){
+        search.fit = buildInnerFitRegion(search.startInside, search.startOutside);
+        if(search.fit->region == NULL){
+            freeInnerFitRegion(search.fit);
+            search.fit = NULL;
+        }
+    }
+    
+    //give each thread its own copy of the polygons to work on
+    search.workspaces = malloc(sizeof(translationWorkspace)*threads);
     int i;
-    for(i=0;i<=iterations;i++){
-        //choose a random direction, with a random magnitude
-        vector* rand = rand2DVector();
-        
-        //and translate polyInside by a distance in it
-        vector* newCentre = createVector(polyOutside->centre->x + rand->x*1600,
-                                        polyOutside->centre->y + rand->y*1600,
-                                        polyOutside->centre->z + rand->z*1600);
-        
-        translatePolygonTo(polyInside,newCentre);
-        
-        double j = 1600;
-        //then reduce this direction by half each time until polyInside fits
-        while(checkInsideBoundingBox(polyInside, polyOutside) != 1){
-            j = j/2;
-            
-            //if J is very small, just return to the centre (avoids infinite loops)
-            if (j <= 0.001){
-                newCentre = createVector(polyOutside->centre->x,
-                                polyOutside->centre->y,0.0);
-                translatePolygonTo(polyInside, newCentre);
-                break;
-            }
-            //otherwise find a new point closer to the centre
-            newCentre = createVector(polyOutside->centre->x + rand->x*j,
-                                polyOutside->centre->y + rand->y*j,
-                                0.0);
-            translatePolygonTo(polyInside,newCentre);
+    for(i = 0; i < threads; i++){
+        search.workspaces[i].polyInside = copyPolygon(search.startInside);
+        search.workspaces[i].polyOutside = copyPolygon(search.startOutside);
+    }
+    
+    //run all the trials, a few hundred to thousand times. Trials that are 
+    //never run because the fit stopped keep a scale that can't be the minimum
+    search.results = malloc(sizeof(translationResult)*trials);
+    for(i = 0; i < trials; i++){
+        search.results[i].scale = HUGE_VAL;
+    }
+    parallelFor(trials, threads, runTranslationTrial, &search);
+    
+    //if any trial's scale is less, save its position and rotation
+    for(i = 0; i < trials; i++){
+        if(search.results[i].scale < minScale){
+            minScale = search.results[i].scale;
+            angleAtMin = search.results[i].rotationZ;
+            translationAtMin->x = search.results[i].x;
+            translationAtMin->y = search.results[i].y;
         }
-        printf("|| Testing at %f, %f ", polyInside->centre->x,
-                                polyInside->centre->y);      
-        //then findMinScaleWithRotation at this point
-        transformation* result = findMinScaleWithRotation(polyInside, polyOutside, 
-                                        precision, newCentre);
-        
-        //if the scale is less, save the position and rotation
-        if(result->scale < minScale){
-            minScale = result->scale;
-            angleAtMin = result->rotationZ;
-            translationAtMin->x = polyInside->centre->x;
-            translationAtMin->y = polyInside->centre->y;
-        }    
-        
-        //free the created 
-        free(rand);
-        free(newCentre);
-        free(result);
-    } //keep doing this a few hundred to thousand times 
-    
-    //at the end, reset the objects to their original locations, scales, etc
-    scalePolygonTo(polyOutside, polyOutsideTransform->scale);
-    rotatePolygonZTo(polyInside, polyInsideTransform->rotationZ);
-    translatePolygonTo(polyInside, polyInsideTransform->translation);
-    
-    //free(polyInsideTransform->translation);
-    free(polyInsideTransform);
-    free(polyOutsideTransform);
+    }
+    
+    //free the trial state
+    for(i = 0; i < threads; i++){
+        freePolygon(search.workspaces[i].polyInside);
+        freePolygon(search.workspaces[i].polyOutside);
+    }
+    freePolygon(search.startInside);
+    freePolygon(search.startOutside);
+    free(search.workspaces);
+    free(search.results);
+    free(search.positions);
+    if(search.fit != NULL){
+        freeInnerFitRegion(search.fit);
+    }
     free(start);
+    finishFitBudget(&budget, options);
   
     //return the smallest scale and info
     transformation* returnTransform = buildTransformation(minScale,angleAtMin,
@@ -113,92 +466,224 @@ transformation* findMinScaleWithTranslation(polygon* polyInside,
     return returnTransform;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/////////////// ANGLE SEARCH TYPE DEFINITION ///////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This struct holds the state for one band of angles in 
+ * findMinScaleWithRotation. Every angle starts from the same copies of the two
+ * polygons and each thread has its own workspace copies to rotate and scale,
+ * so the angles can be tested in any order on any thread.
+ */
+typedef struct angleSearch{
+    polygon* startInside;
+    polygon* startOutside;
+    double precision;
+    double firstAngle;
+    double step;
+    double* scales;
+    fitBudget* budget;
+    scaleCache* cache;
+    translationWorkspace* workspaces;
+}angleSearch;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// Run Angle Trial ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds the minimum scale for a single angle in a band: it resets
+ * this thread's copies, rotates the inside copy to the angle, and stores the
+ * result of findMinScale (or the cached result, if there is one) in the 
+ * angle's slot.
+ */
+static int runAngleTrial(int index, int thread, void* data){
+    angleSearch* search = (angleSearch*)data;
+    polygon* polyInside = search->workspaces[thread].polyInside;
+    polygon* polyOutside = search->workspaces[thread].polyOutside;
+    
+    //if the fit has been stopped, don't test any more angles. The first is
+    //always tested so the band has a result.
+    if(index > 0 && checkFitStop(search->budget) == 1){
+        return(EXIT_FAILURE);
+    }
+    
+    copyPolygonTo(polyInside, search->startInside);
+    copyPolygonTo(polyOutside, search->startOutside);
+    
+    rotatePolygonZTo(polyInside, search->firstAngle + index*search->step);
+    
+    //use the cached scale for this position if there is one
+    if(search->cache != NULL && lookupScale(search->cache, polyInside, 
+            polyOutside, (int)search->precision, &search->scales[index]) == 1){
+        return(EXIT_SUCCESS);
+    }
+    
+    search->scales[index] = findMinScale(polyInside, polyOutside, 
+                                            search->precision);
+    countEvaluation(search->budget);
+    
+    if(search->cache != NULL){
+        storeScale(search->cache, polyInside, polyOutside, 
+                    (int)search->precision, search->scales[index]);
+    }
+    
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// Find Min Scale In Band /////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function tests "count" angles, starting at firstAngle and going up by
+ * step, across the given number of threads. If any has a smaller scale than
+ * minScale, minScale and angleAtMin are set to the smallest (the first, if
+ * several are equal).
+ */
+static int findMinScaleInBand(angleSearch* search, double firstAngle, 
+        double step, int count, int threads, double* minScale, 
+        double* angleAtMin){
+    
+    search->firstAngle = firstAngle;
+    search->step = step;
+    
+    //angles that aren't tested because the fit stopped keep a scale that can't
+    //be the minimum
+    int i;
+    for(i = 0; i < count; i++){
+        search->scales[i] = HUGE_VAL;
+    }
+    parallelFor(count, threads, runAngleTrial, search);
+    
+    for(i = 0; i < count; i++){
+        //if its smaller than the current minimum, set it to the minimum
+        if(search->scales[i] < *minScale){
+            *minScale = search->scales[i];
+            *angleAtMin = firstAngle + i*step;
+        }
+    }
+    return(EXIT_SUCCESS);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //////////////// Find Min Scale With Rotation //////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 /* This function uses the FindMinimumScale function to find the minimum scale
  * at which a polygon will fit inside another, and does the same for a variety
  * of angles in order to get the minimum scale possible when the angle can be
- * adjusted. It returns both polygons to their original scale and orientation.
+ * adjusted. 
+ * 
+ * The angles in each band are independent, so each is tested on its own rotated
+ * copy of the polygons, spread across options->threads threads (one per 
+ * processor if options is NULL). The given polygons are not changed.
+ * 
+ * If the options' budget runs out the remaining angles are skipped and the
+ * best angle tested so far is returned.
  * 
  * NOTE: While this function returns a transformation, the scale and rotation of
  * the transformation are to be applied to different objects.
  */
 transformation* findMinScaleWithRotation(polygon* polyInside, polygon* polyOutside, 
-                                            double precision, vector* newCentre){
+                                            double precision, vector* newCentre,
+                                            fitOptions* options){
     
-    //save the start position of the inside polygon
-    vector* startVector = createVector(polyInside->centre->x,
-                                        polyInside->centre->y,
-                                        polyInside->centre->z);
+    //if this was called by findMinScaleWithTranslation, share its budget,
+    //otherwise start one
+    fitOptions run;
+    fitBudget ownBudget;
+    fitBudget* budget = NULL;
+    if(options != NULL && options->budget != NULL){
+        run = *options;
+        budget = options->budget;
+    }else{
+        startFitBudget(&ownBudget, options, &run);
+        budget = &ownBudget;
+    }
+    int threads = getFitThreads(&run);
     
-    //move polyInside to the new position
-    translatePolygonTo(polyInside, newCentre);
+    //copy the polygons and move the inside copy to the new position
+    angleSearch search;
+    search.budget = budget;
+    search.cache = run.cache;
+    search.startInside = copyPolygon(polyInside);
+    search.startOutside = copyPolygon(polyOutside);
+    search.precision = precision;
+    translatePolygonTo(search.startInside, newCentre);
+    
+    //give each thread its own copy to rotate, and each angle a result slot
+    search.workspaces = malloc(sizeof(translationWorkspace)*threads);
+    int i;
+    for(i = 0; i < threads; i++){
+        search.workspaces[i].polyInside = copyPolygon(search.startInside);
+        search.workspaces[i].polyOutside = copyPolygon(search.startOutside);
+    }
+    search.scales = malloc(sizeof(double)*37);
     
-    double angleAtMin, scale;
+    double angleAtMin = 0;
     double minScale = 100;
-    double i = 0.0;
+    
+    //if the inside polygon has levels of detail, the first scan uses the 
+    //coarsest outer approximation within 1/64 of its size instead, on its own
+    //copies. Anything that fits around the approximation fits around the
+    //polygon, so its scales are safe to keep, and the finer scans below use
+    //the polygon itself.
+    polygon* exactInside = search.startInside;
+    translationWorkspace* exactWorkspaces = search.workspaces;
+    bounds insideBounds;
+    getPolygonBounds(search.startInside, &insideBounds);
+    double insideSize = sqrt(
+            pow(insideBounds.maxX - insideBounds.minX, 2) + 
+            pow(insideBounds.maxY - insideBounds.minY, 2));
+    polygon* coarseInside = buildOuterApproximation(search.startInside, 
+            insideSize/64);
+    if(coarseInside != NULL){
+        search.startInside = coarseInside;
+        search.workspaces = malloc(sizeof(translationWorkspace)*threads);
+        for(i = 0; i < threads; i++){
+            search.workspaces[i].polyInside = copyPolygon(coarseInside);
+            search.workspaces[i].polyOutside = exactWorkspaces[i].polyOutside;
+        }
+        //the approximation is new each time, so its results can't be reused
+        search.cache = NULL;
+    }
+    
     //for every ten degrees, get the minimum scale the outside polygon can be to
     //fit it inside
-    for(i; i<=360.0; i=i+10.0){
-        
-        scale = findMinScale(polyInside, polyOutside, precision);
-        
-        //if its smaller than the current minimum, set it to the minimum
-        if(scale < minScale){
-            minScale = scale;
-            angleAtMin = i;
+    findMinScaleInBand(&search, 0.0, 10.0, 37, threads, &minScale, &angleAtMin);
+    
+    if(coarseInside != NULL){
+        for(i = 0; i < threads; i++){
+            freePolygon(search.workspaces[i].polyInside);
         }
-        
-        //rotate the polygon to the next position
-        rotatePolygonZ(polyInside, 10.0);
+        free(search.workspaces);
+        freePolygon(coarseInside);
+        search.startInside = exactInside;
+        search.workspaces = exactWorkspaces;
+        search.cache = run.cache;
     }
     
-    //rotate polyInside back to the minimum -10 to iterate through possible
-    //minimums
-    rotatePolygonZTo(polyInside, angleAtMin-10);
-    
     //repeat for every 1 degree, working in a 10-degree band on either side of
     //the previous minimum
-    for(i = angleAtMin - 10; i<=angleAtMin+10.0; i++){
-        
-        scale = findMinScale(polyInside, polyOutside, precision);
-        
-        //if its smaller than the current minimum, set it to the minimum
-        if(scale < minScale){
-            minScale = scale;
-            angleAtMin = i;
-        }
-        
-        //rotate the polygon to the next position
-        rotatePolygonZ(polyInside, 1.0);
+    if(checkFitStop(budget) == 0){
+        findMinScaleInBand(&search, angleAtMin - 10.0, 1.0, 21, threads, 
+                            &minScale, &angleAtMin);
     }
     
-    //rotate polyInside back to the minimum -1 to iterate through possible
-    //minimums
-    rotatePolygonZTo(polyInside, angleAtMin-1);
-    
     //repeat for every 1/10th degree, working in a 1-degree band on either side of
     //the previous minimum
-    for(i = angleAtMin - 1; i<=angleAtMin+1.0; i = i + 0.1){
-        
-        double scale = findMinScale(polyInside, polyOutside, precision);
-        
-        //if its smaller than the current minimum, set it to the minimum
-        if(scale < minScale){
-            minScale = scale;
-            angleAtMin = i;
-        }
-        
-        //rotate the polygon to the next position
-        rotatePolygonZ(polyInside, 0.1);
+    if(checkFitStop(budget) == 0){
+        findMinScaleInBand(&search, angleAtMin - 1.0, 0.1, 21, threads, 
+                            &minScale, &angleAtMin);
     }
     
-    //rotate and move the polygons back to the start
-    rotatePolygonZTo(polyInside, 0);
-    translatePolygonTo(polyInside, startVector);
-    
-    free(startVector);
+    //free the copies
+    for(i = 0; i < threads; i++){
+        freePolygon(search.workspaces[i].polyInside);
+        freePolygon(search.workspaces[i].polyOutside);
+    }
+    freePolygon(search.startInside);
+    freePolygon(search.startOutside);
+    free(search.workspaces);
+    free(search.scales);
+    if(budget == &ownBudget){
+        finishFitBudget(&ownBudget, options);
+    }
     
     //return the transformation for the required changes
     return buildTransformation(minScale, angleAtMin, polyOutside->centre);
@@ -212,15 +697,24 @@ transformation* findMinScaleWithRotation(polygon* polyInside, polygon* polyOutsi
  * it. It restores the original scale of the outer polygon.
  * 
  * At the end, this function restores the outside polygon to its original scale, 
- * and returns the minimum scale as a double.
+ * and returns the minimum scale as a double. If a concave outside polygon can't
+ * be made to fit around the inside one, HUGE_VAL is returned.
  */
 double findMinScale(polygon* polyInside, polygon* polyOutside, int precision){
     double startScale = polyOutside->transform->scale;
     
     //firstly, make the Outside polygon larger until the inside poly fits
-    //inside it
+    //inside it. A concave (split) outside polygon might never fit around it,
+    //as the inside one can be left in a notch however large it gets, so give
+    //up on it after a thousand steps.
+    int steps = 0;
     while(checkInsideBoundingBox(polyInside, polyOutside) != 1){
+        if(polyOutside->pieces != NULL && steps == 1000){
+            scalePolygonTo(polyOutside, startScale);
+            return HUGE_VAL;
+        }
         scalePolygonTo(polyOutside, polyOutside->transform->scale+1);
+        steps++;
     }
     
     //then make it smaller in until the inside polygon no longer fits
@@ -17,10 +17,32 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+struct fitBudget;
+
+typedef int (*fitProgress)(int done, int total, transformation* best, void* data);
+
+typedef struct fitOptions{
+    unsigned long seed;
+    int threads;
+    samplerType sampler;
+    double timeLimit;
+    long maxEvaluations;
+    fitProgress progress;
+    void* progressData;
+    volatile int* cancel;
+    struct scaleCache* cache;
+    long evaluations;
+    int stopped;
+    struct fitBudget* budget;
+}fitOptions;
+
+fitOptions* buildFitOptions(unsigned long seed, int threads);
 transformation* findMinScaleWithTranslation(polygon* polyInside, polygon* polyOutside, 
-                                            double precision, int iterations);
+                                            double precision, int iterations,
+                                            fitOptions* options);
 transformation* findMinScaleWithRotation(polygon* polyInside, polygon* polyOutside, 
-                                            double precision, vector* newCentre);
+                                            double precision, vector* newCentre,
+                                            fitOptions* options);
 double findMinScale(polygon* polyInside, polygon* polyOutside, int precision);
 
 #ifdef __cplusplus
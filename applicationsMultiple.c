@@ -0,0 +1,364 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          APPLICATIONS (MULTIPLE)
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the methods to place many polygons inside one bound at 
+ * once ("nesting"), such as cutting many parts from one sheet of material.
+ * 
+ * Parts are placed one at a time, largest first, with a "bottom-left fill": 
+ * each part goes at the lowest position (and then the furthest left) where it
+ * fits inside the sheet without colliding with any part already placed. Each
+ * part is also tried at a number of rotations, and the rotation that gets it
+ * lowest is kept.
+ * 
+ * The positions tried are the corners of the sheet's inner-fit region and the
+ * positions that put the part just against the sheet or a placed part. The 
+ * sheet check uses the inner-fit region where the sheet is convex, and the
+ * check against placed parts only looks at the parts the broadphase grid says
+ * are nearby.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vector.h"
+#include "polygon.h"
+#include "collision.h"
+#include "innerfit.h"
+#include "broadphase.h"
+#include "applicationsMultiple.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SORT HELPERS ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* These functions sort values for qsort: doubles in order, and candidate 
+ * positions from bottom to top, then left to right.
+ */
+static int compareDoubles(const void* a, const void* b){
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct packCandidate{
+    double x;
+    double y;
+}packCandidate;
+
+static int compareCandidates(const void* a, const void* b){
+    const packCandidate* p = a;
+    const packCandidate* q = b;
+    if(p->y != q->y){
+        return (p->y > q->y) - (p->y < q->y);
+    }
+    return (p->x > q->x) - (p->x < q->x);
+}
+
+/* This function sorts a list of doubles and removes any repeated values, 
+ * returning the new length.
+ */
+static int sortUnique(double* values, int count){
+    if(count == 0){
+        return 0;
+    }
+    qsort(values, count, sizeof(double), compareDoubles);
+    int i, kept = 1;
+    for(i = 1; i < count; i++){
+        if(values[i] != values[kept-1]){
+            values[kept] = values[i];
+            kept++;
+        }
+    }
+    return kept;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// PACK STATE /////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This holds everything known about the parts placed so far: a copy of each
+ * in its placed position, its bounding box, and the grid they are stored in.
+ */
+typedef struct packState{
+    polygon* sheet;
+    bounds sheetBounds;
+    innerFitRegion* fit;
+    double gap;
+    polygon** placed;
+    bounds* placedBounds;
+    int placedCount;
+    spatialGrid* grid;
+    int* nearby;
+    int nearbyCapacity;
+}packState;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CHECK PLACEMENT ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function checks whether a part, already moved to the position being
+ * tried, fits there. It returns 1 if the part is inside the sheet and clear of
+ * every placed part, and 0 if not.
+ * 
+ * The cheapest checks run first: the inner-fit region (when there is one), 
+ * then the broadphase and a full collision check with only the nearby parts,
+ * and finally a full check that the part is inside the sheet.
+ */
+static int checkPlacement(packState* s, polygon* part){
+    if(s->fit != NULL && checkInsideInnerFit(s->fit, part->centre) == 0){
+        return 0;
+    }
+    
+    bounds b;
+    getPolygonBounds(part, &b);
+    if(b.minX <= s->sheetBounds.minX || b.maxX >= s->sheetBounds.maxX ||
+       b.minY <= s->sheetBounds.minY || b.maxY >= s->sheetBounds.maxY){
+        return 0;
+    }
+    
+    int found = gridQuery(s->grid, &b, &s->nearby, &s->nearbyCapacity);
+    int i;
+    for(i = 0; i < found; i++){
+        if(checkCollisions(part, s->placed[s->nearby[i]]) == 0){
+            return 0;
+        }
+    }
+    
+    return checkInsideBoundingBox(part, s->sheet);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FIND LOWEST POSITION ///////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds the lowest, then furthest left, position that a part 
+ * fits at in its current rotation. The part is left at that position and 1 is
+ * returned, or 0 is returned if it doesn't fit anywhere.
+ * 
+ * The positions tried put the part's bounding box just against the sheet's 
+ * bounding box or a placed part's, in each direction, with every combination
+ * of the resulting x and y positions. The corners of the inner-fit region are
+ * also tried, so parts can go into the sheet's corners where it isn't a 
+ * rectangle.
+ */
+static int findLowestPosition(packState* s, polygon* part){
+    bounds b;
+    getPolygonBounds(part, &b);
+    double left = part->centre->x - b.minX;
+    double right = b.maxX - part->centre->x;
+    double down = part->centre->y - b.minY;
+    double up = b.maxY - part->centre->y;
+    
+    //there are two positions against each placed part and the sheet in each
+    //direction, plus the inner-fit region's corners
+    int fitCount = (s->fit != NULL) ? s->fit->count : 0;
+    int maxValues = 2*(s->placedCount+1) + fitCount;
+    double* xs = malloc(sizeof(double)*maxValues);
+    double* ys = malloc(sizeof(double)*maxValues);
+    int xCount = 0, yCount = 0, i, j;
+    
+    xs[xCount++] = s->sheetBounds.minX + left + s->gap;
+    xs[xCount++] = s->sheetBounds.maxX - right - s->gap;
+    ys[yCount++] = s->sheetBounds.minY + down + s->gap;
+    ys[yCount++] = s->sheetBounds.maxY - up - s->gap;
+    for(i = 0; i < s->placedCount; i++){
+        xs[xCount++] = s->placedBounds[i].maxX + left + s->gap;
+        xs[xCount++] = s->placedBounds[i].minX - right - s->gap;
+        ys[yCount++] = s->placedBounds[i].maxY + down + s->gap;
+        ys[yCount++] = s->placedBounds[i].minY - up - s->gap;
+    }
+    for(i = 0; i < fitCount; i++){
+        xs[xCount++] = s->fit->region->vertices[i]->x;
+        ys[yCount++] = s->fit->region->vertices[i]->y;
+    }
+    xCount = sortUnique(xs, xCount);
+    yCount = sortUnique(ys, yCount);
+    
+    //keep only the positions that keep the part's box inside the sheet's box,
+    //and try them from the bottom left
+    packCandidate* candidates = malloc(sizeof(packCandidate)*xCount*yCount);
+    int candidateCount = 0;
+    for(i = 0; i < xCount; i++){
+        if(xs[i] - left <= s->sheetBounds.minX || 
+                xs[i] + right >= s->sheetBounds.maxX){
+            continue;
+        }
+        for(j = 0; j < yCount; j++){
+            if(ys[j] - down <= s->sheetBounds.minY || 
+                    ys[j] + up >= s->sheetBounds.maxY){
+                continue;
+            }
+            candidates[candidateCount].x = xs[i];
+            candidates[candidateCount].y = ys[j];
+            candidateCount++;
+        }
+    }
+    qsort(candidates, candidateCount, sizeof(packCandidate), compareCandidates);
+    
+    int fits = 0;
+    vector* position = createVector(0.0, 0.0, part->centre->z);
+    for(i = 0; i < candidateCount && fits == 0; i++){
+        position->x = candidates[i].x;
+        position->y = candidates[i].y;
+        translatePolygonTo(part, position);
+        fits = checkPlacement(s, part);
+    }
+    
+    free(position);
+    free(candidates);
+    free(xs);
+    free(ys);
+    return fits;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// PACK POLYGONS //////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function places as many of the NULL-terminated list of parts inside the
+ * sheet as it can, without any two overlapping. Each part is tried at the
+ * given number of rotations, evenly spread around a full turn from its current
+ * rotation (1 tries only its current rotation, 4 tries every 90 degrees).
+ * 
+ * Neither the parts nor the sheet are changed. The result holds a 
+ * transformation for each part, in the same order as the list, giving the 
+ * rotation and centre it should be moved to - or NULL if it couldn't be 
+ * placed. Parts and the sheet should be convex, and the sheet clockwise like
+ * all bounds.
+ * 
+ * The utilisation is the proportion of the sheet's area covered by the 
+ * placed parts.
+ */
+packResult* packPolygons(polygon* parts[], polygon* sheet, int rotations){
+    int count = 0, i, j, r;
+    while(parts[count] != NULL){
+        count++;
+    }
+    if(rotations < 1){
+        rotations = 1;
+    }
+    
+    packResult* result = malloc(sizeof(packResult));
+    result->placements = calloc(count, sizeof(transformation*));
+    result->count = count;
+    result->placed = 0;
+    result->utilisation = 0;
+    
+    //order the parts largest first, as small parts can fill the gaps left
+    //between large ones but not the other way round
+    int* order = malloc(sizeof(int)*(count+1));
+    double* areas = malloc(sizeof(double)*(count+1));
+    bounds* boxes = malloc(sizeof(bounds)*(count+1));
+    for(i = 0; i < count; i++){
+        order[i] = i;
+        areas[i] = getPolygonArea(parts[i]);
+        getPolygonBounds(parts[i], &boxes[i]);
+        for(j = i; j > 0 && areas[order[j]] > areas[order[j-1]]; j--){
+            int swap = order[j];
+            order[j] = order[j-1];
+            order[j-1] = swap;
+        }
+    }
+    
+    packState s;
+    s.sheet = sheet;
+    getPolygonBounds(sheet, &s.sheetBounds);
+    s.gap = 1e-9*((s.sheetBounds.maxX - s.sheetBounds.minX) + 
+                  (s.sheetBounds.maxY - s.sheetBounds.minY));
+    s.placed = malloc(sizeof(polygon*)*(count+1));
+    s.placedBounds = malloc(sizeof(bounds)*(count+1));
+    s.placedCount = 0;
+    //the grid starts empty, with cells sized for the parts to be placed in it
+    s.grid = buildSpatialGrid(getGridCellSize(boxes, count));
+    free(boxes);
+    s.nearby = NULL;
+    s.nearbyCapacity = 0;
+    int sheetConvex = checkIfConvex(sheet);
+    
+    double placedArea = 0;
+    for(i = 0; i < count; i++){
+        polygon* part = parts[order[i]];
+        polygon* best = NULL;
+        double bestBottom = 0, bestLeft = 0;
+        
+        //try the part at each rotation, keeping the one placed lowest
+        for(r = 0; r < rotations; r++){
+            polygon* trial = copyPolygon(part);
+            rotatePolygonZ(trial, r*360.0/rotations);
+            s.fit = (sheetConvex == 1) ? buildInnerFitRegion(trial, sheet) : NULL;
+            
+            //a convex sheet with no inner-fit region is too small for the
+            //part at this rotation
+            int fits = 0;
+            if(sheetConvex == 0 || s.fit->region != NULL){
+                fits = findLowestPosition(&s, trial);
+            }
+            if(s.fit != NULL){
+                freeInnerFitRegion(s.fit);
+            }
+            
+            bounds b;
+            getPolygonBounds(trial, &b);
+            if(fits == 1 && (best == NULL || b.minY < bestBottom ||
+                    (b.minY == bestBottom && b.minX < bestLeft))){
+                if(best != NULL){
+                    freePolygon(best);
+                }
+                best = trial;
+                bestBottom = b.minY;
+                bestLeft = b.minX;
+            }
+            else{
+                freePolygon(trial);
+            }
+        }
+        
+        if(best == NULL){
+            continue;
+        }
+        
+        //keep the placed copy so later parts are checked against it
+        s.placed[s.placedCount] = best;
+        getPolygonBounds(best, &s.placedBounds[s.placedCount]);
+        gridInsert(s.grid, s.placedCount, &s.placedBounds[s.placedCount]);
+        s.placedCount++;
+        
+        result->placements[order[i]] = buildTransformation(best->transform->scale,
+                best->transform->rotationZ, 
+                createVector(best->centre->x, best->centre->y, best->centre->z));
+        result->placed++;
+        placedArea += areas[order[i]];
+    }
+    
+    double sheetArea = getPolygonArea(sheet);
+    if(sheetArea > 0){
+        result->utilisation = placedArea/sheetArea;
+    }
+    
+    for(i = 0; i < s.placedCount; i++){
+        freePolygon(s.placed[i]);
+    }
+    free(s.placed);
+    free(s.placedBounds);
+    free(s.nearby);
+    freeSpatialGrid(s.grid);
+    free(order);
+    free(areas);
+    
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FREE PACK RESULT ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function frees a packing result and its transformations.
+ */
+int freePackResult(packResult* r){
+    int i;
+    for(i = 0; i < r->count; i++){
+        if(r->placements[i] != NULL){
+            free(r->placements[i]->translation);
+            free(r->placements[i]);
+        }
+    }
+    free(r->placements);
+    free(r);
+    return(EXIT_SUCCESS);
+}
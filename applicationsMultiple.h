@@ -0,0 +1,32 @@
+/* 
+ * File:   applicationsMultiple.h
+ *
+ * This header file externalises the functions in the applicationsMultiple.c
+ * file, which places many polygons inside one bound at once.
+ * 
+ * For further details on any function, check there.
+ */
+
+#ifndef APPLICATIONSMULTIPLE_H
+#define APPLICATIONSMULTIPLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct packResult{
+    transformation** placements;
+    int count;
+    int placed;
+    double utilisation;
+}packResult;
+
+packResult* packPolygons(polygon* parts[], polygon* sheet, int rotations);
+int freePackResult(packResult* r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APPLICATIONSMULTIPLE_H */
+
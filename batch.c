@@ -0,0 +1,346 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          BATCH
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to run a list of fits from a file, without
+ * any input from the user, so that thousands of pairs can be fitted overnight.
+ * 
+ * Each line of the job file describes one fit of an inside polygon in an
+ * outside polygon, by their numbers in the loaded file:
+ * 
+ *      inside outside precision iterations [seconds]
+ * 
+ * The time limit in seconds is optional (0 or missing is no limit). Blank 
+ * lines and lines starting with # are ignored. A job is known by its line
+ * number in the job file.
+ * 
+ * Jobs run at the same time on every processor, each on its own copies of its
+ * polygons, starting with the jobs expected to take longest so no processor is
+ * left with a long job at the end. Each result is written to the output file,
+ * as a CSV line, as soon as its job finishes. If the run is stopped, running
+ * it again with the same output file skips the jobs already in it and adds
+ * the rest.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "vector.h"
+#include "polygon.h"
+#include "sampler.h"
+#include "scalecache.h"
+#include "applications.h"
+#include "parallel.h"
+#include "results.h"
+#include "batch.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BATCH RUN TYPE DEFINITION //////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This holds everything shared by the threads running one batch: the jobs, the
+ * output file and the lock that stops two results being written at once.
+ */
+typedef struct batchRun{
+    polygon** scene;
+    batchJob* jobs;
+    int count;
+    FILE* output;
+    pthread_mutex_t lock;
+    struct resultSink* log;
+    scaleCache* cache;
+    volatile int* cancel;
+    int finished;
+}batchRun;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ BATCH JOBS ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads every job in a job file into a newly allocated list, 
+ * which *jobs is set to. It returns the number of jobs read. Lines which can't
+ * be read are reported and skipped.
+ */
+int readBatchJobs(FILE* jobFile, batchJob** jobs){
+    char line[256];
+    int count = 0, capacity = 64, lineNumber = 0;
+    *jobs = malloc(sizeof(batchJob)*capacity);
+    
+    while(fgets(line, sizeof(line), jobFile) != NULL){
+        lineNumber++;
+        
+        //skip blank lines and comments
+        char* start = line;
+        while(*start == ' ' || *start == '\t'){
+            start++;
+        }
+        if(*start == '#' || *start == '\n' || *start == '\r' || *start == '\0'){
+            continue;
+        }
+        
+        batchJob job;
+        job.number = lineNumber;
+        job.timeLimit = 0;
+        int read = sscanf(start, "%d %d %d %d %lf", &job.inside, &job.outside,
+                &job.precision, &job.iterations, &job.timeLimit);
+        if(read < 4 || job.precision < 1 || job.precision > 8 ||
+                job.iterations < 0 || job.timeLimit < 0){
+            printf(" Job file line %d could not be read, skipping it.\n", 
+                    lineNumber);
+            continue;
+        }
+        
+        if(count == capacity){
+            capacity = capacity*2;
+            *jobs = realloc(*jobs, sizeof(batchJob)*capacity);
+        }
+        (*jobs)[count] = job;
+        count++;
+    }
+    return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ FINISHED JOBS /////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads the job numbers already in an output file from an 
+ * earlier run, and marks them in the finished list (which has an entry for 
+ * every job number up to maxNumber). It returns the number found, and sets
+ * torn if the file ends part way through a line.
+ */
+static int readFinishedJobs(FILE* output, char* finished, int maxNumber,
+        int* torn){
+    char line[512];
+    int found = 0;
+    *torn = 0;
+    while(fgets(line, sizeof(line), output) != NULL){
+        int number, inside, outside, precision, iterations, stopped;
+        double scale, rotation, x, y;
+        long evaluations;
+        *torn = (strchr(line, '\n') == NULL);
+        //only whole records are counted: the header doesn't start with a
+        //number, and a line cut short by an earlier run is missing fields
+        //even once it has been ended
+        if(sscanf(line, "%d,%d,%d,%d,%d,%lf,%lf,%lf,%lf,%ld,%d", &number, 
+                &inside, &outside, &precision, &iterations, &scale, &rotation,
+                &x, &y, &evaluations, &stopped) == 11 && number > 0 && 
+                number <= maxNumber && *torn == 0){
+            if(finished[number] == 0){
+                found++;
+            }
+            finished[number] = 1;
+        }
+    }
+    return found;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// COMPARE JOB COSTS //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function sorts jobs for qsort from the most to the least expensive, 
+ * keeping the file's order between jobs of the same cost.
+ */
+static int compareJobCosts(const void* a, const void* b){
+    const batchJob* p = a;
+    const batchJob* q = b;
+    if(p->cost != q->cost){
+        return (p->cost < q->cost) - (p->cost > q->cost);
+    }
+    return p->number - q->number;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RUN BATCH JOB //////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function runs one job on one thread and writes its result. A job that
+ * was cut short by the cancel flag isn't written, so it runs again when the
+ * batch is resumed.
+ */
+static int runBatchJob(int index, int thread, void* data){
+    batchRun* run = data;
+    batchJob* job = &run->jobs[index];
+    
+    if(run->cancel != NULL && *run->cancel != 0){
+        return(EXIT_FAILURE);
+    }
+    
+    //each job works on its own copies, so no two threads share a polygon
+    polygon* inside = copyPolygon(run->scene[job->inside-1]);
+    polygon* outside = copyPolygon(run->scene[job->outside-1]);
+    
+    //the jobs already use every processor, so each fit uses one thread. The
+    //seed is the job number, so a job gives the same result every run.
+    fitOptions* options = buildFitOptions((unsigned long)job->number, 1);
+    options->timeLimit = job->timeLimit;
+    options->cancel = run->cancel;
+    options->cache = run->cache;
+    
+    double start = getTimeSeconds();
+    transformation* t = findMinScaleWithTranslation(inside, outside, 
+            job->precision, job->iterations, options);
+    
+    int cancelled = (run->cancel != NULL && *run->cancel != 0);
+    
+    //the log has its own lock, so it is written to without holding the batch's
+    if(cancelled == 0 && run->log != NULL){
+        resultRecord record;
+        fillFitRecord(t, options, job->inside, job->outside,
+                getTimeSeconds() - start, &record);
+        writeResult(run->log, &record);
+    }
+    
+    pthread_mutex_lock(&run->lock);
+    if(cancelled == 0){
+        fprintf(run->output, "%d,%d,%d,%d,%d,%.10f,%.10f,%.10f,%.10f,%ld,%d\n",
+                job->number, job->inside, job->outside, job->precision,
+                job->iterations, t->scale, t->rotationZ, t->translation->x,
+                t->translation->y, options->evaluations, options->stopped);
+        //flush each result straight away, so it is kept if the run stops
+        fflush(run->output);
+        run->finished++;
+        printf("\r Finished %d of %d jobs.", run->finished, run->count);
+        fflush(stdout);
+    }
+    pthread_mutex_unlock(&run->lock);
+    
+    free(t->translation);
+    free(t);
+    free(options);
+    freePolygon(inside);
+    freePolygon(outside);
+    
+    return (cancelled == 0) ? (EXIT_SUCCESS) : (EXIT_FAILURE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RUN BATCH //////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function runs every job in the job file on the NULL-terminated list of
+ * polygons, writing the results to the output file. Threads is the number of
+ * jobs to run at once: 0 runs one for each processor.
+ * 
+ * If the output file already exists, the jobs it holds are skipped and the 
+ * new results are added to the end, after any record left cut short, which is
+ * run again. Otherwise it is created with a header 
+ * line. The columns are:
+ * 
+ *      job,inside,outside,precision,iterations,scale,rotation,x,y,
+ *      evaluations,stopped
+ * 
+ * where "stopped" is 1 if the job's time limit ran out before all of its
+ * iterations. Setting *cancel to anything but 0 (for example from Ctrl+C) 
+ * stops the batch, and the jobs not finished are left out of the file.
+ * 
+ * If log isn't NULL, each result is also added to it as a fit record (see
+ * results.c).
+ * 
+ * Returns EXIT_FAILURE if a file can't be opened or the batch was stopped.
+ */
+int runBatch(polygon* scene[], char* jobFilename, char* outputFilename, 
+        int threads, volatile int* cancel, struct resultSink* log){
+    FILE* jobFile = fopen(jobFilename, "rt");
+    if(jobFile == NULL){
+        printf(" Could not find job file %s.\n", jobFilename);
+        return(EXIT_FAILURE);
+    }
+    batchJob* jobs;
+    int count = readBatchJobs(jobFile, &jobs);
+    fclose(jobFile);
+    
+    //count the loaded polygons, to check the jobs against
+    int sceneCount = 0;
+    while(scene[sceneCount] != NULL){
+        sceneCount++;
+    }
+    
+    //find the jobs already finished in an earlier run
+    int maxNumber = 0, i;
+    for(i = 0; i < count; i++){
+        if(jobs[i].number > maxNumber){
+            maxNumber = jobs[i].number;
+        }
+    }
+    char* finished = calloc(maxNumber+1, sizeof(char));
+    int resumed = 0, torn;
+    FILE* output = fopen(outputFilename, "rt");
+    if(output != NULL){
+        resumed = readFinishedJobs(output, finished, maxNumber, &torn);
+        fclose(output);
+        output = fopen(outputFilename, "at");
+        //end a line left partly written when the earlier run was stopped, so
+        //the first new record doesn't run on from it
+        if(output != NULL && torn == 1){
+            fputc('\n', output);
+        }
+    }
+    else{
+        output = fopen(outputFilename, "wt");
+        if(output != NULL){
+            fprintf(output, "job,inside,outside,precision,iterations,scale,"
+                    "rotation,x,y,evaluations,stopped\n");
+        }
+    }
+    if(output == NULL){
+        printf(" Could not open output file %s.\n", outputFilename);
+        free(finished);
+        free(jobs);
+        return(EXIT_FAILURE);
+    }
+    
+    //keep the jobs still to run, and estimate how long each will take: every
+    //iteration runs the same angle search, which costs roughly the product of
+    //the two polygons' vertex counts
+    int toRun = 0;
+    for(i = 0; i < count; i++){
+        batchJob job = jobs[i];
+        if(finished[job.number] == 1){
+            continue;
+        }
+        if(job.inside < 1 || job.inside > sceneCount || 
+                job.outside < 1 || job.outside > sceneCount){
+            printf(" Job on line %d uses a polygon that isn't loaded, skipping"
+                    " it.\n", job.number);
+            continue;
+        }
+        int insideCount, outsideCount;
+        for(insideCount = 0; scene[job.inside-1]->vertices[insideCount] != NULL;
+                insideCount++);
+        for(outsideCount = 0; scene[job.outside-1]->vertices[outsideCount] != NULL;
+                outsideCount++);
+        job.cost = (double)(job.iterations+1)*insideCount*outsideCount*job.precision;
+        jobs[toRun] = job;
+        toRun++;
+    }
+    free(finished);
+    qsort(jobs, toRun, sizeof(batchJob), compareJobCosts);
+    
+    if(resumed > 0){
+        printf(" Resuming: %d jobs already finished in %s.\n", resumed, 
+                outputFilename);
+    }
+    printf(" Running %d jobs on %d threads.\n", toRun, 
+            (threads > 0) ? threads : getProcessorCount());
+    
+    batchRun run;
+    run.scene = scene;
+    run.jobs = jobs;
+    run.count = toRun;
+    run.output = output;
+    run.cache = buildScaleCache(100000);
+    run.cancel = cancel;
+    run.log = log;
+    run.finished = 0;
+    pthread_mutex_init(&run.lock, NULL);
+    
+    int result = parallelFor(toRun, (threads > 0) ? threads : getProcessorCount(),
+            runBatchJob, &run);
+    
+    printf("\n Wrote %d results to %s.\n", run.finished, outputFilename);
+    
+    pthread_mutex_destroy(&run.lock);
+    freeScaleCache(run.cache);
+    fclose(output);
+    free(jobs);
+    
+    return result;
+}
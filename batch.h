@@ -0,0 +1,38 @@
+/* 
+ * File:   batch.h
+ *
+ * This header file externalises the functions in the batch.c file, which runs
+ * a list of fits from a file without any input from the user.
+ * 
+ * For further details on any function, check there.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct batchJob{
+    int number;
+    int inside;
+    int outside;
+    int precision;
+    int iterations;
+    double timeLimit;
+    double cost;
+}batchJob;
+
+struct resultSink;
+
+int readBatchJobs(FILE* jobFile, batchJob** jobs);
+int runBatch(polygon* scene[], char* jobFilename, char* outputFilename, 
+        int threads, volatile int* cancel, struct resultSink* log);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BATCH_H */
+
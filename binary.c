@@ -0,0 +1,467 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          BINARY
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to read and write object files in binary
+ * form, and to convert files between text and binary.
+ *
+ * A binary file has no text to read: it holds the numbers themselves, laid out
+ * so they can be used where they are in a mapped file. It is made up of
+ *  > a header (see binaryHeader) giving the version of the format, how the
+ *    co-ordinates are stored, and how many polygons and vertices there are,
+ *  > a table of polygonCount+1 offsets (each a 64 bit whole number), where
+ *    polygon i has vertices offset[i] to offset[i+1]-1,
+ *  > every x co-ordinate, then every y co-ordinate, then (only if any vertex
+ *    isn't at z = 0) every z co-ordinate, each starting on a multiple of 8
+ *    bytes.
+ *
+ * Co-ordinates are stored as doubles, as floats (half the size, with about 7
+ * significant figures), or quantised (a quarter of the size). Quantised
+ * co-ordinates are 16 bit whole numbers q standing for origin + q*step on
+ * their axis, where the origin and step cover the range of all the vertices
+ * in 65535 steps, so each is within half a step of the original.
+ *
+ * Numbers are stored in the byte order of the computer writing them, which is
+ * checked when they are read.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "vector.h"
+#include "polygon.h"
+#include "parallel.h"
+#include "parser.h"
+#include "loader.h"
+#include "binary.h"
+
+//the version of the format written, which is the only version read
+#define BINARY_VERSION 1
+
+//a number whose bytes come out in a different order on a computer which
+//stores numbers the other way round
+#define BINARY_BYTE_ORDER 0x01020304u
+
+//the flag set when the file holds z co-ordinates
+#define BINARY_HAS_Z 1
+
+//the number of co-ordinates written at once
+#define WRITE_BLOCK_COUNT 4096
+
+//the number of ranges of polygons built for each thread
+#define RANGES_PER_THREAD 4
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BINARY HEADER TYPE DEFINITION //////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This struct is the start of every binary file. origin and step are only
+ * used by quantised files.
+ */
+typedef struct binaryHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t encoding;
+    uint32_t flags;
+    uint64_t polygonCount;
+    uint64_t vertexCount;
+    double origin[3];
+    double step[3];
+}binaryHeader;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BINARY LAYOUT TYPE DEFINITION //////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This struct holds where each part of a binary file is, in bytes from its
+ * start, and how long the whole file must be.
+ */
+typedef struct binaryLayout{
+    size_t size;
+    size_t offsets;
+    size_t columns[3];
+    size_t length;
+}binaryLayout;
+
+//the data needed to build one range of polygons from a file
+typedef struct binaryRange{
+    const binaryHeader* header;
+    const char* data;
+    binaryLayout* layout;
+    polygon** list;
+    int ranges;
+}binaryRange;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET CO-ORDINATE SIZE ///////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static size_t getCoordinateSize(int encoding){
+    if(encoding == BINARY_FLOAT){
+        return sizeof(float);
+    }
+    if(encoding == BINARY_QUANTISED){
+        return sizeof(uint16_t);
+    }
+    return sizeof(double);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET BINARY LAYOUT //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds where each part of a binary file with the given header
+ * is. Columns which aren't in the file are given the position 0.
+ */
+static int getBinaryLayout(const binaryHeader* h, binaryLayout* layout){
+    layout->size = getCoordinateSize(h->encoding);
+    layout->offsets = sizeof(binaryHeader);
+    size_t position = layout->offsets + sizeof(uint64_t)*(h->polygonCount+1);
+    int axis;
+    for(axis = 0; axis < 3; axis++){
+        if(axis == 2 && (h->flags & BINARY_HAS_Z) == 0){
+            layout->columns[axis] = 0;
+            continue;
+        }
+        position = (position + 7)/8*8;
+        layout->columns[axis] = position;
+        position += layout->size*h->vertexCount;
+    }
+    layout->length = position;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CHECK BINARY OBJECT FILE ///////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function returns 1 if some data starts as a binary object file does,
+ * or 0 if it must be text.
+ */
+int checkBinaryObjectFile(const char* data, size_t length){
+    size_t magicLength = sizeof(BINARY_MAGIC) - 1;
+    return length >= magicLength && memcmp(data, BINARY_MAGIC, magicLength) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SET BINARY ERROR ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* Problems with binary files aren't on any line, so are given line -1.
+ */
+static polygon** setBinaryError(parseError* error, int* count,
+        const char* message){
+    error->line = -1;
+    error->column = -1;
+    snprintf(error->message, sizeof(error->message), "%s", message);
+    *count = 0;
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ CO-ORDINATE ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function returns co-ordinate i of the column of a file on one axis.
+ */
+static double readCoordinate(const binaryHeader* h, const char* column,
+        int axis, uint64_t i){
+    if(column == NULL){
+        return 0;
+    }
+    if(h->encoding == BINARY_FLOAT){
+        return ((const float*)column)[i];
+    }
+    if(h->encoding == BINARY_QUANTISED){
+        return h->origin[axis] + h->step[axis]*((const uint16_t*)column)[i];
+    }
+    return ((const double*)column)[i];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD RANGE ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function is the job run by readBinaryPolygons for each range of
+ * polygons: it builds them straight from the columns into their places in
+ * the list.
+ */
+static int buildRange(int index, int thread, void* data){
+    binaryRange* range = (binaryRange*)data;
+    const binaryHeader* h = range->header;
+    const uint64_t* offsets =
+            (const uint64_t*)(range->data + range->layout->offsets);
+    const char* columns[3];
+    int axis;
+    for(axis = 0; axis < 3; axis++){
+        columns[axis] = (range->layout->columns[axis] == 0) ? NULL :
+                range->data + range->layout->columns[axis];
+    }
+
+    uint64_t first = h->polygonCount*index/range->ranges;
+    uint64_t last = h->polygonCount*(index+1)/range->ranges;
+    int capacity = 64;
+    vector** vertices = malloc(sizeof(vector*)*capacity);
+    uint64_t i;
+    int j;
+    for(i = first; i < last; i++){
+        int n = (int)(offsets[i+1] - offsets[i]);
+        if(n+1 > capacity){
+            capacity = n+1;
+            vertices = realloc(vertices, sizeof(vector*)*capacity);
+        }
+        for(j = 0; j < n; j++){
+            uint64_t v = offsets[i] + j;
+            vertices[j] = createVector(readCoordinate(h, columns[0], 0, v),
+                    readCoordinate(h, columns[1], 1, v),
+                    readCoordinate(h, columns[2], 2, v));
+        }
+        vertices[n] = NULL;
+        range->list[i] = buildPolygon(vertices);
+    }
+    free(vertices);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ BINARY POLYGONS ///////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads every polygon from the whole of a binary object file in
+ * memory, and returns them as a NULL-terminated list, with the number read
+ * stored in count.
+ *
+ * The whole file is checked before anything is built: its header, that it is
+ * long enough, and that every polygon has at least three vertices. There is
+ * nothing to parse, so the polygons are then built straight from the columns,
+ * in ranges spread across the given number of threads.
+ *
+ * If the file isn't in the right form, NULL is returned and the problem is
+ * stored in error, with line -1.
+ */
+polygon** readBinaryPolygons(const char* data, size_t length, int threads,
+        int* count, parseError* error){
+    if(length < sizeof(binaryHeader) || !checkBinaryObjectFile(data, length)){
+        return setBinaryError(error, count, "not a binary object file");
+    }
+
+    //mapped files start on a page, so the header can be used where it is
+    const binaryHeader* h = (const binaryHeader*)data;
+    if(h->byteOrder != BINARY_BYTE_ORDER){
+        return setBinaryError(error, count,
+                "written on a computer with a different byte order");
+    }
+    if(h->version != BINARY_VERSION){
+        return setBinaryError(error, count, "unknown binary format version");
+    }
+    if(h->encoding != BINARY_DOUBLE && h->encoding != BINARY_FLOAT &&
+            h->encoding != BINARY_QUANTISED){
+        return setBinaryError(error, count, "unknown co-ordinate encoding");
+    }
+    //a file can't hold more polygons or vertices than it has bytes, which
+    //keeps the sizes worked out from the counts from overflowing
+    if(h->polygonCount >= INT32_MAX || h->polygonCount > length ||
+            h->vertexCount > length){
+        return setBinaryError(error, count, "file is shorter than its header says");
+    }
+
+    binaryLayout layout;
+    getBinaryLayout(h, &layout);
+    if(length < layout.length){
+        return setBinaryError(error, count, "file is shorter than its header says");
+    }
+
+    const uint64_t* offsets = (const uint64_t*)(data + layout.offsets);
+    uint64_t i;
+    if(offsets[0] != 0 || offsets[h->polygonCount] != h->vertexCount){
+        return setBinaryError(error, count, "polygon offsets don't match the vertices");
+    }
+    for(i = 0; i < h->polygonCount; i++){
+        if(offsets[i+1] < offsets[i] + 3 || offsets[i+1] > h->vertexCount ||
+                offsets[i+1] - offsets[i] >= INT32_MAX){
+            return setBinaryError(error, count,
+                    "a polygon needs at least three vertices");
+        }
+    }
+
+    binaryRange range;
+    range.header = h;
+    range.data = data;
+    range.layout = &layout;
+    range.list = malloc(sizeof(polygon*)*(h->polygonCount+1));
+    range.list[h->polygonCount] = NULL;
+    range.ranges = (threads > 1) ? threads*RANGES_PER_THREAD : 1;
+    if(range.ranges > h->polygonCount){
+        range.ranges = (h->polygonCount > 0) ? (int)h->polygonCount : 1;
+    }
+    parallelFor(range.ranges, threads, buildRange, &range);
+
+    *count = (int)h->polygonCount;
+    return range.list;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET VERTEX COORDINATE //////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static double getVertexCoordinate(vector* v, int axis){
+    if(axis == 0){
+        return v->x;
+    }
+    if(axis == 1){
+        return v->y;
+    }
+    return v->z;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// WRITE COLUMN ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function writes every co-ordinate on one axis, in order, padded to
+ * start on a multiple of 8 bytes. written is the number of bytes written to
+ * the file so far, and is moved on.
+ */
+static int writeColumn(FILE* file, polygon** list, binaryHeader* h, int axis,
+        size_t* written){
+    static const char padding[8] = {0};
+    size_t pad = (8 - *written%8)%8;
+    fwrite(padding, 1, pad, file);
+    *written += pad;
+
+    size_t size = getCoordinateSize(h->encoding);
+    char* block = malloc(size*WRITE_BLOCK_COUNT);
+    int used = 0;
+    int i, j;
+    for(i = 0; list[i] != NULL; i++){
+        for(j = 0; list[i]->vertices[j] != NULL; j++){
+            double value = getVertexCoordinate(list[i]->vertices[j], axis);
+            if(h->encoding == BINARY_FLOAT){
+                ((float*)block)[used] = (float)value;
+            }
+            else if(h->encoding == BINARY_QUANTISED){
+                double q = 0;
+                if(h->step[axis] > 0){
+                    q = floor((value - h->origin[axis])/h->step[axis] + 0.5);
+                }
+                ((uint16_t*)block)[used] = (uint16_t)fmin(fmax(q, 0), 65535);
+            }
+            else{
+                ((double*)block)[used] = value;
+            }
+            used++;
+            if(used == WRITE_BLOCK_COUNT){
+                fwrite(block, size, used, file);
+                used = 0;
+            }
+        }
+    }
+    fwrite(block, size, used, file);
+    *written += size*h->vertexCount;
+    free(block);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// WRITE BINARY POLYGONS //////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function writes a NULL-terminated list of polygons to a file (opened
+ * for binary writing) as a binary object file, with its co-ordinates stored
+ * with the given encoding: BINARY_DOUBLE, BINARY_FLOAT or BINARY_QUANTISED.
+ *
+ * The z co-ordinates are only written if any of them isn't 0.
+ *
+ * Returns EXIT_FAILURE if the file couldn't be written.
+ */
+int writeBinaryPolygons(FILE* file, polygon** list, int encoding){
+    binaryHeader h;
+    memset(&h, 0, sizeof(binaryHeader));
+    memcpy(h.magic, BINARY_MAGIC, sizeof(h.magic));
+    h.version = BINARY_VERSION;
+    h.byteOrder = BINARY_BYTE_ORDER;
+    h.encoding = encoding;
+
+    //count the polygons and vertices, and find the range on each axis
+    double min[3] = {0, 0, 0}, max[3] = {0, 0, 0};
+    int i, j, axis;
+    for(i = 0; list[i] != NULL; i++){
+        for(j = 0; list[i]->vertices[j] != NULL; j++){
+            for(axis = 0; axis < 3; axis++){
+                double value = getVertexCoordinate(list[i]->vertices[j], axis);
+                if(h.vertexCount == 0 || value < min[axis]){
+                    min[axis] = value;
+                }
+                if(h.vertexCount == 0 || value > max[axis]){
+                    max[axis] = value;
+                }
+            }
+            if(list[i]->vertices[j]->z != 0){
+                h.flags |= BINARY_HAS_Z;
+            }
+            h.vertexCount++;
+        }
+        h.polygonCount++;
+    }
+    for(axis = 0; axis < 3; axis++){
+        h.origin[axis] = min[axis];
+        h.step[axis] = (max[axis] - min[axis])/65535;
+    }
+
+    size_t written = fwrite(&h, 1, sizeof(binaryHeader), file);
+
+    //the offset table
+    uint64_t offset = 0;
+    fwrite(&offset, sizeof(uint64_t), 1, file);
+    for(i = 0; list[i] != NULL; i++){
+        for(j = 0; list[i]->vertices[j] != NULL; j++){
+            offset++;
+        }
+        fwrite(&offset, sizeof(uint64_t), 1, file);
+    }
+    written += sizeof(uint64_t)*(h.polygonCount+1);
+
+    for(axis = 0; axis < 3; axis++){
+        if(axis < 2 || (h.flags & BINARY_HAS_Z)){
+            writeColumn(file, list, &h, axis, &written);
+        }
+    }
+
+    if(ferror(file)){
+        return(EXIT_FAILURE);
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CONVERT OBJECT FILE ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads an object file, text or binary, and writes its polygons
+ * to another in the given form: OBJECT_TEXT, or one of the binary encodings.
+ *
+ * If the file can't be read, or the other can't be written, the problem is
+ * stored in error (as for loadPolygons, with line 0 if a file couldn't be
+ * opened) and EXIT_FAILURE is returned.
+ */
+int convertObjectFile(const char* from, const char* to, int format,
+        parseError* error){
+    int count;
+    polygon** list = readObjectFile(from, &count, error);
+    if(list == NULL){
+        return(EXIT_FAILURE);
+    }
+
+    FILE* file = fopen(to, (format == OBJECT_TEXT) ? "w" : "wb");
+    int result = EXIT_FAILURE;
+    if(file != NULL){
+        if(format == OBJECT_TEXT){
+            result = writePolygons(file, list);
+        }
+        else{
+            result = writeBinaryPolygons(file, list, format);
+        }
+        if(fclose(file) != 0){
+            result = EXIT_FAILURE;
+        }
+    }
+    if(result != EXIT_SUCCESS){
+        error->line = 0;
+        error->column = 0;
+        snprintf(error->message, sizeof(error->message),
+                "could not write the file");
+    }
+
+    freePolygonList(list);
+    return result;
+}
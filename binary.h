@@ -0,0 +1,39 @@
+/*
+ * File:   binary.h
+ *
+ * This header file externalises the functions in the binary.c file, which
+ * reads and writes object files in binary form.
+ *
+ * For further details on any function, check there.
+ */
+
+#ifndef BINARY_H
+#define BINARY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//the first 8 bytes of every binary object file. The first can't start a text
+//file, and the line endings show if the file has been changed as text
+#define BINARY_MAGIC "\x89PGN\r\n\x1a\n"
+
+//the forms an object file can be written in
+#define OBJECT_TEXT 0
+#define BINARY_DOUBLE 1
+#define BINARY_FLOAT 2
+#define BINARY_QUANTISED 3
+
+int checkBinaryObjectFile(const char* data, size_t length);
+polygon** readBinaryPolygons(const char* data, size_t length, int threads,
+        int* count, parseError* error);
+int writeBinaryPolygons(FILE* file, polygon** list, int encoding);
+int convertObjectFile(const char* from, const char* to, int format,
+        parseError* error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BINARY_H */
+
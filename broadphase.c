@@ -0,0 +1,400 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          BROADPHASE
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the "broadphase" for collision checks: a quick way to find
+ * which polygons are near enough to each other to possibly collide, so that the
+ * full collision check only has to be run on those pairs.
+ * 
+ * Each polygon is stored by its bounding box in a uniform grid. The grid is 
+ * split into square cells, and each polygon is listed in every cell its box
+ * covers. Finding what is near an area only looks at the cells the area
+ * covers, however many polygons there are in total, or at the cells stored if
+ * there are fewer. Only cells with something in them are stored, in a hash
+ * table, so the grid has no fixed size.
+ * 
+ * Objects are known by an integer id (such as their index in a list of 
+ * polygons) and can be added, moved and removed one at a time.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vector.h"
+#include "polygon.h"
+#include "broadphase.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GRID TYPE DEFINITIONS //////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* A gridCell holds the ids of the objects in one cell, and links to the next
+ * cell in the same hash bucket. A gridObject remembers the box an object was 
+ * stored with, so it can be found again to be moved or removed.
+ */
+typedef struct gridCell{
+    long long x;
+    long long y;
+    int* ids;
+    int count;
+    int capacity;
+    struct gridCell* next;
+}gridCell;
+
+typedef struct gridObject{
+    bounds box;
+    int inGrid;
+}gridObject;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CHECK BOUNDS OVERLAP ///////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function checks whether two bounding boxes overlap. It returns 1 if they
+ * do (including if they touch) and 0 if there is a gap between them, in which
+ * case the polygons inside them can't collide.
+ */
+int checkBoundsOverlap(bounds* a, bounds* b){
+    if(a->maxX < b->minX || b->maxX < a->minX ||
+       a->maxY < b->minY || b->maxY < a->minY){
+        return 0;
+    }
+    return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD SPATIAL GRID /////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function creates an empty grid with the given cell size. A cell size a
+ * little larger than a typical polygon works best.
+ */
+spatialGrid* buildSpatialGrid(double cellSize){
+    spatialGrid* g = malloc(sizeof(spatialGrid));
+    
+    g->cellSize = (cellSize > 0) ? cellSize : 1.0;
+    g->bucketCount = 1024;
+    g->buckets = calloc(g->bucketCount, sizeof(gridCell*));
+    g->cellCount = 0;
+    g->objects = NULL;
+    g->objectCapacity = 0;
+    
+    return g;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET GRID CELL SIZE /////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds a cell size for a grid of the given boxes: the average
+ * of their widths and heights, so cells are about the size of a typical 
+ * polygon. Returns 1 if there are no boxes, or they have no size.
+ */
+double getGridCellSize(bounds* boxes, int count){
+    double size = 0;
+    int i;
+    for(i = 0; i < count; i++){
+        size += (boxes[i].maxX - boxes[i].minX) + 
+                (boxes[i].maxY - boxes[i].minY);
+    }
+    size = (count > 0) ? size/(2*count) : 0;
+    return (size > 0) ? size : 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD GRID OF BOXES ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function creates a grid sized for the given boxes (see 
+ * getGridCellSize) and adds each of them, with the ids firstId onwards in 
+ * order.
+ */
+spatialGrid* buildGridOfBoxes(bounds* boxes, int count, int firstId){
+    spatialGrid* g = buildSpatialGrid(getGridCellSize(boxes, count));
+    int i;
+    for(i = 0; i < count; i++){
+        gridInsert(g, firstId + i, &boxes[i]);
+    }
+    return g;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FIND CELL //////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* These functions find the cell at grid position x, y. getCell returns NULL if
+ * the cell is empty, and makeCell creates it if so, growing the hash table when
+ * it gets crowded.
+ */
+static int hashCell(long long x, long long y, int bucketCount){
+    unsigned long long h = (unsigned long long)x * 73856093ULL ^ 
+                           (unsigned long long)y * 19349663ULL;
+    return (int)(h & (unsigned long long)(bucketCount - 1));
+}
+
+static gridCell* getCell(spatialGrid* g, long long x, long long y){
+    gridCell* c = g->buckets[hashCell(x, y, g->bucketCount)];
+    while(c != NULL && (c->x != x || c->y != y)){
+        c = c->next;
+    }
+    return c;
+}
+
+static gridCell* makeCell(spatialGrid* g, long long x, long long y){
+    gridCell* c = getCell(g, x, y);
+    if(c != NULL){
+        return c;
+    }
+    
+    //if there are more cells than buckets, double the buckets and move every
+    //cell into its new bucket
+    if(g->cellCount >= g->bucketCount){
+        int newCount = g->bucketCount*2;
+        gridCell** newBuckets = calloc(newCount, sizeof(gridCell*));
+        int i;
+        for(i = 0; i < g->bucketCount; i++){
+            gridCell* move = g->buckets[i];
+            while(move != NULL){
+                gridCell* next = move->next;
+                int h = hashCell(move->x, move->y, newCount);
+                move->next = newBuckets[h];
+                newBuckets[h] = move;
+                move = next;
+            }
+        }
+        free(g->buckets);
+        g->buckets = newBuckets;
+        g->bucketCount = newCount;
+    }
+    
+    c = malloc(sizeof(gridCell));
+    c->x = x;
+    c->y = y;
+    c->count = 0;
+    c->capacity = 4;
+    c->ids = malloc(sizeof(int)*c->capacity);
+    
+    int h = hashCell(x, y, g->bucketCount);
+    c->next = g->buckets[h];
+    g->buckets[h] = c;
+    g->cellCount++;
+    
+    return c;
+}
+
+/* This function finds the range of cells a box covers.
+ */
+static int getCellRange(spatialGrid* g, bounds* b, long long* minX, 
+        long long* minY, long long* maxX, long long* maxY){
+    *minX = (long long)floor(b->minX / g->cellSize);
+    *minY = (long long)floor(b->minY / g->cellSize);
+    *maxX = (long long)floor(b->maxX / g->cellSize);
+    *maxY = (long long)floor(b->maxY / g->cellSize);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GRID INSERT ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function adds an object with the given id and bounding box to the grid.
+ * Ids should be small non-negative integers, as a slot is kept for every id up
+ * to the largest. If the id is already in the grid it is moved instead.
+ */
+int gridInsert(spatialGrid* g, int id, bounds* b){
+    if(id < 0){
+        return(EXIT_FAILURE);
+    }
+    
+    //make room for this id
+    if(id >= g->objectCapacity){
+        int newCapacity = (g->objectCapacity > 0) ? g->objectCapacity : 16;
+        while(newCapacity <= id){
+            newCapacity = newCapacity*2;
+        }
+        g->objects = realloc(g->objects, sizeof(gridObject)*newCapacity);
+        int i;
+        for(i = g->objectCapacity; i < newCapacity; i++){
+            g->objects[i].inGrid = 0;
+        }
+        g->objectCapacity = newCapacity;
+    }
+    if(g->objects[id].inGrid == 1){
+        return gridUpdate(g, id, b);
+    }
+    
+    //add the id to every cell the box covers
+    long long minX, minY, maxX, maxY, x, y;
+    getCellRange(g, b, &minX, &minY, &maxX, &maxY);
+    for(x = minX; x <= maxX; x++){
+        for(y = minY; y <= maxY; y++){
+            gridCell* c = makeCell(g, x, y);
+            if(c->count == c->capacity){
+                c->capacity = c->capacity*2;
+                c->ids = realloc(c->ids, sizeof(int)*c->capacity);
+            }
+            c->ids[c->count] = id;
+            c->count++;
+        }
+    }
+    
+    g->objects[id].box = *b;
+    g->objects[id].inGrid = 1;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GRID REMOVE ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function removes the object with the given id from the grid. Cells that
+ * are left empty are kept, as something is likely to move into them again.
+ */
+int gridRemove(spatialGrid* g, int id){
+    if(id < 0 || id >= g->objectCapacity || g->objects[id].inGrid == 0){
+        return(EXIT_FAILURE);
+    }
+    
+    long long minX, minY, maxX, maxY, x, y;
+    getCellRange(g, &g->objects[id].box, &minX, &minY, &maxX, &maxY);
+    for(x = minX; x <= maxX; x++){
+        for(y = minY; y <= maxY; y++){
+            gridCell* c = getCell(g, x, y);
+            if(c == NULL){
+                continue;
+            }
+            //swap the id with the last in the cell, and drop the last
+            int i;
+            for(i = 0; i < c->count; i++){
+                if(c->ids[i] == id){
+                    c->ids[i] = c->ids[c->count-1];
+                    c->count--;
+                    break;
+                }
+            }
+        }
+    }
+    
+    g->objects[id].inGrid = 0;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GRID UPDATE ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function moves an object to a new bounding box. If it still covers the
+ * same cells only its stored box changes, so small moves are very cheap.
+ */
+int gridUpdate(spatialGrid* g, int id, bounds* b){
+    if(id < 0 || id >= g->objectCapacity || g->objects[id].inGrid == 0){
+        return gridInsert(g, id, b);
+    }
+    
+    long long oldMinX, oldMinY, oldMaxX, oldMaxY;
+    long long newMinX, newMinY, newMaxX, newMaxY;
+    getCellRange(g, &g->objects[id].box, &oldMinX, &oldMinY, &oldMaxX, &oldMaxY);
+    getCellRange(g, b, &newMinX, &newMinY, &newMaxX, &newMaxY);
+    
+    if(oldMinX == newMinX && oldMinY == newMinY && 
+            oldMaxX == newMaxX && oldMaxY == newMaxY){
+        g->objects[id].box = *b;
+        return(EXIT_SUCCESS);
+    }
+    
+    gridRemove(g, id);
+    return gridInsert(g, id, b);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GRID QUERY /////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds every object whose bounding box overlaps the given box.
+ * Their ids are put in *results, which is grown with realloc as needed 
+ * (*capacity is its size, and it may start as NULL with a capacity of 0). The
+ * number of ids found is returned, and each id is only listed once.
+ * 
+ * A box covering more cells than the grid holds is answered from the cells
+ * held instead, so even a box much larger than everything in the grid costs
+ * no more than looking at every cell once.
+ * 
+ * The grid isn't changed, so several threads can query it at once.
+ */
+static int queryCell(spatialGrid* g, gridCell* c, bounds* b, long long minX,
+        long long minY, int** results, int* capacity, int found){
+    int i;
+    for(i = 0; i < c->count; i++){
+        int id = c->ids[i];
+        bounds* box = &g->objects[id].box;
+        if(checkBoundsOverlap(box, b) == 0){
+            continue;
+        }
+        
+        //an object in several of these cells is only reported from the first
+        //cell it shares with the query, so it is only listed once
+        long long boxMinX, boxMinY, boxMaxX, boxMaxY;
+        getCellRange(g, box, &boxMinX, &boxMinY, &boxMaxX, &boxMaxY);
+        long long firstX = (boxMinX > minX) ? boxMinX : minX;
+        long long firstY = (boxMinY > minY) ? boxMinY : minY;
+        if(c->x != firstX || c->y != firstY){
+            continue;
+        }
+        
+        if(found == *capacity){
+            *capacity = (*capacity > 0) ? *capacity*2 : 16;
+            *results = realloc(*results, sizeof(int)*(*capacity));
+        }
+        (*results)[found] = id;
+        found++;
+    }
+    return found;
+}
+
+int gridQuery(spatialGrid* g, bounds* b, int** results, int* capacity){
+    int found = 0;
+    long long minX, minY, maxX, maxY, x, y;
+    getCellRange(g, b, &minX, &minY, &maxX, &maxY);
+    
+    //the number of cells covered is worked out in doubles, as it can be far
+    //too many to count
+    double covered = ((double)maxX - minX + 1)*((double)maxY - minY + 1);
+    if(covered > g->cellCount){
+        int i;
+        for(i = 0; i < g->bucketCount; i++){
+            gridCell* c;
+            for(c = g->buckets[i]; c != NULL; c = c->next){
+                if(c->x >= minX && c->x <= maxX && c->y >= minY && 
+                        c->y <= maxY){
+                    found = queryCell(g, c, b, minX, minY, results, capacity,
+                            found);
+                }
+            }
+        }
+        return found;
+    }
+    
+    for(x = minX; x <= maxX; x++){
+        for(y = minY; y <= maxY; y++){
+            gridCell* c = getCell(g, x, y);
+            if(c != NULL){
+                found = queryCell(g, c, b, minX, minY, results, capacity, 
+                        found);
+            }
+        }
+    }
+    return found;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FREE SPATIAL GRID //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function frees a grid and all of its cells.
+ */
+int freeSpatialGrid(spatialGrid* g){
+    int i;
+    for(i = 0; i < g->bucketCount; i++){
+        gridCell* c = g->buckets[i];
+        while(c != NULL){
+            gridCell* next = c->next;
+            free(c->ids);
+            free(c);
+            c = next;
+        }
+    }
+    free(g->buckets);
+    free(g->objects);
+    free(g);
+    return(EXIT_SUCCESS);
+}
@@ -0,0 +1,44 @@
+/* 
+ * File:   broadphase.h
+ *
+ * This header file externalises the functions in the broadphase.c file, which
+ * quickly finds the polygons near to an area before they are checked fully.
+ * 
+ * For further details on any function, check there.
+ */
+
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct gridCell;
+struct gridObject;
+
+typedef struct spatialGrid{
+    double cellSize;
+    struct gridCell** buckets;
+    int bucketCount;
+    int cellCount;
+    struct gridObject* objects;
+    int objectCapacity;
+}spatialGrid;
+
+int checkBoundsOverlap(bounds* a, bounds* b);
+spatialGrid* buildSpatialGrid(double cellSize);
+double getGridCellSize(bounds* boxes, int count);
+spatialGrid* buildGridOfBoxes(bounds* boxes, int count, int firstId);
+int gridInsert(spatialGrid* g, int id, bounds* b);
+int gridRemove(spatialGrid* g, int id);
+int gridUpdate(spatialGrid* g, int id, bounds* b);
+int gridQuery(spatialGrid* g, bounds* b, int** results, int* capacity);
+int freeSpatialGrid(spatialGrid* g);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BROADPHASE_H */
+
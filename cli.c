@@ -0,0 +1,786 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          COMMAND LINE
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to run the program from the command line,
+ * without the menu, so that it can be used from scripts.
+ *
+ * The first argument names a command, which mirrors one of the menu options:
+ *
+ *      load FILE                   describe every polygon in the file
+ *      collide FILE A B            check whether polygons A and B collide
+ *      collide-all FILE            list every pair of polygons which collide
+ *      contain FILE INSIDE BOUND   check whether INSIDE is inside BOUND
+ *      fit FILE INSIDE OUTSIDE     find the smallest scale of OUTSIDE which
+ *                                  still contains INSIDE
+ *      export FILE OUTPUT          draw the polygons as an HTML page
+ *      convert FILE OUTPUT         save the file as text or binary
+ *      serve FILE                  answer questions about the polygons until
+ *                                  stopped (see server.c)
+ *      simulate FILE FRAMES        move the polygons by their velocities for
+ *                                  a number of steps, finding what touches
+ *                                  after each (see simulation.c)
+ *
+ * followed by any options, each written as --name value:
+ *
+ *      --hull                      use the hull of concave polygons instead of
+ *                                  splitting them (takes no value)
+ *      --precision, --iterations, --time, --seed, --threads   for fit
+ *      --width, --height           for export, in pixels
+ *      --view all|MINX,MINY,MAXX,MAXY
+ *                                  for export, the area drawn (the canvas
+ *                                  area as it is by default)
+ *      --detail PIXELS             for export, the smallest detail drawn
+ *      --format text|double|float|quantised                   for convert
+ *      --socket PATH               for serve, to take connections to a Unix
+ *                                  socket instead of reading the standard input
+ *      --results FILE              for collide, collide-all, contain and fit,
+ *                                  to also write each result as a record, with
+ *                                  its timing, as CSV or JSON Lines (see
+ *                                  results.c)
+ *      --motion FILE               for simulate, the velocities of the bodies
+ *                                  (all are still without it)
+ *      --step SECONDS              for simulate, the time each step covers
+ *      --budget SECONDS            for simulate, the time a step may take
+ *                                  before its remaining checks are skipped
+ *      --contacts FILE             for simulate, to write every contact of
+ *                                  every step as CSV
+ *
+ * Polygons are numbered from 1, as in the menu. Nothing is ever asked for.
+ * Results are written to the standard output as CSV, with a header line, and
+ * problems to the standard error. The program then exits with one of the
+ * CLI_ codes below, so scripts can act on the result without reading it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "vector.h"
+#include "polygon.h"
+#include "collision.h"
+#include "broadphase.h"
+#include "hull.h"
+#include "decompose.h"
+#include "lod.h"
+#include "distance.h"
+#include "sampler.h"
+#include "applications.h"
+#include "parallel.h"
+#include "parser.h"
+#include "loader.h"
+#include "binary.h"
+#include "menu.h"
+#include "export.h"
+#include "server.h"
+#include "results.h"
+#include "simulation.h"
+#include "cli.h"
+
+//the exit codes. CLI_FOUND means a collision was found, or an object isn't
+//inside its bound
+#define CLI_SUCCESS 0
+#define CLI_FOUND 1
+#define CLI_USAGE 2
+#define CLI_FILE 3
+
+//the areas an export can draw: the canvas as it is, every polygon, or the
+//area given
+#define CLI_VIEW_CANVAS 0
+#define CLI_VIEW_ALL 1
+#define CLI_VIEW_AREA 2
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// COMMAND LINE TYPE DEFINITIONS //////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* cliOptions holds the options given after a command, with their defaults.
+ * cliCommand describes a command: its name, how many arguments it takes after
+ * the file, and the function that runs it once the file is loaded.
+ */
+typedef struct cliOptions{
+    int hull;
+    int precision;
+    int iterations;
+    double timeLimit;
+    unsigned long seed;
+    int threads;
+    int width;
+    int height;
+    int view;
+    bounds area;
+    double detail;
+    int format;
+    const char* socketPath;
+    const char* resultsPath;
+    struct resultSink* results;
+    const char* motionPath;
+    const char* contactsPath;
+    double step;
+    double budget;
+}cliOptions;
+
+typedef int (*cliRun)(polygon** list, int count, char** arguments,
+        cliOptions* options);
+
+typedef struct cliCommand{
+    const char* name;
+    int arguments;
+    int loads;
+    cliRun run;
+}cliCommand;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// PRINT USAGE ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static int printUsage(const char* program){
+    fprintf(stderr,
+            "Usage: %s COMMAND FILE [ARGUMENTS] [OPTIONS]\n"
+            "Commands:\n"
+            "  load FILE                   describe every polygon\n"
+            "  collide FILE A B            check if polygons A and B collide\n"
+            "  collide-all FILE            list every pair which collides\n"
+            "  contain FILE INSIDE BOUND   check if INSIDE is inside BOUND\n"
+            "  fit FILE INSIDE OUTSIDE     shrink OUTSIDE to fit around INSIDE\n"
+            "  export FILE OUTPUT          draw the polygons as an HTML page\n"
+            "  convert FILE OUTPUT         save the file as text or binary\n"
+            "  serve FILE                  answer questions until stopped\n"
+            "  simulate FILE FRAMES        move the polygons for FRAMES steps\n"
+            "Options:\n"
+            "  --hull                      use hulls of concave polygons\n"
+            "  --precision N               decimal places of a fit (1-8, 4)\n"
+            "  --iterations N              positions tried by a fit (1000)\n"
+            "  --time SECONDS              time limit of a fit (0, none)\n"
+            "  --seed N                    seed of a fit (random)\n"
+            "  --threads N                 threads of a fit (0, all)\n"
+            "  --width N, --height N       size of an export (800)\n"
+            "  --view all|X0,Y0,X1,Y1      area of an export (the canvas)\n"
+            "  --detail PIXELS             smallest detail exported (0.5)\n"
+            "  --format F                  text, double, float or quantised\n"
+            "  --socket PATH               serve on a Unix socket (stdin)\n"
+            "  --results FILE              also log results (.csv or .jsonl)\n"
+            "  --motion FILE               velocities of a simulation (none)\n"
+            "  --step SECONDS              time of a simulation step (1/60)\n"
+            "  --budget SECONDS            time allowed for a step (0, none)\n"
+            "  --contacts FILE             write a simulation's contacts\n"
+            "Exit codes: 0 success, 1 collision found or not inside,\n"
+            "            2 bad arguments, 3 file not read or written.\n",
+            program);
+    return(CLI_USAGE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ WHOLE NUMBER //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* These functions read an argument as a number, returning EXIT_FAILURE if the
+ * whole argument isn't one or it is below the given minimum.
+ */
+static int readWholeNumber(const char* text, long minimum, long* value){
+    char* end;
+    *value = strtol(text, &end, 10);
+    if(end == text || *end != '\0' || *value < minimum){
+        return(EXIT_FAILURE);
+    }
+    return(EXIT_SUCCESS);
+}
+
+static int readDecimalNumber(const char* text, double minimum, double* value){
+    char* end;
+    *value = strtod(text, &end);
+    if(end == text || *end != '\0' || !(*value >= minimum)){
+        return(EXIT_FAILURE);
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ OPTIONS ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads the options from the arguments, and moves the other
+ * arguments to the front of the list, in order. It returns the number of other
+ * arguments, or -1 if an option is unknown or its value can't be read.
+ */
+static int readOptions(int argc, char** argv, cliOptions* options){
+    int positional = 0;
+    int i;
+    for(i = 0; i < argc; i++){
+        const char* name = argv[i];
+        if(strncmp(name, "--", 2) != 0){
+            argv[positional] = argv[i];
+            positional++;
+            continue;
+        }
+        name += 2;
+        if(strcmp(name, "hull") == 0){
+            options->hull = 1;
+            continue;
+        }
+        if(i+1 >= argc){
+            fprintf(stderr, "error: --%s needs a value\n", name);
+            return -1;
+        }
+        const char* value = argv[++i];
+        long number = 0;
+        int result = EXIT_SUCCESS;
+        if(strcmp(name, "precision") == 0){
+            result = readWholeNumber(value, 1, &number);
+            if(number > 8){
+                result = EXIT_FAILURE;
+            }
+            options->precision = (int)number;
+        }
+        else if(strcmp(name, "iterations") == 0){
+            result = readWholeNumber(value, 1, &number);
+            options->iterations = (int)number;
+        }
+        else if(strcmp(name, "time") == 0){
+            result = readDecimalNumber(value, 0, &options->timeLimit);
+        }
+        else if(strcmp(name, "seed") == 0){
+            result = readWholeNumber(value, 0, &number);
+            options->seed = (unsigned long)number;
+        }
+        else if(strcmp(name, "threads") == 0){
+            result = readWholeNumber(value, 0, &number);
+            options->threads = (int)number;
+        }
+        else if(strcmp(name, "width") == 0){
+            result = readWholeNumber(value, 1, &number);
+            options->width = (int)number;
+        }
+        else if(strcmp(name, "height") == 0){
+            result = readWholeNumber(value, 1, &number);
+            options->height = (int)number;
+        }
+        else if(strcmp(name, "view") == 0){
+            if(strcmp(value, "all") == 0){
+                options->view = CLI_VIEW_ALL;
+            }
+            else if(sscanf(value, "%lf,%lf,%lf,%lf", &options->area.minX,
+                    &options->area.minY, &options->area.maxX,
+                    &options->area.maxY) == 4 &&
+                    options->area.maxX > options->area.minX &&
+                    options->area.maxY > options->area.minY){
+                options->view = CLI_VIEW_AREA;
+            }
+            else{
+                result = EXIT_FAILURE;
+            }
+        }
+        else if(strcmp(name, "detail") == 0){
+            result = readDecimalNumber(value, 0, &options->detail);
+        }
+        else if(strcmp(name, "socket") == 0){
+            options->socketPath = value;
+        }
+        else if(strcmp(name, "results") == 0){
+            options->resultsPath = value;
+        }
+        else if(strcmp(name, "motion") == 0){
+            options->motionPath = value;
+        }
+        else if(strcmp(name, "contacts") == 0){
+            options->contactsPath = value;
+        }
+        else if(strcmp(name, "step") == 0){
+            result = readDecimalNumber(value, 0, &options->step);
+        }
+        else if(strcmp(name, "budget") == 0){
+            result = readDecimalNumber(value, 0, &options->budget);
+        }
+        else if(strcmp(name, "format") == 0){
+            const char* formats[] = {"text", "double", "float", "quantised"};
+            int formatCodes[] = {OBJECT_TEXT, BINARY_DOUBLE, BINARY_FLOAT,
+                    BINARY_QUANTISED};
+            int f;
+            result = EXIT_FAILURE;
+            for(f = 0; f < 4; f++){
+                if(strcmp(value, formats[f]) == 0){
+                    options->format = formatCodes[f];
+                    result = EXIT_SUCCESS;
+                }
+            }
+        }
+        else{
+            fprintf(stderr, "error: unknown option --%s\n", name);
+            return -1;
+        }
+        if(result != EXIT_SUCCESS){
+            fprintf(stderr, "error: bad value for --%s: %s\n", name, value);
+            return -1;
+        }
+    }
+    return positional;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ POLYGON NUMBER ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads an argument as the number of a polygon, from 1 to count,
+ * and stores its index in the list (one less). Returns EXIT_FAILURE if there
+ * is no such polygon.
+ */
+static int readPolygonNumber(const char* text, int count, int* index){
+    long number;
+    if(readWholeNumber(text, 1, &number) != EXIT_SUCCESS || number > count){
+        fprintf(stderr, "error: no polygon %s (the file has %d)\n", text,
+                count);
+        return(EXIT_FAILURE);
+    }
+    *index = (int)number - 1;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// PREPARE POLYGONS ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function does what the menu does to polygons after loading them, but
+ * without asking or printing anything: concave polygons are split into convex
+ * pieces (or replaced by their hull, with --hull), and large polygons are
+ * given their levels of detail.
+ */
+static int preparePolygons(polygon** list, cliOptions* options){
+    int i;
+    for(i = 0; list[i] != NULL; i++){
+        if(checkIfConvex(list[i]) == 0){
+            polygon* hull = NULL;
+            if(options->hull == 1){
+                hull = buildHullProxy(list[i]);
+            }
+            if(hull != NULL){
+                list[i] = hull;
+            }
+            else{
+                attachConvexPieces(list[i]);
+            }
+        }
+        attachPolygonDetail(list[i]);
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RUN LOAD ///////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* Prints the number of vertices, convexity, area and bounds of every polygon.
+ */
+static int runLoad(polygon** list, int count, char** arguments,
+        cliOptions* options){
+    printf("polygon,vertices,convex,area,min_x,min_y,max_x,max_y\n");
+    int i, n;
+    for(i = 0; i < count; i++){
+        bounds b;
+        getPolygonBounds(list[i], &b);
+        n = 0;
+        while(list[i]->vertices[n] != NULL){
+            n++;
+        }
+        printf("%d,%d,%d,%.10g,%.10g,%.10g,%.10g,%.10g\n", i+1, n,
+                checkIfConvex(list[i]), getPolygonArea(list[i]), b.minX,
+                b.minY, b.maxX, b.maxY);
+    }
+    return(CLI_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RUN COLLIDE ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* Prints whether two polygons collide, and how far apart they are if not.
+ */
+static int runCollide(polygon** list, int count, char** arguments,
+        cliOptions* options){
+    int a, b;
+    if(readPolygonNumber(arguments[0], count, &a) != EXIT_SUCCESS ||
+            readPolygonNumber(arguments[1], count, &b) != EXIT_SUCCESS){
+        return(CLI_USAGE);
+    }
+    preparePolygons(list, options);
+
+    printf("first,second,collide,distance\n");
+    resultRecord record;
+    if(measureCollision(list[a], list[b], a+1, b+1, &record) == 1){
+        printf("%d,%d,0,%.10g\n", a+1, b+1, record.distance);
+    }
+    else{
+        printf("%d,%d,1,0\n", a+1, b+1);
+    }
+    if(options->results != NULL){
+        writeResult(options->results, &record);
+    }
+    return (record.code == RESULT_CLEAR) ? CLI_SUCCESS : CLI_FOUND;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RUN COLLIDE ALL ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* Prints every pair of polygons which collide, in order, first by the lower
+ * number and then by the higher. Pairs which don't collide aren't listed, so
+ * the output stays small for large files.
+ *
+ * Unlike the menu, which checks every pair, each polygon is only checked
+ * against those the broadphase grid finds near it. With --results, each pair
+ * which collides is also logged with the move which would separate them.
+ */
+static int compareIds(const void* a, const void* b){
+    return *(const int*)a - *(const int*)b;
+}
+
+static int runCollideAll(polygon** list, int count, char** arguments,
+        cliOptions* options){
+    preparePolygons(list, options);
+
+    bounds* boxes = malloc(sizeof(bounds)*(count+1));
+    int i, j;
+    for(i = 0; i < count; i++){
+        getPolygonBounds(list[i], &boxes[i]);
+    }
+    spatialGrid* grid = buildGridOfBoxes(boxes, count, 0);
+
+    printf("first,second\n");
+    int* nearby = NULL;
+    int capacity = 0, found = 0;
+    for(i = 0; i < count; i++){
+        int near = gridQuery(grid, &boxes[i], &nearby, &capacity);
+        qsort(nearby, near, sizeof(int), compareIds);
+        for(j = 0; j < near; j++){
+            if(nearby[j] > i && checkCollisions(list[i], list[nearby[j]]) == 0){
+                printf("%d,%d\n", i+1, nearby[j]+1);
+                found++;
+                if(options->results != NULL){
+                    resultRecord record;
+                    measureCollision(list[i], list[nearby[j]], i+1,
+                            nearby[j]+1, &record);
+                    writeResult(options->results, &record);
+                }
+            }
+        }
+    }
+
+    free(nearby);
+    free(boxes);
+    freeSpatialGrid(grid);
+    return (found > 0) ? CLI_FOUND : CLI_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RUN CONTAIN ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* Prints whether one polygon is inside another.
+ */
+static int runContain(polygon** list, int count, char** arguments,
+        cliOptions* options){
+    int inside, bound;
+    if(readPolygonNumber(arguments[0], count, &inside) != EXIT_SUCCESS ||
+            readPolygonNumber(arguments[1], count, &bound) != EXIT_SUCCESS){
+        return(CLI_USAGE);
+    }
+    preparePolygons(list, options);
+
+    resultRecord record;
+    int result = measureContainment(list[inside], list[bound], inside+1,
+            bound+1, &record);
+    if(options->results != NULL){
+        writeResult(options->results, &record);
+    }
+    printf("inside,bound,contained\n");
+    printf("%d,%d,%d\n", inside+1, bound+1, result);
+    return (result == 1) ? CLI_SUCCESS : CLI_FOUND;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RUN FIT ////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* Runs the same fit as the menu's S option and prints the result, with the
+ * seed used so the fit can be repeated.
+ */
+static int runFit(polygon** list, int count, char** arguments,
+        cliOptions* options){
+    int inside, outside;
+    if(readPolygonNumber(arguments[0], count, &inside) != EXIT_SUCCESS ||
+            readPolygonNumber(arguments[1], count, &outside) != EXIT_SUCCESS){
+        return(CLI_USAGE);
+    }
+    preparePolygons(list, options);
+
+    fitOptions* fit = buildFitOptions(options->seed, options->threads);
+    fit->timeLimit = options->timeLimit;
+    double start = getTimeSeconds();
+    transformation* t = findMinScaleWithTranslation(list[inside],
+            list[outside], options->precision, options->iterations, fit);
+    if(options->results != NULL){
+        resultRecord record;
+        fillFitRecord(t, fit, inside+1, outside+1, getTimeSeconds() - start,
+                &record);
+        writeResult(options->results, &record);
+    }
+
+    printf("inside,outside,scale,rotation,x,y,seed,evaluations,stopped\n");
+    printf("%d,%d,%.10g,%.10g,%.10g,%.10g,%lu,%ld,%d\n", inside+1, outside+1,
+            t->scale, t->rotationZ, t->translation->x, t->translation->y,
+            fit->seed, fit->evaluations, fit->stopped);
+
+    free(t->translation);
+    free(t);
+    free(fit);
+    return(CLI_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RUN EXPORT /////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* Draws the polygons in the view as an HTML page, as the menu's E option
+ * does, and prints how many were drawn.
+ */
+static int runExport(polygon** list, int count, char** arguments,
+        cliOptions* options){
+    exportView view;
+    view.width = options->width;
+    view.height = options->height;
+    view.detail = options->detail;
+    view.area.minX = 0;
+    view.area.minY = 0;
+    view.area.maxX = options->width;
+    view.area.maxY = options->height;
+    if(options->view == CLI_VIEW_ALL){
+        setViewToFit(&view, list);
+    }
+    else if(options->view == CLI_VIEW_AREA){
+        view.area = options->area;
+    }
+
+    FILE* file = fopen(arguments[0], "w");
+    if(file == NULL){
+        fprintf(stderr, "error: %s: could not write the file\n", arguments[0]);
+        return(CLI_FILE);
+    }
+    int drawn = writeHTML(file, list, NULL, &view);
+    if(fclose(file) != 0 || drawn < 0){
+        fprintf(stderr, "error: %s: could not write the file\n", arguments[0]);
+        return(CLI_FILE);
+    }
+    printf("output,polygons,drawn\n");
+    printf("%s,%d,%d\n", arguments[0], count, drawn);
+    return(CLI_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RUN SERVE //////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* Keeps the polygons in memory and answers questions about them, from the
+ * standard input or a socket, until stopped. The answers are the only output.
+ */
+static int runServe(polygon** list, int count, char** arguments,
+        cliOptions* options){
+    preparePolygons(list, options);
+    if(serveScene(list, count, options->socketPath) != EXIT_SUCCESS){
+        return(CLI_FILE);
+    }
+    return(CLI_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RUN SIMULATE ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* Runs the polygons forward for the given number of steps, with the
+ * velocities from --motion, and prints the totals over every step and the
+ * number of steps run each second. The time counted is only that spent
+ * stepping, not writing contacts. With --contacts, every contact of every
+ * step is written to that file as:
+ *
+ *      frame,first,second,depth,normal_x,normal_y
+ */
+static int runSimulate(polygon** list, int count, char** arguments,
+        cliOptions* options){
+    long frames;
+    if(readWholeNumber(arguments[0], 1, &frames) != EXIT_SUCCESS){
+        fprintf(stderr, "error: bad number of frames: %s\n", arguments[0]);
+        return(CLI_USAGE);
+    }
+    preparePolygons(list, options);
+    simulation* sim = buildSimulation(list, count, options->threads);
+    sim->budget = options->budget;
+
+    parseError error;
+    if(options->motionPath != NULL &&
+            readSimulationMotion(sim, options->motionPath, &error) !=
+            EXIT_SUCCESS){
+        if(error.line > 0){
+            fprintf(stderr, "error: %s: line %d, column %d: %s\n",
+                    options->motionPath, error.line, error.column,
+                    error.message);
+        }
+        else{
+            fprintf(stderr, "error: %s: %s\n", options->motionPath,
+                    error.message);
+        }
+        freeSimulation(sim);
+        return(CLI_FILE);
+    }
+
+    FILE* contactFile = NULL;
+    if(options->contactsPath != NULL){
+        contactFile = fopen(options->contactsPath, "w");
+        if(contactFile == NULL){
+            fprintf(stderr, "error: %s: could not write the file\n",
+                    options->contactsPath);
+            freeSimulation(sim);
+            return(CLI_FILE);
+        }
+        fprintf(contactFile, "frame,first,second,depth,normal_x,normal_y\n");
+    }
+
+    long frame, pairs = 0, contacts = 0, late = 0;
+    double seconds = 0;
+    int i;
+    for(frame = 0; frame < frames; frame++){
+        stepSimulation(sim, options->step);
+        pairs += sim->frame.pairs;
+        contacts += sim->frame.contacts;
+        late += (sim->frame.skipped > 0);
+        seconds += sim->frame.seconds;
+        for(i = 0; contactFile != NULL && i < sim->frame.contacts; i++){
+            simulationContact* c = &sim->contacts[i];
+            fprintf(contactFile, "%ld,%d,%d,%.10g,%.10g,%.10g\n",
+                    sim->frame.number, c->first+1, c->second+1, c->depth,
+                    c->normalX, c->normalY);
+        }
+    }
+
+    int result = (contacts > 0) ? CLI_FOUND : CLI_SUCCESS;
+    if(contactFile != NULL && fclose(contactFile) != 0){
+        fprintf(stderr, "error: %s: could not write the file\n",
+                options->contactsPath);
+        result = CLI_FILE;
+    }
+    printf("frames,bodies,awake,pairs,contacts,over_budget,seconds,"
+            "frames_per_second\n");
+    printf("%ld,%d,%d,%ld,%ld,%ld,%.10g,%.10g\n", frames, count,
+            sim->awakeCount, pairs, contacts, late, seconds,
+            (seconds > 0) ? frames/seconds : 0);
+    freeSimulation(sim);
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RUN CONVERT ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* Saves the file in another form, as the menu's V option does. This doesn't
+ * load the file first, as convertObjectFile reads it itself.
+ */
+static int runConvert(const char* from, char** arguments,
+        cliOptions* options){
+    parseError error;
+    if(convertObjectFile(from, arguments[0], options->format, &error) !=
+            EXIT_SUCCESS){
+        if(error.line > 0){
+            fprintf(stderr, "error: %s: line %d, column %d: %s\n", from,
+                    error.line, error.column, error.message);
+        }
+        else{
+            fprintf(stderr, "error: %s\n", error.message);
+        }
+        return(CLI_FILE);
+    }
+    printf("input,output\n");
+    printf("%s,%s\n", from, arguments[0]);
+    return(CLI_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RUN COMMAND LINE ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function runs the command given on the command line, and returns the
+ * code the program should exit with.
+ */
+int runCommandLine(int argc, char** argv){
+    cliCommand commands[] = {
+        {"load", 0, 1, runLoad},
+        {"collide", 2, 1, runCollide},
+        {"collide-all", 0, 1, runCollideAll},
+        {"contain", 2, 1, runContain},
+        {"fit", 2, 1, runFit},
+        {"export", 1, 1, runExport},
+        {"serve", 0, 1, runServe},
+        {"simulate", 1, 1, runSimulate},
+        {"convert", 1, 0, NULL}
+    };
+    int commandCount = sizeof(commands)/sizeof(cliCommand);
+
+    cliOptions options;
+    options.hull = 0;
+    options.precision = 4;
+    options.iterations = 1000;
+    options.timeLimit = 0;
+    options.seed = (unsigned long)time(NULL);
+    options.threads = 0;
+    options.width = 800;
+    options.height = 800;
+    options.view = CLI_VIEW_CANVAS;
+    options.detail = 0.5;
+    options.format = BINARY_DOUBLE;
+    options.socketPath = NULL;
+    options.resultsPath = NULL;
+    options.results = NULL;
+    options.motionPath = NULL;
+    options.contactsPath = NULL;
+    options.step = 1.0/60;
+    options.budget = 0;
+
+    //after the program's name come the command, the file and the rest
+    int positional = readOptions(argc-1, argv+1, &options);
+    if(positional < 0){
+        return(CLI_USAGE);
+    }
+    char** arguments = argv+1;
+
+    cliCommand* command = NULL;
+    int i;
+    for(i = 0; i < commandCount && positional > 0; i++){
+        if(strcmp(arguments[0], commands[i].name) == 0){
+            command = &commands[i];
+        }
+    }
+    if(command == NULL || positional != command->arguments + 2){
+        return printUsage(argv[0]);
+    }
+    const char* filename = arguments[1];
+
+    if(command->loads == 0){
+        return runConvert(filename, arguments+2, &options);
+    }
+
+    int count;
+    parseError error;
+    polygon** list = readObjectFile(filename, &count, &error);
+    if(list == NULL){
+        if(error.line > 0){
+            fprintf(stderr, "error: %s: line %d, column %d: %s\n", filename,
+                    error.line, error.column, error.message);
+        }
+        else{
+            fprintf(stderr, "error: %s: %s\n", filename, error.message);
+        }
+        return(CLI_FILE);
+    }
+
+    //open the results log, if asked for, before running anything
+    if(options.resultsPath != NULL){
+        options.results = openResultSink(options.resultsPath);
+        if(options.results == NULL){
+            fprintf(stderr, "error: %s: could not write the file\n",
+                    options.resultsPath);
+            freePolygonList(list);
+            return(CLI_FILE);
+        }
+    }
+
+    int result = command->run(list, count, arguments+2, &options);
+    fflush(stdout);
+    if(options.results != NULL &&
+            closeResultSink(options.results) != EXIT_SUCCESS){
+        fprintf(stderr, "error: %s: could not write the file\n",
+                options.resultsPath);
+        result = CLI_FILE;
+    }
+    freePolygonList(list);
+    return result;
+}
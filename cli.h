@@ -0,0 +1,24 @@
+/*
+ * File:   cli.h
+ *
+ * This header file externalises the functions in the cli.c file, which runs
+ * the program from the command line without the menu.
+ *
+ * For further details on any function, check there.
+ */
+
+#ifndef CLI_H
+#define CLI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int runCommandLine(int argc, char** argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLI_H */
+
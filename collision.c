@@ -6,8 +6,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include "vector.h"
 #include "polygon.h"
+#include "broadphase.h"
+#include "decompose.h"
+#include "lod.h"
+#include "extreme.h"
 #include "collision.h"
 
 
@@ -26,82 +31,13 @@
  */
 int checkCollisionOnAxis(polygon* a, polygon* b, vector* axis){
     
-    //create new arrays of vectors to operate on
-    vector* vectorsA[20] = {NULL};
-    vector* vectorsB[20] = {NULL};
-    
-    //for each vertex in the polygon
-    int i = 0;
-    for(i=0;a->vertices[i] != NULL;i++){
-        
-        //add a new vector, from 0.0 to this vertex, to the array
-        vectorsA[i] = a->vertices[i];
-    }
-    vectorsA[i] = NULL;
-    for(i=0;b->vertices[i] != NULL;i++){
-        //repeat for the other object
-        vectorsB[i] = b->vertices[i];   
-    }
-    vectorsB[i] = NULL;
-    
-    /* for the first polygon, set the minimum and maximum projection on the axis
-    * to the first one as a default value 
-    */
-    
-    //get the dot product of the vector with the axis
-    double minProjectionA = dotProduct(vectorsA[0], axis);
-    double maxProjectionA = dotProduct(vectorsA[0], axis);
-    
-    //store the vertex for the min and the max: set it to the first as a default
-    int minVertexA = 0;
-    int maxVertexA = 0;
-    
-    //for each vector in polygon a that isnt null
-    int j =0;
-    for (j = 0; vectorsA[j] != NULL; j++){
-        
-        //if the minimum projection on the axis is greater than the current
-        //vector's projection on the axis, make it the new minimum
-        if (minProjectionA > dotProduct(vectorsA[j], axis)){
-            minProjectionA = dotProduct(vectorsA[j], axis);
-            
-            //set the minimum vertex index to the index of the current vertex
-            minVertexA = j;
-        }
-        
-        //then the same in inverse for the maximum 
-        if (maxProjectionA < dotProduct(vectorsA[j], axis)){
-            maxProjectionA = dotProduct(vectorsA[j], axis);
-            maxVertexA = j;
-        }
-    }
-        
-    
-    //then do the same for polygon b
-    //get the dot product of the vector with the axis
-    double minProjectionB = dotProduct(vectorsB[0], axis);
-    double maxProjectionB = dotProduct(vectorsB[0], axis);
-    //set the min and max dot to 1
-    int minVertexB = 0;
-    int maxVertexB = 0;
-    
-    //for each vector in polygon a
-    j =0;
-    for (j = 0; vectorsB[j] != NULL; j++){
-        
-        //if the minimum projection on the axis is greater than the
-        //vector's projection on the axis, make it the new minimum
-        if (minProjectionB > dotProduct(vectorsB[j], axis)){
-            minProjectionB = dotProduct(vectorsB[j], axis);
-            minVertexB = j;
-        }
-        
-        //same in inverse for max
-        if (maxProjectionB < dotProduct(vectorsB[j], axis)){
-            maxProjectionB = dotProduct(vectorsB[j], axis);
-            maxVertexB = j;
-        }
-    }
+    //find the lowest and highest projections of each polygon on the axis.
+    //Large convex polygons find these without checking every vertex (see
+    //extreme.c)
+    double minProjectionA, maxProjectionA;
+    double minProjectionB, maxProjectionB;
+    getProjectionRange(a, axis, &minProjectionA, &maxProjectionA);
+    getProjectionRange(b, axis, &minProjectionB, &maxProjectionB);
     
     //now compare along the axis for collision
     
@@ -123,6 +59,62 @@ int checkCollisionOnAxis(polygon* a, polygon* b, vector* axis){
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+////////////////// CHECK PIECE COLLISIONS //////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* These functions check the collision of two polygons where at least one has
+ * been split into convex pieces (see decompose.c). Each piece of the first
+ * (or the whole of it, if it wasn't split) is checked against the second's 
+ * tree of pieces, and only the pieces whose boxes overlap are checked fully.
+ * 
+ * The return values are the same as checkCollisions.
+ */
+static int checkPieceTree(polygon* part, bounds* box, convexPieces* c, int node){
+    pieceNode* n = &c->nodes[node];
+    if(checkBoundsOverlap(box, &n->box) == 0){
+        return 1;
+    }
+    if(n->piece >= 0){
+        return checkCollisions(part, c->pieces[n->piece]);
+    }
+    if(checkPieceTree(part, box, c, n->left) == 0){
+        return 0;
+    }
+    return checkPieceTree(part, box, c, n->right);
+}
+
+static int checkPieceCollisions(polygon* a, polygon* b){
+    convexPieces* piecesA = getConvexPieces(a);
+    convexPieces* piecesB = getConvexPieces(b);
+    
+    //if either was made convex since it was split, it has no pieces now
+    if(piecesA == NULL && piecesB == NULL){
+        return checkCollisions(a, b);
+    }
+    
+    //collisions go both ways, so make sure b is one with pieces
+    if(piecesB == NULL){
+        polygon* swap = a;
+        a = b;
+        b = swap;
+        piecesB = piecesA;
+        piecesA = NULL;
+    }
+    refitPieceTree(piecesB);
+    
+    int count = (piecesA != NULL) ? piecesA->count : 1;
+    int i;
+    for(i = 0; i < count; i++){
+        polygon* part = (piecesA != NULL) ? piecesA->pieces[i] : a;
+        bounds box;
+        getPolygonBounds(part, &box);
+        if(checkPieceTree(part, &box, piecesB, 0) == 0){
+            return 0;
+        }
+    }
+    return 1;
+}
+
 /////////////////////////////////////////////////////////////////////
 ////////////////// CHECK COLLISIONS//////////////////////////////////
 /////////////////////////////////////////////////////////////////////
@@ -134,60 +126,210 @@ int checkCollisionOnAxis(polygon* a, polygon* b, vector* axis){
  * returns 1. If all axes collide, the objects do collide and this function
  * returns 0.
  * 
+ * Polygons with levels of detail are first checked with those, and only 
+ * checked fully if they can't decide. Concave polygons which have been split
+ * into convex pieces are checked piece by piece instead.
+ * 
  * RETURN 1: OBJECTS DO NOT COLLIDE
  * RETURN 0: OBJECTS COLLIDE
  */
 int checkCollisions(polygon* a, polygon* b){
+    if(a->detail != NULL || b->detail != NULL){
+        int result = checkDetailCollisions(a, b);
+        if(result >= 0){
+            return result;
+        }
+    }
+    if(a->pieces != NULL || b->pieces != NULL){
+        return checkPieceCollisions(a, b);
+    }
     
-    //instantiate an integer for use as a counter
-    int i = 1;
-    
-    //for each non-null vertex in the first polygon
-    while(a->vertices[i] != NULL){
-        
-        //run checkCollisionOnAxis for polygon a, polygon b, and the normal for
-        //the line between vertex i-1 and vertex i
-        vector* n = getLineNormal(a->vertices[i-1], a->vertices[i]);
-        if (checkCollisionOnAxis(a, b, n) != 0){
-            //if it equals 1, return 1 (there is no collision), otherwise dont
-            //return
-            free(n);
+    //check the normal of each edge of a as an axis, including the edge from
+    //the last vertex back to the first, then each edge of b. The normals are
+    //kept on the stack, as this is run for every pair checked
+    int i;
+    for(i = 0; a->vertices[i] != NULL; i++){
+        vector* s = a->vertices[i];
+        vector* e = (a->vertices[i+1] != NULL) ? a->vertices[i+1] : 
+                a->vertices[0];
+        vector n = {-(e->y - s->y), e->x - s->x, 0};
+        if(checkCollisionOnAxis(a, b, &n) != 0){
+            //a gap has been found: there is no collision
             return 1;
-        }else free(n);
-        //increment i and repeat
-        i++;
+        }
     }
-    
-    //once the collision has been checked for all lines between the first and
-    //last vertices, check for the line between last and first, completing the
-    //shape
-    vector* v = getLineNormal(a->vertices[i-1], a->vertices[0]);
-    if (checkCollisionOnAxis(a, b, v) != 0){
-        free(v);
-        return 1;
-    }else free(v);
-
-    //reset i to 1 and repeat the process for polygon b
-    i = 1;
-    while(b->vertices[i] != NULL){
-        vector* v = getLineNormal(b->vertices[i-1], b->vertices[i]);
-        if (checkCollisionOnAxis(a, b, v) != 0){
-            free(v);
+    for(i = 0; b->vertices[i] != NULL; i++){
+        vector* s = b->vertices[i];
+        vector* e = (b->vertices[i+1] != NULL) ? b->vertices[i+1] : 
+                b->vertices[0];
+        vector n = {-(e->y - s->y), e->x - s->x, 0};
+        if(checkCollisionOnAxis(a, b, &n) != 0){
             return 1;
-        }else free(v);
-        i++;
+        }
     }
-    vector* n = getLineNormal(b->vertices[i-1], b->vertices[0]);
-    if (checkCollisionOnAxis(a, b, n) != 0){
-        free(n);
-        return 1;
-    }else free (n);
     
     //if after all the above have run, and not returned, then return 0 - the two
     //objects collide on all normals, and so definitely collide
     return 0;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+///////////////// GET SEPARATION ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* These functions find how far apart two polygons are along the axis which 
+ * separates them most. Each edge normal of both polygons is tried, made to be 
+ * of length 1, and the gap between the projections on it measured.
+ * 
+ * The polygons can't be closer than this gap, so it is a safe lower bound for 
+ * the distance between them. If the polygons overlap on every axis the value
+ * is negative or zero, by the smallest overlap.
+ * 
+ * A concave polygon split into pieces can overlap every axis without touching,
+ * so for those each pair of pieces is measured instead, and the closest pair
+ * gives the result.
+ * 
+ * The axis found is stored in axis, pointing from a towards b.
+ */
+static double getSideSeparation(polygon* a, polygon* b, polygon* side, 
+        double best, vector* axis){
+    int i;
+    for(i = 0; side->vertices[i] != NULL; i++){
+        vector* s = side->vertices[i];
+        vector* e = (side->vertices[i+1] != NULL) ? side->vertices[i+1] :
+                side->vertices[0];
+        double length = sqrt((e->x - s->x)*(e->x - s->x) + 
+                (e->y - s->y)*(e->y - s->y));
+        if(length == 0){
+            continue;
+        }
+        vector n = {-(e->y - s->y)/length, (e->x - s->x)/length, 0};
+        
+        double minA, maxA, minB, maxB;
+        getProjectionRange(a, &n, &minA, &maxA);
+        getProjectionRange(b, &n, &minB, &maxB);
+        
+        //b above a on the axis, or below it
+        double gap = minB - maxA;
+        double direction = 1;
+        if(minA - maxB > gap){
+            gap = minA - maxB;
+            direction = -1;
+        }
+        if(gap > best){
+            best = gap;
+            axis->x = n.x*direction;
+            axis->y = n.y*direction;
+            axis->z = 0;
+        }
+    }
+    return best;
+}
+
+static double getConvexSeparation(polygon* a, polygon* b, vector* axis){
+    axis->x = 1;
+    axis->y = 0;
+    axis->z = 0;
+    double best = getSideSeparation(a, b, a, -HUGE_VAL, axis);
+    return getSideSeparation(a, b, b, best, axis);
+}
+
+double getSeparation(polygon* a, polygon* b, vector* axis){
+    convexPieces* piecesA = (a->pieces != NULL) ? getConvexPieces(a) : NULL;
+    convexPieces* piecesB = (b->pieces != NULL) ? getConvexPieces(b) : NULL;
+    if(piecesA == NULL && piecesB == NULL){
+        return getConvexSeparation(a, b, axis);
+    }
+    
+    int countA = (piecesA != NULL) ? piecesA->count : 1;
+    int countB = (piecesB != NULL) ? piecesB->count : 1;
+    double closest = HUGE_VAL;
+    int i, j;
+    for(i = 0; i < countA; i++){
+        polygon* partA = (piecesA != NULL) ? piecesA->pieces[i] : a;
+        for(j = 0; j < countB; j++){
+            polygon* partB = (piecesB != NULL) ? piecesB->pieces[j] : b;
+            vector pairAxis;
+            double separation = getConvexSeparation(partA, partB, &pairAxis);
+            if(separation < closest){
+                closest = separation;
+                *axis = pairAxis;
+            }
+        }
+    }
+    return closest;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///////////////// CHECK INSIDE CONCAVE BOUND ///////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* These functions check that a polygon is inside a concave bound, which the
+ * separating axis checks in checkInsideBoundingBox can't do. A polygon is 
+ * inside if all of its vertices are inside the bound and none of its edges
+ * cross or touch the bound's edges.
+ * 
+ * checkPointInside counts how many of the bound's edges a line from the point
+ * to the right crosses: an odd number means it is inside. checkEdgesTouch
+ * checks whether two edges cross or touch.
+ */
+static double turnOf(vector* o, vector* a, vector* b){
+    return (a->x - o->x)*(b->y - o->y) - (a->y - o->y)*(b->x - o->x);
+}
+
+static int checkPointInside(vector* p, polygon* bound){
+    int i, inside = 0;
+    for(i = 0; bound->vertices[i] != NULL; i++){
+        vector* a = bound->vertices[i];
+        vector* b = (bound->vertices[i+1] != NULL) ? bound->vertices[i+1] : 
+                bound->vertices[0];
+        if((a->y > p->y) != (b->y > p->y) &&
+                p->x < a->x + (p->y - a->y)*(b->x - a->x)/(b->y - a->y)){
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+static int checkEdgesTouch(vector* a, vector* b, vector* c, vector* d){
+    double d1 = turnOf(c, d, a), d2 = turnOf(c, d, b);
+    double d3 = turnOf(a, b, c), d4 = turnOf(a, b, d);
+    if(((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) &&
+       ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))){
+        return 1;
+    }
+    //an end of one edge lying on the other counts as touching
+    if(d1 == 0 && fmin(c->x, d->x) <= a->x && a->x <= fmax(c->x, d->x) &&
+            fmin(c->y, d->y) <= a->y && a->y <= fmax(c->y, d->y)) return 1;
+    if(d2 == 0 && fmin(c->x, d->x) <= b->x && b->x <= fmax(c->x, d->x) &&
+            fmin(c->y, d->y) <= b->y && b->y <= fmax(c->y, d->y)) return 1;
+    if(d3 == 0 && fmin(a->x, b->x) <= c->x && c->x <= fmax(a->x, b->x) &&
+            fmin(a->y, b->y) <= c->y && c->y <= fmax(a->y, b->y)) return 1;
+    if(d4 == 0 && fmin(a->x, b->x) <= d->x && d->x <= fmax(a->x, b->x) &&
+            fmin(a->y, b->y) <= d->y && d->y <= fmax(a->y, b->y)) return 1;
+    return 0;
+}
+
+static int checkInsideConcaveBound(polygon* a, polygon* bound){
+    int i, j;
+    for(i = 0; a->vertices[i] != NULL; i++){
+        if(checkPointInside(a->vertices[i], bound) == 0){
+            return 0;
+        }
+    }
+    for(i = 0; a->vertices[i] != NULL; i++){
+        vector* a1 = a->vertices[i];
+        vector* a2 = (a->vertices[i+1] != NULL) ? a->vertices[i+1] : a->vertices[0];
+        for(j = 0; bound->vertices[j] != NULL; j++){
+            vector* b1 = bound->vertices[j];
+            vector* b2 = (bound->vertices[j+1] != NULL) ? bound->vertices[j+1] : 
+                    bound->vertices[0];
+            if(checkEdgesTouch(a1, a2, b1, b2) == 1){
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ///////////////// CHECK INSIDE BOUNDING BOX ////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
@@ -195,73 +337,88 @@ int checkCollisions(polygon* a, polygon* b){
  * This function takes two polygons and checks that one is inside the other. It 
  * does this by breaking the outer box into a series of single-side lines and
  * comparing the inner box to the line normal of these.
+ * 
+ * Polygons with levels of detail are first checked with those, and only 
+ * checked fully if they can't decide. Bounds which have been split into convex
+ * pieces are concave, so are checked with checkInsideConcaveBound instead.
  */
 int checkInsideBoundingBox(polygon* a, polygon* bound){
-    //break the box down into it's component lines as seperate polygons
-    polygon* boundPolygons[21];
-    vector* boundVertices[3];
-    int i;
-    
-    for(i = 0; bound->vertices[i+1] != NULL; i++){
-        boundVertices[0] = bound->vertices[i];
-        boundVertices[1] = bound->vertices[i+1];
-        boundVertices[2] = NULL;
-        
-        boundPolygons[i] = buildPolygon(boundVertices);
+    if(a->detail != NULL || bound->detail != NULL){
+        int result = checkDetailInside(a, bound);
+        if(result >= 0){
+            return result;
+        }
+    }
+    if(bound->pieces != NULL && getConvexPieces(bound) != NULL){
+        return checkInsideConcaveBound(a, bound);
     }
-    boundVertices[0] = bound->vertices[i];
-    boundVertices[1] = bound->vertices[0];
-    boundVertices[2] = NULL;
-    
-    boundPolygons[i] = buildPolygon(boundVertices);
-    boundPolygons[i+1] = NULL;
     
-    //check collision for each line along it's normal
-    for(i = 0; boundPolygons[i] != NULL; i++){
-        vector* n = getLineNormal(boundPolygons[i]->vertices[0], 
-                boundPolygons[i]->vertices[1]);
-        int result = checkCollisionOnAxis(a, boundPolygons[i],n);
-        free(n);
+    //check each line of the box along its normal. The line's projection is
+    //just that of its two ends, so it doesn't need its own polygon
+    int i;
+    for(i = 0; bound->vertices[i] != NULL; i++){
+        vector* s = bound->vertices[i];
+        vector* e = (bound->vertices[i+1] != NULL) ? bound->vertices[i+1] :
+                bound->vertices[0];
+        vector n = {-(e->y - s->y), e->x - s->x, 0};
         
-        if(result == 0 || result == 1){
-            //if a collides with b a 0 is returned
-                //this means the object collides with the edge of the bounding box
-                //this means the object is not fully inside the box, so return 0
-
-            //if a is higher up the axis than b, 1 is returned
-                //this means a is outside the box on this axis
-                //this means a is outside the box, so return 0
-            
-            //first free the function objects
-            int k;
-            for(k = 0; boundPolygons[k] != NULL; k++){
-                free(boundPolygons[k]->transform->translation);
-                free(boundPolygons[k]->centre);
-                free(boundPolygons[k]);
-            }
-            //return
-            
+        double minA, maxA;
+        getProjectionRange(a, &n, &minA, &maxA);
+        double minLine = dotProduct(s, &n);
+        if(dotProduct(e, &n) < minLine){
+            minLine = dotProduct(e, &n);
+        }
+        
+        if(!(maxA < minLine)){
+            //if a reaches the line on this axis, it either collides with the
+            //edge of the box or is outside it, so is not fully inside the box
             return 0;
-            
-            
         }
-        //if a is lower on the axis than b, -1 is returned
-            //this means a is inside the box on this axis
-            //continue 
+        //otherwise a is lower on the axis than the line, so is inside the box
+        //on this axis: continue
     }
     //if the function has not returned, a is inside the box on all axes
-    
-    //free the function memory
-    int k;
-    for(k = 0; boundPolygons[k] != NULL; k++){
-        free(boundPolygons[k]->transform->translation);
-        free(boundPolygons[k]->centre);
-        free(boundPolygons[k]);
+    return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////// PREPARE COLLISION CHECKS ///////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/*
+ * This function brings up to date everything the checks keep with a polygon
+ * and would otherwise update the first time they look at it: the tables of
+ * edge angles of it and its pieces and levels of detail (see extreme.c), its
+ * tree of pieces, and its levels of detail, placed where it is now. Until it is
+ * moved again, the polygon can then be checked on several threads at once.
+ */
+static int prepareNormalTable(polygon* p){
+    if(p->normals == NULL){
+        attachNormalTable(p);
     }
+    return(EXIT_SUCCESS);
+}
 
-    //return 1
-    
-    return 1;
+int prepareCollisionChecks(polygon* p){
+    int i;
+    prepareNormalTable(p);
+    convexPieces* c = getConvexPieces(p);
+    if(c != NULL){
+        refitPieceTree(c);
+        for(i = 0; i < c->count; i++){
+            prepareNormalTable(c->pieces[i]);
+        }
+    }
+    polygonDetail* d = getPolygonDetail(p);
+    if(d != NULL){
+        placePolygonDetail(p);
+        for(i = 0; i < d->count; i++){
+            prepareNormalTable(d->levels[i].outer);
+            if(d->levels[i].inner != NULL){
+                prepareNormalTable(d->levels[i].inner);
+            }
+        }
+    }
+    return(EXIT_SUCCESS);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -18,6 +18,8 @@ int checkCollisionOnAxis(polygon* a, polygon* b, vector* axis);
 int checkCollisions(polygon* a, polygon* b);
 int checkInsideBoundingBox(polygon* a, polygon* bound);
 int checkMultipleInBound(polygon* interiors[], polygon* bound);
+double getSeparation(polygon* a, polygon* b, vector* axis);
+int prepareCollisionChecks(polygon* p);
 
 
 
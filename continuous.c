@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          CONTINUOUS COLLISION
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to find when two polygons, each moving from
+ * one position to another, first touch.
+ * 
+ * A position is given as a transformation: the polygon's scale and rotation 
+ * (as used by scalePolygonTo and rotatePolygonZTo) and the position of its 
+ * centre as the translation. Each polygon moves from its start to its end at
+ * a steady rate, over a time from 0 to 1.
+ * 
+ * Stepping the polygons along and checking for collisions each step is slow,
+ * and misses contacts that happen between steps. Instead, this uses 
+ * "conservative advancement": the polygons are measured (see findClearance in
+ * distance.c), and no point of either can move faster than a speed found from
+ * their movements. So the polygons can't touch before the time it would take
+ * to close the distance at that speed, and it is safe to jump straight there.
+ * Repeating this closes in on the first contact from before it, and never
+ * steps past it.
+ * 
+ * Polygons sliding past each other close the distance far more slowly than
+ * they move. So the gap between them along the direction they are apart in is
+ * also used: it can only close as fast as they approach along that direction,
+ * plus their turning and scaling, and if that is never, they can't touch.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vector.h"
+#include "polygon.h"
+#include "collision.h"
+#include "distance.h"
+#include "extreme.h"
+#include "continuous.h"
+
+//the most times the polygons are moved closer before giving up
+#define MAX_ADVANCE_STEPS 1000
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// MOVE POLYGON ALONG /////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function moves a polygon to where it is at the given time (from 0 to 1)
+ * on its way from the start position to the end position.
+ */
+int movePolygonAlong(polygon* p, transformation* start, transformation* end,
+        double time){
+    scalePolygonTo(p, start->scale + (end->scale - start->scale)*time);
+    rotatePolygonZTo(p, start->rotationZ + 
+            (end->rotationZ - start->rotationZ)*time);
+    
+    vector* v = createVector(
+            start->translation->x + 
+                (end->translation->x - start->translation->x)*time,
+            start->translation->y + 
+                (end->translation->y - start->translation->y)*time,
+            start->translation->z + 
+                (end->translation->z - start->translation->z)*time);
+    translatePolygonTo(p, v);
+    free(v);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET TURNING SPEED //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds the fastest any point of a polygon can move relative to
+ * its centre while it goes from its start to its end position, in distance
+ * per unit of time. A point's movement is that of the centre, plus this.
+ * 
+ * It is the movement from the polygon growing or shrinking, plus that from it
+ * turning, which are largest for the point furthest from the centre.
+ */
+static double getTurningSpeed(polygon* p, transformation* start,
+        transformation* end){
+    double radius = 0;
+    int i;
+    for(i = 0; p->vertices[i] != NULL; i++){
+        double dx = p->vertices[i]->x - p->centre->x;
+        double dy = p->vertices[i]->y - p->centre->y;
+        double distance = sqrt(dx*dx + dy*dy);
+        if(distance > radius){
+            radius = distance;
+        }
+    }
+    //the distance the furthest point would be at a scale of 1
+    radius = radius/fabs(p->transform->scale);
+    
+    double largest = (fabs(start->scale) > fabs(end->scale)) ? 
+            fabs(start->scale) : fabs(end->scale);
+    double turn = fabs(end->rotationZ - start->rotationZ)*M_PI/180;
+    
+    return fabs(end->scale - start->scale)*radius + largest*turn*radius;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FIND TIME OF IMPACT ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds the first time (from 0 to 1) at which polygons a and b
+ * touch as they move along their paths. Polygons closer than the tolerance
+ * count as touching. The polygons themselves aren't moved.
+ * 
+ * The result says whether they touch, when, and the direction of the contact
+ * (from a towards b): the direction between their closest points, or if they
+ * already overlap at the start, at time 0, the axis they overlap least on.
+ * 
+ * The time found is never after the true first contact. If the polygons 
+ * haven't been brought within the tolerance, or shown never to be, after
+ * MAX_ADVANCE_STEPS moves, collide is IMPACT_UNRESOLVED, and the time is how
+ * far along their paths they are known not to touch.
+ */
+impact* findTimeOfImpact(polygon* a, transformation* startA, 
+        transformation* endA, polygon* b, transformation* startB, 
+        transformation* endB, double tolerance){
+    impact* result = malloc(sizeof(impact));
+    result->collide = 0;
+    result->time = 1;
+    result->axis = createVector(1, 0, 0);
+    result->steps = 0;
+    
+    //move copies, so the polygons themselves stay where they are
+    polygon* movingA = copyPolygon(a);
+    polygon* movingB = copyPolygon(b);
+    double moveX = (endA->translation->x - startA->translation->x) -
+            (endB->translation->x - startB->translation->x);
+    double moveY = (endA->translation->y - startA->translation->y) -
+            (endB->translation->y - startB->translation->y);
+    double turning = getTurningSpeed(a, startA, endA) + 
+            getTurningSpeed(b, startB, endB);
+    double speed = sqrt(moveX*moveX + moveY*moveY) + turning;
+    
+    double time = 0;
+    int apart = 0;
+    clearance* gap = NULL;
+    while(result->steps < MAX_ADVANCE_STEPS){
+        copyPolygonTo(movingA, a);
+        copyPolygonTo(movingB, b);
+        movePolygonAlong(movingA, startA, endA, time);
+        movePolygonAlong(movingB, startB, endB, time);
+        result->steps++;
+        
+        //the last measurement is a good place to start the next from
+        clearance* next = findClearance(movingA, movingB, gap);
+        if(gap != NULL){
+            freeClearance(gap);
+        }
+        gap = next;
+        double distance = gap->distance;
+        vector axis = {(gap->pointB->x - gap->pointA->x)/distance,
+                (gap->pointB->y - gap->pointA->y)/distance, 0};
+        if(distance <= tolerance){
+            result->collide = 1;
+            result->time = time;
+            if(distance > 0){
+                *result->axis = axis;
+            }
+            else{
+                getSeparation(movingA, movingB, result->axis);
+            }
+            break;
+        }
+        if(speed == 0){
+            break;
+        }
+        
+        //nothing can close the distance before then. The gap between the
+        //polygons' projections onto the direction they are apart in is never
+        //more than it, and can only close as fast as they approach along it
+        //and turn, so if that takes longer, jump there instead
+        double advance = distance/speed;
+        double minA, maxA, minB, maxB;
+        getProjectionRange(movingA, &axis, &minA, &maxA);
+        getProjectionRange(movingB, &axis, &minB, &maxB);
+        double along = minB - maxA;
+        double closing = moveX*axis.x + moveY*axis.y + turning;
+        if(along > 0 && closing <= 0){
+            apart = 1;
+            break;
+        }
+        if(along > 0 && along/closing > advance){
+            advance = along/closing;
+        }
+        time = time + advance;
+        if(time > 1){
+            break;
+        }
+    }
+    if(result->collide == 0 && apart == 0 && time <= 1 && speed != 0){
+        result->collide = IMPACT_UNRESOLVED;
+        result->time = time;
+    }
+    
+    if(gap != NULL){
+        freeClearance(gap);
+    }
+    freePolygon(movingA);
+    freePolygon(movingB);
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FREE IMPACT ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int freeImpact(impact* i){
+    free(i->axis);
+    free(i);
+    return(EXIT_SUCCESS);
+}
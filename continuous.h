@@ -0,0 +1,40 @@
+/* 
+ * File:   continuous.h
+ *
+ * This header file externalises the functions in the continuous.c file, which
+ * finds when two moving polygons first touch.
+ * 
+ * For further details on any function, check there.
+ */
+
+#ifndef CONTINUOUS_H
+#define CONTINUOUS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//collide is 1 if the polygons touch, 0 if they don't, or this if it couldn't
+//be told in time
+#define IMPACT_UNRESOLVED (-1)
+
+typedef struct impact{
+    int collide;
+    double time;
+    vector* axis;
+    int steps;
+}impact;
+
+int movePolygonAlong(polygon* p, transformation* start, transformation* end,
+        double time);
+impact* findTimeOfImpact(polygon* a, transformation* startA, 
+        transformation* endA, polygon* b, transformation* startB, 
+        transformation* endB, double tolerance);
+int freeImpact(impact* i);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONTINUOUS_H */
+
@@ -0,0 +1,532 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          DECOMPOSE
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to split a concave polygon into convex 
+ * pieces, so that the collision checks (which only work on convex polygons)
+ * can be run on the pieces instead.
+ * 
+ * The split uses the Hertel-Mehlhorn method: the polygon is cut into triangles
+ * by "ear clipping", then neighbouring pieces are joined back together 
+ * wherever the result is still convex. This gives at most four times the 
+ * fewest possible pieces, and usually close to it.
+ * 
+ * The pieces are polygons which share the vertices of the polygon they came 
+ * from, so they move, rotate and scale with it without being rebuilt, and the
+ * split is never redone.
+ * 
+ * A small bounding box tree is kept over the pieces, so that collision checks
+ * can skip the pieces which are nowhere near the other polygon. The boxes are
+ * refitted to the pieces' current positions before each use, which is cheap
+ * and keeps the tree correct whatever transforms have been applied.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vector.h"
+#include "polygon.h"
+#include "extreme.h"
+#include "decompose.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GEOMETRY HELPERS ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* crossVertices is positive if vertices a->b->c of p turn anticlockwise, 
+ * negative if clockwise and 0 if they are in a line. insideTriangle checks
+ * whether vertex d of p is inside or on the anticlockwise triangle a, b, c.
+ */
+static double crossVertices(polygon* p, int a, int b, int c){
+    vector* va = p->vertices[a];
+    vector* vb = p->vertices[b];
+    vector* vc = p->vertices[c];
+    return (vb->x - va->x)*(vc->y - va->y) - (vb->y - va->y)*(vc->x - va->x);
+}
+
+static int insideTriangle(polygon* p, int a, int b, int c, int d){
+    return crossVertices(p, a, b, d) >= 0 && crossVertices(p, b, c, d) >= 0 &&
+           crossVertices(p, c, a, d) >= 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// TRIANGLE CORNERS ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* The triangles are kept as corners, three to a triangle, each standing for 
+ * the side from its vertex to the vertex of the next corner round. Joining 
+ * two pieces across a side they share is then just relinking the corners 
+ * either side of it. Each diagonal (a side shared by two triangles) is kept as
+ * its two corners, one in each triangle.
+ */
+typedef struct triangleCorners{
+    int* vertex;
+    int* next;
+    int* prev;
+    int* diagonals;
+    int diagonalCount;
+}triangleCorners;
+
+/* The polygon still to be cut up while ear clipping: its vertices linked in 
+ * order, whether each is an ear, and the list of its reflex vertices (slot 
+ * gives each one's place in the list, or -1), the only ones which can be 
+ * inside an ear.
+ */
+typedef struct earList{
+    int* next;
+    int* prev;
+    int* ear;
+    int* reflex;
+    int* slot;
+    int reflexCount;
+}earList;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// EAR HELPERS ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* setReflex puts vertex v on the reflex list or takes it off, and 
+ * updateReflex does so by how v turns now. checkEar checks whether vertex b 
+ * is an ear: its corner turns anticlockwise and no reflex vertex left is 
+ * inside it (if any vertex is, one of those must be).
+ */
+static int setReflex(earList* e, int v, int reflex){
+    if(reflex && e->slot[v] < 0){
+        e->slot[v] = e->reflexCount;
+        e->reflex[e->reflexCount++] = v;
+    }
+    else if(!reflex && e->slot[v] >= 0){
+        //move the last one into its place
+        int last = e->reflex[--e->reflexCount];
+        e->reflex[e->slot[v]] = last;
+        e->slot[last] = e->slot[v];
+        e->slot[v] = -1;
+    }
+    return(EXIT_SUCCESS);
+}
+
+static int updateReflex(polygon* p, earList* e, int v){
+    return setReflex(e, v, crossVertices(p, e->prev[v], v, e->next[v]) <= 0);
+}
+
+static int checkEar(polygon* p, earList* e, int b){
+    int a = e->prev[b], c = e->next[b], i;
+    if(crossVertices(p, a, b, c) <= 0){
+        return 0;
+    }
+    for(i = 0; i < e->reflexCount; i++){
+        int d = e->reflex[i];
+        if(d != a && d != b && d != c && insideTriangle(p, a, b, c, d)){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// ADD TRIANGLE ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function adds triangle a, b, c as the given triangle's three corners.
+ * sideCorner gives, for each side from a vertex v to e->next[v] which has 
+ * already had a triangle cut off beyond it, the corner of that triangle on 
+ * the side, so those sides are recorded as diagonals.
+ */
+static int addTriangle(triangleCorners* t, earList* e, int* sideCorner, 
+        int triangle, int a, int b, int c){
+    int corners[3] = {a, b, c};
+    int i;
+    for(i = 0; i < 3; i++){
+        int corner = triangle*3 + i;
+        t->vertex[corner] = corners[i];
+        t->next[corner] = triangle*3 + (i+1)%3;
+        t->prev[corner] = triangle*3 + (i+2)%3;
+        int far = sideCorner[corners[i]];
+        if(far >= 0 && e->next[corners[i]] == corners[(i+1)%3]){
+            t->diagonals[t->diagonalCount*2] = corner;
+            t->diagonals[t->diagonalCount*2+1] = far;
+            t->diagonalCount++;
+        }
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// TRIANGULATE ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function cuts a polygon of count vertices into count-2 triangles by ear
+ * clipping: a corner which turns the right way, and has no other vertex 
+ * inside it, can be cut off as a triangle, leaving a smaller polygon. The 
+ * triangles are put in t, anticlockwise, with the diagonals between them.
+ * 
+ * Whether each vertex is an ear is worked out once, and after that only for 
+ * the two neighbours of each ear cut off, as no other vertex changes.
+ */
+static int triangulate(polygon* p, int count, triangleCorners* t){
+    earList e;
+    e.next = malloc(sizeof(int)*count);
+    e.prev = malloc(sizeof(int)*count);
+    e.ear = malloc(sizeof(int)*count);
+    e.reflex = malloc(sizeof(int)*count);
+    e.slot = malloc(sizeof(int)*count);
+    e.reflexCount = 0;
+    int* sideCorner = malloc(sizeof(int)*count);
+    int i;
+    
+    //work anticlockwise, whichever way the polygon goes
+    double area = 0;
+    for(i = 0; i < count; i++){
+        vector* a = p->vertices[i];
+        vector* b = p->vertices[(i+1)%count];
+        area += a->x*b->y - b->x*a->y;
+    }
+    int step = (area > 0) ? 1 : count-1;
+    for(i = 0; i < count; i++){
+        e.next[i] = (i+step)%count;
+        e.prev[(i+step)%count] = i;
+        e.slot[i] = -1;
+        sideCorner[i] = -1;
+    }
+    for(i = 0; i < count; i++){
+        updateReflex(p, &e, i);
+    }
+    for(i = 0; i < count; i++){
+        e.ear[i] = checkEar(p, &e, i);
+    }
+    
+    int left = count, found = 0, passed = 0, b = 0;
+    t->diagonalCount = 0;
+    while(left > 3){
+        //a polygon which crosses itself may have no ears: once round without
+        //finding one, cut off any corner so the split still finishes
+        if(e.ear[b] == 0 && passed < left){
+            b = e.next[b];
+            passed++;
+            continue;
+        }
+        int a = e.prev[b], c = e.next[b];
+        addTriangle(t, &e, sideCorner, found++, a, b, c);
+        
+        //the side from a now goes to c, with the new triangle beyond it
+        e.next[a] = c;
+        e.prev[c] = a;
+        sideCorner[a] = (found-1)*3 + 2;
+        setReflex(&e, b, 0);
+        left--;
+        
+        updateReflex(p, &e, a);
+        updateReflex(p, &e, c);
+        e.ear[a] = checkEar(p, &e, a);
+        e.ear[c] = checkEar(p, &e, c);
+        b = c;
+        passed = 0;
+    }
+    addTriangle(t, &e, sideCorner, found++, e.prev[b], b, e.next[b]);
+    
+    free(e.next);
+    free(e.prev);
+    free(e.ear);
+    free(e.reflex);
+    free(e.slot);
+    free(sideCorner);
+    return found;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SPLIT PIECES ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reorders list[start] to list[end-1] so that the piece at 
+ * middle is the one which would be there if they were sorted by their centres
+ * along the axis (0 for x, 1 for y), with none further along before it and 
+ * none less far along after it. This is all the tree needs, and unlike a full
+ * sort takes time in proportion to the number of pieces.
+ */
+static int splitPieces(int* list, double* centres, int axis, int start, 
+        int end, int middle){
+    while(end - start > 1){
+        double pivot = centres[list[(start+end)/2]*2+axis];
+        int i = start, j = end-1;
+        while(i <= j){
+            while(centres[list[i]*2+axis] < pivot) i++;
+            while(centres[list[j]*2+axis] > pivot) j--;
+            if(i <= j){
+                int swap = list[i];
+                list[i] = list[j];
+                list[j] = swap;
+                i++;
+                j--;
+            }
+        }
+        //carry on in whichever part the middle is in, unless it's between 
+        //them, with the pivot
+        if(middle <= j){
+            end = j+1;
+        }
+        else if(middle >= i){
+            start = i;
+        }
+        else{
+            break;
+        }
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD PIECE TREE ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function builds the bounding box tree over the pieces from list[start]
+ * to list[end-1], by splitting them in half across the wider direction of 
+ * their centres. Nodes are added to c->nodes with each parent before its 
+ * children, and the new node's index is returned.
+ */
+static int buildPieceTree(convexPieces* c, int* list, double* centres, 
+        int start, int end){
+    int node = c->nodeCount++;
+    
+    if(end - start == 1){
+        c->nodes[node].piece = list[start];
+        c->nodes[node].left = -1;
+        c->nodes[node].right = -1;
+        return node;
+    }
+    
+    //find which way the centres are spread widest
+    double minX = HUGE_VAL, maxX = -HUGE_VAL, minY = HUGE_VAL, maxY = -HUGE_VAL;
+    int i;
+    for(i = start; i < end; i++){
+        double x = centres[list[i]*2], y = centres[list[i]*2+1];
+        if(x < minX) minX = x;
+        if(x > maxX) maxX = x;
+        if(y < minY) minY = y;
+        if(y > maxY) maxY = y;
+    }
+    int axis = (maxX - minX >= maxY - minY) ? 0 : 1;
+    
+    //split them in the middle along it
+    int middle = (start + end)/2;
+    splitPieces(list, centres, axis, start, end, middle);
+    
+    c->nodes[node].piece = -1;
+    c->nodes[node].left = buildPieceTree(c, list, centres, start, middle);
+    c->nodes[node].right = buildPieceTree(c, list, centres, middle, end);
+    return node;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD PIECES ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function builds the piece polygons and the tree for a set of pieces,
+ * from their vertex indices into the given vertices. Each piece is given its
+ * vertices clockwise, like every other polygon.
+ */
+static int buildPieces(convexPieces* c, vector** vertices){
+    int i, j;
+    c->pieces = malloc(sizeof(polygon*)*c->count);
+    double* centres = malloc(sizeof(double)*2*c->count);
+    
+    vector** v = malloc(sizeof(vector*)*(c->starts[c->count]+1));
+    for(i = 0; i < c->count; i++){
+        int size = c->starts[i+1] - c->starts[i];
+        for(j = 0; j < size; j++){
+            v[j] = vertices[c->indices[c->starts[i] + size-1-j]];
+        }
+        v[size] = NULL;
+        c->pieces[i] = buildPolygon(v);
+        centres[i*2] = c->pieces[i]->centre->x;
+        centres[i*2+1] = c->pieces[i]->centre->y;
+    }
+    free(v);
+    
+    int* list = malloc(sizeof(int)*c->count);
+    for(i = 0; i < c->count; i++){
+        list[i] = i;
+    }
+    c->nodes = calloc(2*c->count, sizeof(pieceNode));
+    c->nodeCount = 0;
+    buildPieceTree(c, list, centres, 0, c->count);
+    refitPieceTree(c);
+    
+    free(list);
+    free(centres);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// DECOMPOSE POLYGON //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function splits a polygon into convex pieces with the Hertel-Mehlhorn
+ * method, and returns them with their tree. Returns NULL if the polygon is 
+ * already convex (in which case it doesn't need splitting) or has fewer than
+ * three vertices.
+ */
+convexPieces* decomposePolygon(polygon* p){
+    int count, i;
+    for(count = 0; p->vertices[count] != NULL; count++);
+    if(count < 3 || checkIfConvex(p) == 1){
+        return NULL;
+    }
+    
+    //cut it into triangles, each a piece to start with
+    triangleCorners t;
+    int corners = 3*(count-2);
+    t.vertex = malloc(sizeof(int)*corners);
+    t.next = malloc(sizeof(int)*corners);
+    t.prev = malloc(sizeof(int)*corners);
+    t.diagonals = malloc(sizeof(int)*2*count);
+    int pieceCount = triangulate(p, count, &t);
+    
+    //take out each diagonal whose ends still turn the right way without it, 
+    //joining the pieces either side: at u the piece goes on into the other 
+    //piece, and at v comes back out of it
+    int* done = calloc(corners, sizeof(int));
+    int left = corners;
+    for(i = 0; i < t.diagonalCount; i++){
+        int uv = t.diagonals[i*2], vu = t.diagonals[i*2+1];
+        int u = t.vertex[uv], v = t.vertex[vu];
+        if(crossVertices(p, t.vertex[t.prev[uv]], u, 
+                t.vertex[t.next[t.next[vu]]]) < 0 ||
+                crossVertices(p, t.vertex[t.prev[vu]], v, 
+                t.vertex[t.next[t.next[uv]]]) < 0){
+            continue;
+        }
+        t.next[t.prev[uv]] = t.next[vu];
+        t.prev[t.next[vu]] = t.prev[uv];
+        t.next[t.prev[vu]] = t.next[uv];
+        t.prev[t.next[uv]] = t.prev[vu];
+        done[uv] = 1;
+        done[vu] = 1;
+        left -= 2;
+        pieceCount--;
+    }
+    
+    //store the pieces as one list of indices, going round each from any of 
+    //its corners
+    convexPieces* c = malloc(sizeof(convexPieces));
+    c->count = pieceCount;
+    c->starts = malloc(sizeof(int)*(pieceCount+1));
+    c->indices = malloc(sizeof(int)*left);
+    int piece = 0, size = 0;
+    for(i = 0; i < corners; i++){
+        if(done[i] == 1){
+            continue;
+        }
+        c->starts[piece++] = size;
+        int corner = i;
+        do{
+            c->indices[size++] = t.vertex[corner];
+            done[corner] = 1;
+            corner = t.next[corner];
+        }while(corner != i);
+    }
+    c->starts[pieceCount] = size;
+    free(done);
+    free(t.vertex);
+    free(t.next);
+    free(t.prev);
+    free(t.diagonals);
+    
+    buildPieces(c, p->vertices);
+    return c;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// ATTACH CONVEX PIECES ///////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function splits a polygon into convex pieces and keeps them with it,
+ * so collision checks use them from then on. Returns the number of pieces, or
+ * 0 if the polygon is convex and needs none.
+ */
+int attachConvexPieces(polygon* p){
+    if(p->pieces != NULL){
+        freeConvexPieces(p->pieces);
+    }
+    p->pieces = decomposePolygon(p);
+    return (p->pieces != NULL) ? p->pieces->count : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET CONVEX PIECES //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function returns a polygon's convex pieces, or NULL for a polygon 
+ * which hasn't been split.
+ */
+convexPieces* getConvexPieces(polygon* p){
+    return p->pieces;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// COPY CONVEX PIECES /////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function makes the same pieces for a copy of a polygon, using the 
+ * copy's vertices. The split itself isn't redone.
+ */
+convexPieces* copyConvexPieces(convexPieces* c, vector** vertices){
+    convexPieces* copy = malloc(sizeof(convexPieces));
+    copy->count = c->count;
+    copy->starts = malloc(sizeof(int)*(c->count+1));
+    memcpy(copy->starts, c->starts, sizeof(int)*(c->count+1));
+    copy->indices = malloc(sizeof(int)*c->starts[c->count]);
+    memcpy(copy->indices, c->indices, sizeof(int)*c->starts[c->count]);
+    
+    buildPieces(copy, vertices);
+    return copy;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// REFIT PIECE TREE ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function updates every box in the tree to fit the pieces as they are 
+ * now. Children always come after their parents, so going through the nodes
+ * backwards fits every child before its parent.
+ * 
+ * Boxes are only stored if they have changed, so the tree of a polygon which
+ * hasn't moved is never written to, and can be checked by several threads at
+ * once.
+ */
+int refitPieceTree(convexPieces* c){
+    int i;
+    for(i = c->nodeCount-1; i >= 0; i--){
+        pieceNode* n = &c->nodes[i];
+        bounds box;
+        if(n->piece >= 0){
+            getPolygonBounds(c->pieces[n->piece], &box);
+        }
+        else{
+            bounds* l = &c->nodes[n->left].box;
+            bounds* r = &c->nodes[n->right].box;
+            box.minX = (l->minX < r->minX) ? l->minX : r->minX;
+            box.minY = (l->minY < r->minY) ? l->minY : r->minY;
+            box.maxX = (l->maxX > r->maxX) ? l->maxX : r->maxX;
+            box.maxY = (l->maxY > r->maxY) ? l->maxY : r->maxY;
+        }
+        if(box.minX != n->box.minX || box.minY != n->box.minY ||
+                box.maxX != n->box.maxX || box.maxY != n->box.maxY){
+            n->box = box;
+        }
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FREE CONVEX PIECES /////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function frees a set of pieces. The pieces' vertices belong to the 
+ * polygon they were split from, so are left alone.
+ */
+int freeConvexPieces(convexPieces* c){
+    int i;
+    for(i = 0; i < c->count; i++){
+        if(c->pieces[i]->normals != NULL){
+            freeNormalTable(c->pieces[i]->normals);
+        }
+        free(c->pieces[i]->vertices);
+        free(c->pieces[i]->transform->translation);
+        free(c->pieces[i]->transform);
+        free(c->pieces[i]->centre);
+        free(c->pieces[i]);
+    }
+    free(c->pieces);
+    free(c->indices);
+    free(c->starts);
+    free(c->nodes);
+    free(c);
+    return(EXIT_SUCCESS);
+}
@@ -0,0 +1,45 @@
+/* 
+ * File:   decompose.h
+ *
+ * This header file externalises the functions in the decompose.c file, which
+ * splits concave polygons into convex pieces for collision checks.
+ * 
+ * For further details on any function, check there.
+ */
+
+#ifndef DECOMPOSE_H
+#define DECOMPOSE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct pieceNode{
+    bounds box;
+    int left;
+    int right;
+    int piece;
+}pieceNode;
+
+typedef struct convexPieces{
+    int count;
+    polygon** pieces;
+    int* indices;
+    int* starts;
+    pieceNode* nodes;
+    int nodeCount;
+}convexPieces;
+
+convexPieces* decomposePolygon(polygon* p);
+int attachConvexPieces(polygon* p);
+convexPieces* getConvexPieces(polygon* p);
+convexPieces* copyConvexPieces(convexPieces* c, vector** vertices);
+int refitPieceTree(convexPieces* c);
+int freeConvexPieces(convexPieces* c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DECOMPOSE_H */
+
@@ -0,0 +1,433 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          DISTANCE
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to find how far apart two polygons are,
+ * and the closest points of each, using the Gilbert-Johnson-Keerthi (GJK)
+ * method.
+ *
+ * The distance between two convex polygons is the distance from the origin to
+ * the shape made by subtracting every point of one from every point of the
+ * other. GJK never builds this shape: it keeps a "simplex" of up to three of
+ * its corners, each the difference of one vertex of each polygon, and moves
+ * it towards the origin one corner at a time. The furthest corner in any
+ * direction is just the difference of the furthest vertices of the polygons
+ * in opposite directions (see findExtremeVertex in extreme.c).
+ *
+ * The simplex found is kept in the result, and can be passed back as a hint
+ * the next time the same pair is checked. When the polygons have only moved a
+ * little, the hint is already at or next to the answer and it is found again
+ * in one or two steps.
+ *
+ * Polygons split into convex pieces are measured piece by piece, and the
+ * closest pair of pieces gives the result. A concave polygon that hasn't been
+ * split is measured by its convex hull, so the distance may be less than its
+ * true distance, but never more.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vector.h"
+#include "polygon.h"
+#include "decompose.h"
+#include "extreme.h"
+#include "distance.h"
+
+//the most steps taken to move the simplex towards the origin
+#define MAX_GJK_STEPS 100
+
+typedef struct simplexPoint{
+    double ax, ay;
+    double bx, by;
+    double wx, wy;
+    double weight;
+    int indexA;
+    int indexB;
+}simplexPoint;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SIMPLEX POINTS /////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function makes a corner of the simplex from vertex i of a and vertex j
+ * of b.
+ */
+static int setSimplexPoint(simplexPoint* s, polygon* a, polygon* b, int i,
+        int j){
+    s->indexA = i;
+    s->indexB = j;
+    s->ax = a->vertices[i]->x;
+    s->ay = a->vertices[i]->y;
+    s->bx = b->vertices[j]->x;
+    s->by = b->vertices[j]->y;
+    s->wx = s->ax - s->bx;
+    s->wy = s->ay - s->by;
+    s->weight = 1;
+    return(EXIT_SUCCESS);
+}
+
+static double cross(double ax, double ay, double bx, double by){
+    return ax*by - ay*bx;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SOLVE SIMPLEX //////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* These functions find the point of the simplex closest to the origin, as a
+ * weighted sum of its corners, and drop the corners that don't add to it.
+ * They return the number of corners left. A triangle is only kept if it
+ * surrounds the origin, which means the polygons overlap.
+ */
+static int solveLine(simplexPoint* s){
+    double ex = s[1].wx - s[0].wx, ey = s[1].wy - s[0].wy;
+
+    //the origin is beyond the first corner
+    double toSecond = -(s[0].wx*ex + s[0].wy*ey);
+    if(toSecond <= 0){
+        s[0].weight = 1;
+        return 1;
+    }
+
+    //or beyond the second
+    double toFirst = s[1].wx*ex + s[1].wy*ey;
+    if(toFirst <= 0){
+        s[0] = s[1];
+        s[0].weight = 1;
+        return 1;
+    }
+
+    //or beside the line between them
+    s[0].weight = toFirst/(toFirst + toSecond);
+    s[1].weight = toSecond/(toFirst + toSecond);
+    return 2;
+}
+
+static int solveTriangle(simplexPoint* s){
+    double e12x = s[1].wx - s[0].wx, e12y = s[1].wy - s[0].wy;
+    double e13x = s[2].wx - s[0].wx, e13y = s[2].wy - s[0].wy;
+    double e23x = s[2].wx - s[1].wx, e23y = s[2].wy - s[1].wy;
+
+    //the weights each corner would have on the three lines
+    double d12First = s[1].wx*e12x + s[1].wy*e12y;
+    double d12Second = -(s[0].wx*e12x + s[0].wy*e12y);
+    double d13First = s[2].wx*e13x + s[2].wy*e13y;
+    double d13Second = -(s[0].wx*e13x + s[0].wy*e13y);
+    double d23First = s[2].wx*e23x + s[2].wy*e23y;
+    double d23Second = -(s[1].wx*e23x + s[1].wy*e23y);
+
+    //and in the triangle
+    double n = cross(e12x, e12y, e13x, e13y);
+    double d123First = n*cross(s[1].wx, s[1].wy, s[2].wx, s[2].wy);
+    double d123Second = n*cross(s[2].wx, s[2].wy, s[0].wx, s[0].wy);
+    double d123Third = n*cross(s[0].wx, s[0].wy, s[1].wx, s[1].wy);
+
+    if(d12Second <= 0 && d13Second <= 0){
+        s[0].weight = 1;
+        return 1;
+    }
+    if(d12First > 0 && d12Second > 0 && d123Third <= 0){
+        s[0].weight = d12First/(d12First + d12Second);
+        s[1].weight = d12Second/(d12First + d12Second);
+        return 2;
+    }
+    if(d13First > 0 && d13Second > 0 && d123Second <= 0){
+        s[0].weight = d13First/(d13First + d13Second);
+        s[2].weight = d13Second/(d13First + d13Second);
+        s[1] = s[2];
+        return 2;
+    }
+    if(d12First <= 0 && d23Second <= 0){
+        s[0] = s[1];
+        s[0].weight = 1;
+        return 1;
+    }
+    if(d13First <= 0 && d23First <= 0){
+        s[0] = s[2];
+        s[0].weight = 1;
+        return 1;
+    }
+    if(d23First > 0 && d23Second > 0 && d123First <= 0){
+        s[1].weight = d23First/(d23First + d23Second);
+        s[2].weight = d23Second/(d23First + d23Second);
+        s[0] = s[2];
+        return 2;
+    }
+
+    double total = d123First + d123Second + d123Third;
+    s[0].weight = d123First/total;
+    s[1].weight = d123Second/total;
+    s[2].weight = d123Third/total;
+    return 3;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET SEARCH DIRECTION ///////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds the direction from the simplex towards the origin. For
+ * a line, this is taken square to the line rather than from the closest point,
+ * which is more accurate when the origin is very near it.
+ */
+static int getSearchDirection(simplexPoint* s, int count, vector* d){
+    d->z = 0;
+    if(count == 1){
+        d->x = -s[0].wx;
+        d->y = -s[0].wy;
+        return(EXIT_SUCCESS);
+    }
+    double ex = s[1].wx - s[0].wx, ey = s[1].wy - s[0].wy;
+    if(cross(ex, ey, -s[0].wx, -s[0].wy) > 0){
+        d->x = -ey;
+        d->y = ex;
+    }
+    else{
+        d->x = ey;
+        d->y = -ex;
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FIND CONVEX CLEARANCE //////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function runs GJK for two convex polygons, starting from the simplex in
+ * start (if it has any corners) and stores the distance, closest points and
+ * final simplex in result.
+ */
+static int findConvexClearance(polygon* a, polygon* b, clearance* start,
+        clearance* result){
+    int countA = 0, countB = 0;
+    while(a->vertices[countA] != NULL){
+        countA++;
+    }
+    while(b->vertices[countB] != NULL){
+        countB++;
+    }
+
+    //start from the hint if its vertices are still there, or else anywhere
+    simplexPoint s[3];
+    int count = 0;
+    int i;
+    if(start != NULL){
+        for(i = 0; i < start->count; i++){
+            if(start->indexA[i] >= countA || start->indexB[i] >= countB){
+                count = 0;
+                break;
+            }
+            setSimplexPoint(&s[count++], a, b, start->indexA[i],
+                    start->indexB[i]);
+        }
+        //a triangle which has been squashed flat can't be solved
+        if(count == 3 && cross(s[1].wx - s[0].wx, s[1].wy - s[0].wy,
+                s[2].wx - s[0].wx, s[2].wy - s[0].wy) == 0){
+            count = 1;
+        }
+    }
+    if(count == 0){
+        setSimplexPoint(&s[0], a, b, 0, 0);
+        count = 1;
+    }
+
+    vector d, opposite;
+    int steps = 0;
+    while(steps < MAX_GJK_STEPS){
+        //remember the corners, to tell if the next one is new
+        int oldCount = count;
+        int oldA[3], oldB[3];
+        for(i = 0; i < count; i++){
+            oldA[i] = s[i].indexA;
+            oldB[i] = s[i].indexB;
+        }
+
+        if(count == 2){
+            count = solveLine(s);
+        }
+        else if(count == 3){
+            count = solveTriangle(s);
+        }
+
+        //the origin is inside, so the polygons overlap
+        if(count == 3){
+            break;
+        }
+
+        getSearchDirection(s, count, &d);
+        //the origin is on the simplex, so the polygons touch
+        if(d.x*d.x + d.y*d.y < 1e-24){
+            break;
+        }
+
+        //add the furthest corner towards the origin
+        opposite.x = -d.x;
+        opposite.y = -d.y;
+        opposite.z = 0;
+        int nextA = findExtremeVertex(a, &d);
+        int nextB = findExtremeVertex(b, &opposite);
+        steps++;
+
+        //if it is already in the simplex, no closer corner can be found
+        int repeated = 0;
+        for(i = 0; i < oldCount; i++){
+            if(oldA[i] == nextA && oldB[i] == nextB){
+                repeated = 1;
+            }
+        }
+        if(repeated){
+            break;
+        }
+        setSimplexPoint(&s[count++], a, b, nextA, nextB);
+    }
+
+    //the closest points are the weighted sums of the corners' vertices
+    double ax = 0, ay = 0, bx = 0, by = 0;
+    for(i = 0; i < count; i++){
+        ax += s[i].weight*s[i].ax;
+        ay += s[i].weight*s[i].ay;
+        bx += s[i].weight*s[i].bx;
+        by += s[i].weight*s[i].by;
+        result->indexA[i] = s[i].indexA;
+        result->indexB[i] = s[i].indexB;
+    }
+    if(count == 3){
+        //overlapping polygons have no distance, or separate closest points
+        bx = ax;
+        by = ay;
+    }
+    result->count = count;
+    result->pointA->x = ax;
+    result->pointA->y = ay;
+    result->pointB->x = bx;
+    result->pointB->y = by;
+    result->distance = sqrt((ax - bx)*(ax - bx) + (ay - by)*(ay - by));
+    result->iterations += steps;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FIND CLEARANCE /////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds the distance between two polygons, and the closest
+ * point on each. Polygons which touch or overlap are 0 apart.
+ *
+ * A hint, the result of an earlier check of the same pair (or NULL), is used
+ * as the starting point. The polygons can have moved since, but not changed
+ * shape.
+ *
+ * For polygons split into pieces, the pair of pieces closest in the hint is
+ * measured first, and any other pair whose boxes are further apart than the
+ * closest found so far is skipped.
+ */
+static double getBoxDistance(bounds* a, bounds* b){
+    double dx = 0, dy = 0;
+    if(a->maxX < b->minX){
+        dx = b->minX - a->maxX;
+    }
+    else if(b->maxX < a->minX){
+        dx = a->minX - b->maxX;
+    }
+    if(a->maxY < b->minY){
+        dy = b->minY - a->maxY;
+    }
+    else if(b->maxY < a->minY){
+        dy = a->minY - b->maxY;
+    }
+    return sqrt(dx*dx + dy*dy);
+}
+
+clearance* findClearance(polygon* a, polygon* b, clearance* hint){
+    clearance* result = malloc(sizeof(clearance));
+    result->pointA = createVector(0, 0, 0);
+    result->pointB = createVector(0, 0, 0);
+    result->count = 0;
+    result->pieceA = -1;
+    result->pieceB = -1;
+    result->iterations = 0;
+
+    convexPieces* piecesA = (a->pieces != NULL) ? getConvexPieces(a) : NULL;
+    convexPieces* piecesB = (b->pieces != NULL) ? getConvexPieces(b) : NULL;
+    if(piecesA == NULL && piecesB == NULL){
+        if(hint != NULL && (hint->pieceA != -1 || hint->pieceB != -1)){
+            hint = NULL;
+        }
+        findConvexClearance(a, b, hint, result);
+        return result;
+    }
+
+    int countA = (piecesA != NULL) ? piecesA->count : 1;
+    int countB = (piecesB != NULL) ? piecesB->count : 1;
+
+    //start with the pair of pieces the hint found closest
+    int firstA = 0, firstB = 0;
+    if(hint != NULL && hint->pieceA < countA && hint->pieceB < countB &&
+            (hint->pieceA >= 0) == (piecesA != NULL) &&
+            (hint->pieceB >= 0) == (piecesB != NULL)){
+        firstA = (hint->pieceA >= 0) ? hint->pieceA : 0;
+        firstB = (hint->pieceB >= 0) ? hint->pieceB : 0;
+    }
+    else{
+        hint = NULL;
+    }
+
+    clearance* pair = malloc(sizeof(clearance));
+    pair->pointA = createVector(0, 0, 0);
+    pair->pointB = createVector(0, 0, 0);
+    result->distance = HUGE_VAL;
+
+    int n, i, j;
+    for(n = -1; n < countA*countB && result->distance > 0; n++){
+        if(n == -1){
+            i = firstA;
+            j = firstB;
+        }
+        else{
+            i = n/countB;
+            j = n%countB;
+            if(i == firstA && j == firstB){
+                continue;
+            }
+        }
+        polygon* partA = (piecesA != NULL) ? piecesA->pieces[i] : a;
+        polygon* partB = (piecesB != NULL) ? piecesB->pieces[j] : b;
+
+        //only the first pair is started from the hint
+        clearance* start = NULL;
+        if(n == -1){
+            start = hint;
+        }
+        else{
+            bounds boxA, boxB;
+            getPolygonBounds(partA, &boxA);
+            getPolygonBounds(partB, &boxB);
+            if(getBoxDistance(&boxA, &boxB) >= result->distance){
+                continue;
+            }
+        }
+
+        pair->iterations = 0;
+        findConvexClearance(partA, partB, start, pair);
+        result->iterations += pair->iterations;
+        if(pair->distance < result->distance){
+            result->distance = pair->distance;
+            result->count = pair->count;
+            memcpy(result->indexA, pair->indexA, sizeof(pair->indexA));
+            memcpy(result->indexB, pair->indexB, sizeof(pair->indexB));
+            *result->pointA = *pair->pointA;
+            *result->pointB = *pair->pointB;
+            result->pieceA = (piecesA != NULL) ? i : -1;
+            result->pieceB = (piecesB != NULL) ? j : -1;
+        }
+    }
+
+    freeClearance(pair);
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FREE CLEARANCE /////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int freeClearance(clearance* c){
+    free(c->pointA);
+    free(c->pointB);
+    free(c);
+    return(EXIT_SUCCESS);
+}
@@ -0,0 +1,37 @@
+/* 
+ * File:   distance.h
+ *
+ * This header file externalises the functions in the distance.c file, which
+ * finds how far apart two polygons are and their closest points.
+ * 
+ * For further details on any function, check there.
+ */
+
+#ifndef DISTANCE_H
+#define DISTANCE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct clearance{
+    double distance;
+    vector* pointA;
+    vector* pointB;
+    int count;
+    int indexA[3];
+    int indexB[3];
+    int pieceA;
+    int pieceB;
+    int iterations;
+}clearance;
+
+clearance* findClearance(polygon* a, polygon* b, clearance* hint);
+int freeClearance(clearance* c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISTANCE_H */
+
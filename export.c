@@ -0,0 +1,379 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          EXPORT
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to draw polygons as an SVG image, wrapped
+ * in an HTML page so it can be opened in any browser.
+ *
+ * Only an area of the scene, the view, is drawn, scaled to fit the canvas, and
+ * only the polygons whose boxes reach into it are written. If the polygons are
+ * in a scene (see scene.c) its grid finds them, so a small view of a large
+ * scene is quick.
+ *
+ * Detail too small to see is left out: a vertex closer to the last one drawn
+ * than the given number of pixels is skipped, and a polygon smaller than that
+ * is drawn as a single pixel. Polygons of the same colour are drawn as one
+ * path, so the browser has a few dozen shapes to draw, not one per polygon,
+ * and the page opens even with millions of polygons.
+ *
+ * The page is built in a large buffer, which is written out whenever it is
+ * full, and numbers are written by hand with two decimal places, instead of
+ * calling fprintf for every vertex.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vector.h"
+#include "polygon.h"
+#include "broadphase.h"
+#include "parser.h"
+#include "scene.h"
+#include "export.h"
+
+//the size of the buffer the page is built in
+#define EXPORT_BUFFER_SIZE (1 << 20)
+
+//the most a single vertex or tag adds to the buffer, so it can be written out
+//before it would overflow
+#define EXPORT_MARGIN 256
+
+//the number of colours used. Neighbouring polygons are given colours far apart
+//around the colour wheel
+#define EXPORT_COLOURS 64
+
+//coordinates are limited to this many pixels, so they always fit the buffer
+//and a browser can draw them
+#define EXPORT_LIMIT 1e9
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// EXPORT TYPE DEFINITIONS ////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* exportBuffer holds the part of the page not yet written out. exportPolygon
+ * is a polygon to be drawn, with its number and the colour picked by it.
+ */
+typedef struct exportBuffer{
+    FILE* file;
+    char* text;
+    size_t length;
+    int failed;
+}exportBuffer;
+
+typedef struct exportPolygon{
+    polygon* shape;
+    int number;
+    int colour;
+}exportPolygon;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FLUSH BUFFER ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function writes out everything in the buffer, and empties it.
+ */
+static int flushBuffer(exportBuffer* b){
+    if(b->length > 0 && fwrite(b->text, 1, b->length, b->file) != b->length){
+        b->failed = 1;
+    }
+    b->length = 0;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// ADD TEXT ///////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* These functions add to the buffer: addText adds a string, and addNumber adds
+ * a number with two decimal places (so to within a hundredth of a pixel), with
+ * no trailing zeros. Each first makes sure there is room for EXPORT_MARGIN
+ * more characters.
+ */
+static int makeRoom(exportBuffer* b){
+    if(b->length + EXPORT_MARGIN > EXPORT_BUFFER_SIZE){
+        flushBuffer(b);
+    }
+    return(EXIT_SUCCESS);
+}
+
+static int addText(exportBuffer* b, const char* text){
+    size_t length = strlen(text);
+    if(b->length + length > EXPORT_BUFFER_SIZE){
+        flushBuffer(b);
+        if(length > EXPORT_BUFFER_SIZE){
+            fwrite(text, 1, length, b->file);
+            return(EXIT_SUCCESS);
+        }
+    }
+    memcpy(b->text + b->length, text, length);
+    b->length += length;
+    return(EXIT_SUCCESS);
+}
+
+static int addNumber(exportBuffer* b, double value){
+    char digits[24];
+    char* c = b->text + b->length;
+    if(value < 0){
+        *c++ = '-';
+        value = -value;
+    }
+    unsigned long long hundredths = (unsigned long long)(value*100 + 0.5);
+    unsigned long long whole = hundredths/100;
+    int fraction = (int)(hundredths%100);
+
+    //the whole part, written backwards and then copied in order
+    int count = 0;
+    do{
+        digits[count++] = (char)('0' + whole%10);
+        whole = whole/10;
+    }while(whole > 0);
+    while(count > 0){
+        *c++ = digits[--count];
+    }
+    if(fraction > 0){
+        *c++ = '.';
+        *c++ = (char)('0' + fraction/10);
+        if(fraction%10 != 0){
+            *c++ = (char)('0' + fraction%10);
+        }
+    }
+    b->length = c - b->text;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET PIXEL //////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds where a point of the scene is drawn on the canvas, in
+ * pixels, kept within the limits a browser can draw.
+ */
+static int getPixel(exportView* view, double scale, vector* v, double* x,
+        double* y){
+    *x = (v->x - view->area.minX)*scale;
+    *y = (v->y - view->area.minY)*scale;
+    *x = (*x > EXPORT_LIMIT) ? EXPORT_LIMIT :
+            ((*x < -EXPORT_LIMIT) ? -EXPORT_LIMIT : *x);
+    *y = (*y > EXPORT_LIMIT) ? EXPORT_LIMIT :
+            ((*y < -EXPORT_LIMIT) ? -EXPORT_LIMIT : *y);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// ADD POLYGON ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function adds one polygon to the path being written, as a closed part
+ * of it. Vertices within the view's detail of the last one drawn are skipped,
+ * and a polygon whose box is smaller than that is drawn as a single pixel.
+ */
+static int addPolygon(exportBuffer* b, exportView* view, double scale,
+        polygon* p){
+    //polygons replaced by their hull are drawn as their original shape
+    if(p->original != NULL){
+        p = p->original;
+    }
+    if(p->vertices[0] == NULL){
+        return(EXIT_SUCCESS);
+    }
+
+    bounds box;
+    getPolygonBounds(p, &box);
+    double x, y;
+    getPixel(view, scale, p->vertices[0], &x, &y);
+    makeRoom(b);
+    addText(b, "M");
+    addNumber(b, x);
+    addText(b, " ");
+    addNumber(b, y);
+    if((box.maxX - box.minX)*scale <= view->detail &&
+            (box.maxY - box.minY)*scale <= view->detail){
+        addText(b, "h1v1h-1z");
+        return(EXIT_SUCCESS);
+    }
+
+    double lastX = x, lastY = y;
+    double detail = view->detail*view->detail;
+    int i;
+    for(i = 1; p->vertices[i] != NULL; i++){
+        getPixel(view, scale, p->vertices[i], &x, &y);
+        double dx = x - lastX, dy = y - lastY;
+        if(dx*dx + dy*dy < detail && p->vertices[i+1] != NULL){
+            continue;
+        }
+        makeRoom(b);
+        addText(b, " ");
+        addNumber(b, x);
+        addText(b, " ");
+        addNumber(b, y);
+        lastX = x;
+        lastY = y;
+    }
+    addText(b, "z");
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FIND POLYGONS IN VIEW //////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function lists the polygons whose boxes reach into the view, in order,
+ * numbered from 1 as in the menu (or by their ids, for a scene). A scene's
+ * grid is used to find them, and the box each now has is checked against the
+ * view. Otherwise every polygon's box is checked. It returns how many there
+ * are.
+ */
+static int compareNumbers(const void* a, const void* b){
+    return ((const exportPolygon*)a)->number - ((const exportPolygon*)b)->number;
+}
+
+static int findPolygonsInView(polygon** list, scene* s, exportView* view,
+        exportPolygon** found){
+    int count = 0, i;
+    if(s != NULL){
+        int* ids = NULL;
+        int capacity = 0;
+        int near = gridQuery(s->grid, &view->area, &ids, &capacity);
+        *found = malloc(sizeof(exportPolygon)*(near+1));
+        for(i = 0; i < near; i++){
+            polygon* p = getScenePolygon(s, ids[i]);
+            bounds box;
+            getPolygonBounds(p, &box);
+            if(checkBoundsOverlap(&box, &view->area)){
+                (*found)[count].shape = p;
+                (*found)[count].number = ids[i];
+                count++;
+            }
+        }
+        free(ids);
+        qsort(*found, count, sizeof(exportPolygon), compareNumbers);
+        return count;
+    }
+
+    for(i = 0; list[i] != NULL; i++);
+    *found = malloc(sizeof(exportPolygon)*(i+1));
+    for(i = 0; list[i] != NULL; i++){
+        bounds box;
+        getPolygonBounds(list[i], &box);
+        if(checkBoundsOverlap(&box, &view->area)){
+            (*found)[count].shape = list[i];
+            (*found)[count].number = i+1;
+            count++;
+        }
+    }
+    return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SET VIEW TO FIT ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function sets a view's area to the box around every polygon in a list,
+ * so the whole scene is drawn. An empty list gets the canvas at 1:1.
+ */
+int setViewToFit(exportView* view, polygon** list){
+    int i;
+    view->area.minX = 0;
+    view->area.minY = 0;
+    view->area.maxX = view->width;
+    view->area.maxY = view->height;
+    for(i = 0; list[i] != NULL; i++){
+        bounds box;
+        getPolygonBounds(list[i], &box);
+        if(i == 0 || box.minX < view->area.minX){
+            view->area.minX = box.minX;
+        }
+        if(i == 0 || box.minY < view->area.minY){
+            view->area.minY = box.minY;
+        }
+        if(i == 0 || box.maxX > view->area.maxX){
+            view->area.maxX = box.maxX;
+        }
+        if(i == 0 || box.maxY > view->area.maxY){
+            view->area.maxY = box.maxY;
+        }
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// WRITE HTML /////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function writes the polygons in the view to an open file as an SVG
+ * image of the view's size in pixels, wrapped in an HTML shell. The view's
+ * area is scaled evenly to fit the canvas, with its minimum x and y at the top
+ * left. If a scene is given its polygons are drawn, using its grid, and the
+ * list is ignored: any polygon of it moved other than by applySceneChanges
+ * must have been refreshed in the grid first (see refreshScenePolygon).
+ * Otherwise the NULL-terminated list is drawn.
+ *
+ * Returns the number of polygons drawn, or -1 if the file couldn't be written.
+ */
+int writeHTML(FILE* file, polygon** list, scene* s, exportView* view){
+    exportBuffer b;
+    b.file = file;
+    b.text = malloc(EXPORT_BUFFER_SIZE);
+    b.length = 0;
+    b.failed = 0;
+
+    //the view is fitted to the canvas, keeping its shape
+    double width = view->area.maxX - view->area.minX;
+    double height = view->area.maxY - view->area.minY;
+    double scale = 1;
+    if(width > 0 && height > 0){
+        scale = fmin(view->width/width, view->height/height);
+    }
+
+    exportPolygon* found;
+    int count = findPolygonsInView(list, s, view, &found);
+
+    char text[EXPORT_MARGIN];
+    snprintf(text, sizeof(text), "<!DOCTYPE html>\n"
+            "<html>\n"
+            "<body>\n"
+            "\n"
+            "<svg height=\"%d\" width=\"%d\">\n", view->height, view->width);
+    addText(&b, text);
+
+    //the colours are spread evenly around the colour wheel. Polygon n has
+    //colour n*23 (so neighbours differ), taken modulo the colours. The
+    //polygons are then sorted by colour, keeping them in order within each
+    int starts[EXPORT_COLOURS+1];
+    int colour, i;
+    memset(starts, 0, sizeof(starts));
+    for(i = 0; i < count; i++){
+        found[i].colour = (int)(((unsigned)found[i].number*23u)%EXPORT_COLOURS);
+        starts[found[i].colour+1]++;
+    }
+    for(colour = 0; colour < EXPORT_COLOURS; colour++){
+        starts[colour+1] += starts[colour];
+    }
+    exportPolygon* sorted = malloc(sizeof(exportPolygon)*(count+1));
+    int next[EXPORT_COLOURS];
+    memcpy(next, starts, sizeof(next));
+    for(i = 0; i < count; i++){
+        sorted[next[found[i].colour]++] = found[i];
+    }
+
+    //one path for each colour
+    for(colour = 0; colour < EXPORT_COLOURS; colour++){
+        if(starts[colour] == starts[colour+1]){
+            continue;
+        }
+        snprintf(text, sizeof(text), "    <path style=\"fill:none;"
+                "stroke:hsl(%d,80%%,%d%%);stroke-width:2\" d=\"",
+                colour*360/EXPORT_COLOURS, 30 + 15*(colour%2));
+        addText(&b, text);
+        for(i = starts[colour]; i < starts[colour+1]; i++){
+            addPolygon(&b, view, scale, sorted[i].shape);
+        }
+        addText(&b, "\" />\n");
+    }
+
+    //finish the file, including a note for if SVG is not supported
+    addText(&b, "Your browser does not support inline SVG.\n"
+            "</svg>\n"
+            "<div>Generated by Collision Checker\n"
+            "</body>\n"
+            "</html>");
+    flushBuffer(&b);
+
+    free(b.text);
+    free(found);
+    free(sorted);
+    return (b.failed == 1) ? -1 : count;
+}
@@ -0,0 +1,35 @@
+/*
+ * File:   export.h
+ *
+ * This header file externalises the functions in the export.c file, which
+ * draws polygons as an SVG image in an HTML page.
+ *
+ * For further details on any function, check there.
+ */
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct scene;
+
+//what to draw: the size of the canvas in pixels, the area of the scene shown
+//on it, and the smallest detail drawn, in pixels
+typedef struct exportView{
+    int width;
+    int height;
+    bounds area;
+    double detail;
+}exportView;
+
+int setViewToFit(exportView* view, polygon** list);
+int writeHTML(FILE* file, polygon** list, struct scene* s, exportView* view);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EXPORT_H */
@@ -0,0 +1,308 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          EXTREME VERTICES
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to project polygons onto an axis, which is
+ * the main cost of every separating axis check.
+ *
+ * A polygon's projection runs from its lowest to its highest vertex along the
+ * axis. For most polygons these are found by checking every vertex, but for a
+ * large convex polygon they can be found much more quickly. Going round a
+ * convex polygon the directions of its edges only ever turn one way, a full
+ * turn in all, so the vertex furthest along any direction is the one where
+ * the edges turn past that direction. A table of the edge angles, in order,
+ * lets this vertex be found by a binary search.
+ *
+ * The table is made the first time a large polygon is projected, and kept, as
+ * a polygon's shape never changes. Moving or scaling the polygon
+ * doesn't change its edge angles, and rotating it turns all of them by the
+ * same amount, which is found from one edge when the table is used.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vector.h"
+#include "polygon.h"
+#include "extreme.h"
+
+//polygons with fewer vertices than this are quicker to project by checking
+//every vertex than by searching the table
+#define EXTREME_MIN_VERTICES 32
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD NORMAL TABLE /////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function makes the table of edge angles for a polygon of count
+ * vertices. Angle i is the direction of the edge from vertex i to vertex i+1,
+ * made to increase going round the polygon whichever way its vertices go, with
+ * an extra angle one full turn after the first at the end.
+ *
+ * Edges of no length take the angle of the edge before. If the edges ever turn
+ * back, or don't make exactly one full turn, the polygon isn't convex and the
+ * table is marked so it isn't used.
+ */
+static normalTable* buildNormalTable(polygon* p, int count){
+    normalTable* t = malloc(sizeof(normalTable));
+    t->count = count;
+    t->angles = malloc(sizeof(double)*(count+1));
+    t->convex = 1;
+    t->reference = -1;
+
+    //the sign of the area tells which way round the vertices go
+    double area = 0;
+    int i;
+    for(i = 0; i < count; i++){
+        vector* a = p->vertices[i];
+        vector* b = p->vertices[(i+1)%count];
+        area += a->x*b->y - b->x*a->y;
+        if(t->reference < 0 && (a->x != b->x || a->y != b->y)){
+            t->reference = i;
+        }
+    }
+    t->sign = (area > 0) ? 1 : -1;
+    if(area == 0 || t->reference < 0){
+        t->convex = 0;
+        return t;
+    }
+
+    vector* s = p->vertices[t->reference];
+    vector* e = p->vertices[(t->reference+1)%count];
+    double previous = t->sign*atan2(e->y - s->y, e->x - s->x);
+    double first = previous;
+    double angle = previous;
+    for(i = 0; i < count; i++){
+        s = p->vertices[i];
+        e = p->vertices[(i+1)%count];
+        if(s->x != e->x || s->y != e->y){
+            double current = t->sign*atan2(e->y - s->y, e->x - s->x);
+            double turn = remainder(current - previous, 2*M_PI);
+            if(turn < -1e-9){
+                t->convex = 0;
+            }
+            angle += (turn > 0) ? turn : 0;
+            previous = current;
+        }
+        t->angles[i] = angle;
+    }
+
+    //the turn from the last edge back to the first completes the polygon
+    double closing = remainder(first - previous, 2*M_PI);
+    if(closing < -1e-9 ||
+            fabs(angle + ((closing > 0) ? closing : 0) - t->angles[0] - 2*M_PI)
+            > 1e-6){
+        t->convex = 0;
+    }
+    t->angles[count] = t->angles[0] + 2*M_PI;
+
+    return t;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// ATTACH NORMAL TABLE ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function makes the table of edge angles for a polygon and keeps it with
+ * the polygon, unless it has one already. Polygons with too few vertices to
+ * benefit are left without one.
+ *
+ * A polygon shared between threads can be projected on several at once, so a
+ * new table is only kept if another thread hasn't just kept one.
+ *
+ * Returns 1 if the polygon has a table it can use, 0 if not.
+ */
+int attachNormalTable(polygon* p){
+    int count = 0;
+    while(p->vertices[count] != NULL){
+        count++;
+    }
+    if(count < EXTREME_MIN_VERTICES){
+        return 0;
+    }
+
+    normalTable* t = buildNormalTable(p, count);
+    if(!__sync_bool_compare_and_swap(&p->normals, NULL, t)){
+        freeNormalTable(t);
+    }
+    return p->normals->convex;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// COPY NORMAL TABLE //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function makes a copy of a table for a copy of its polygon.
+ */
+normalTable* copyNormalTable(normalTable* t){
+    normalTable* copy = malloc(sizeof(normalTable));
+    memcpy(copy, t, sizeof(normalTable));
+    copy->angles = malloc(sizeof(double)*(t->count+1));
+    memcpy(copy->angles, t->angles, sizeof(double)*(t->count+1));
+    return copy;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FREE NORMAL TABLE //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int freeNormalTable(normalTable* t){
+    free(t->angles);
+    free(t);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SEARCH NORMAL TABLE ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds the vertex of a convex polygon furthest along the axis
+ * (or furthest against it, if direction is -1) using its table.
+ *
+ * The furthest vertex is the one whose outward normals, either side, are
+ * either side of the axis, which is the vertex after the last edge whose
+ * angle is a quarter turn or less behind the axis. The angles are compared
+ * after turning the axis back by however much the polygon has been rotated
+ * since the table was made.
+ *
+ * Rounding can leave the search a vertex out where two are almost equally far
+ * along, so the answer is then walked to the furthest of its neighbours,
+ * which gives exactly the same projection as checking every vertex.
+ */
+static int searchNormalTable(polygon* p, normalTable* t, vector* axis,
+        int direction){
+    int n = t->count;
+
+    //find how far the polygon has turned using its reference edge
+    vector* s = p->vertices[t->reference];
+    vector* e = p->vertices[(t->reference+1)%n];
+    double turned = t->sign*atan2(e->y - s->y, e->x - s->x) -
+            t->angles[t->reference];
+
+    double target = t->sign*atan2(direction*axis->y, direction*axis->x) +
+            M_PI/2 - turned;
+    target = t->angles[0] + fmod(target - t->angles[0], 2*M_PI);
+    if(target < t->angles[0]){
+        target += 2*M_PI;
+    }
+
+    //find the last edge at or before the target
+    int low = 0, high = n-1;
+    while(low < high){
+        int middle = (low + high + 1)/2;
+        if(t->angles[middle] <= target){
+            low = middle;
+        }
+        else{
+            high = middle - 1;
+        }
+    }
+    int best = (low+1)%n;
+
+    //walk to the furthest neighbour, in case rounding put the search one out.
+    //Repeated vertices are stepped over, so they can't stop the walk early
+    double bestProjection = direction*dotProduct(p->vertices[best], axis);
+    int steps;
+    for(steps = 0; steps < n; steps++){
+        int next = (best+1)%n;
+        while(next != best && p->vertices[next]->x == p->vertices[best]->x &&
+                p->vertices[next]->y == p->vertices[best]->y){
+            next = (next+1)%n;
+        }
+        int previous = (best+n-1)%n;
+        while(previous != best &&
+                p->vertices[previous]->x == p->vertices[best]->x &&
+                p->vertices[previous]->y == p->vertices[best]->y){
+            previous = (previous+n-1)%n;
+        }
+        double nextProjection = direction*dotProduct(p->vertices[next], axis);
+        double previousProjection =
+                direction*dotProduct(p->vertices[previous], axis);
+        if(nextProjection > bestProjection){
+            best = next;
+            bestProjection = nextProjection;
+        }
+        else if(previousProjection > bestProjection){
+            best = previous;
+            bestProjection = previousProjection;
+        }
+        else{
+            break;
+        }
+    }
+    return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET USABLE TABLE ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function returns a polygon's table if it has one and its polygon is
+ * convex, or NULL if every vertex should be checked instead.
+ */
+static normalTable* getUsableTable(polygon* p){
+    normalTable* t = p->normals;
+    if(t != NULL && t->convex){
+        return t;
+    }
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FIND EXTREME VERTEX ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function returns the index of the vertex of a polygon furthest along
+ * an axis.
+ */
+int findExtremeVertex(polygon* p, vector* axis){
+    normalTable* t = getUsableTable(p);
+    if(t != NULL){
+        return searchNormalTable(p, t, axis, 1);
+    }
+
+    int best = 0;
+    double bestProjection = dotProduct(p->vertices[0], axis);
+    int i;
+    for(i = 1; p->vertices[i] != NULL; i++){
+        double projection = dotProduct(p->vertices[i], axis);
+        if(projection > bestProjection){
+            best = i;
+            bestProjection = projection;
+        }
+    }
+    return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET PROJECTION RANGE ///////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds the lowest and highest projections of a polygon's
+ * vertices onto an axis.
+ *
+ * Large convex polygons are projected with their table, in time that grows
+ * with the logarithm of their number of vertices. Others have every vertex
+ * checked, and a large polygon checked this way is given a table for next
+ * time.
+ */
+int getProjectionRange(polygon* p, vector* axis, double* min, double* max){
+    normalTable* t = getUsableTable(p);
+    if(t != NULL){
+        *max = dotProduct(p->vertices[searchNormalTable(p, t, axis, 1)], axis);
+        *min = dotProduct(p->vertices[searchNormalTable(p, t, axis, -1)], axis);
+        return(EXIT_SUCCESS);
+    }
+
+    *min = dotProduct(p->vertices[0], axis);
+    *max = *min;
+    int i;
+    for(i = 1; p->vertices[i] != NULL; i++){
+        double projection = dotProduct(p->vertices[i], axis);
+        if(projection < *min){
+            *min = projection;
+        }
+        if(projection > *max){
+            *max = projection;
+        }
+    }
+
+    //concave polygons keep a table, marked unusable, so this is only done once
+    if(i >= EXTREME_MIN_VERTICES && p->normals == NULL){
+        attachNormalTable(p);
+    }
+    return(EXIT_SUCCESS);
+}
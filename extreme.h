@@ -0,0 +1,36 @@
+/*
+ * File:   extreme.h
+ *
+ * This header file externalises the functions in the extreme.c file, which
+ * finds the projections of polygons onto axes.
+ *
+ * For further details on any function, check there.
+ */
+
+#ifndef EXTREME_H
+#define EXTREME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct normalTable{
+    int count;
+    int convex;
+    double sign;
+    int reference;
+    double* angles;
+}normalTable;
+
+int attachNormalTable(polygon* p);
+normalTable* copyNormalTable(normalTable* t);
+int freeNormalTable(normalTable* t);
+int findExtremeVertex(polygon* p, vector* axis);
+int getProjectionRange(polygon* p, vector* axis, double* min, double* max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EXTREME_H */
+
@@ -0,0 +1,409 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          HULL
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to find the convex hull of a polygon (the
+ * smallest convex polygon containing it) and to find the tightest shapes 
+ * around a polygon directly, without the step-by-step search of findMinScale:
+ * 
+ *  - the smallest-area rectangle, at any rotation, that contains a polygon
+ *  - the smallest scale of a convex bound, about its centre, that contains a
+ *    polygon
+ * 
+ * Both work from the hull with "rotating calipers": as the edges of one shape
+ * are stepped through in order, the furthest vertex of the other in each
+ * edge's direction only ever moves forwards, so it is found by stepping on
+ * from the last one rather than searching every vertex. After the hull is
+ * found (O(n log n)) each answer takes O(n) time.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vector.h"
+#include "polygon.h"
+#include "hull.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// HULL HELPERS ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* comparePoints sorts points for qsort from left to right, then bottom to top.
+ * turnDirection is positive if o->a->b turns anticlockwise, negative if it
+ * turns clockwise, and 0 if the three are in a line.
+ */
+static int comparePoints(const void* a, const void* b){
+    const vector* p = *(vector* const*)a;
+    const vector* q = *(vector* const*)b;
+    if(p->x != q->x){
+        return (p->x > q->x) - (p->x < q->x);
+    }
+    return (p->y > q->y) - (p->y < q->y);
+}
+
+static double turnDirection(vector* o, vector* a, vector* b){
+    return (a->x - o->x)*(b->y - o->y) - (a->y - o->y)*(b->x - o->x);
+}
+
+/* This function finds the signed area of a list of points: positive if they
+ * run anticlockwise and negative if clockwise.
+ */
+static double getSignedArea(vector* points[], int count){
+    double area = 0;
+    int i;
+    for(i = 0; i < count; i++){
+        vector* a = points[i];
+        vector* b = points[(i+1)%count];
+        area += a->x*b->y - b->x*a->y;
+    }
+    return area/2;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET CONVEX HULL ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds the convex hull of a list of points with the "monotone
+ * chain" method: the points are sorted from left to right, then the lower and
+ * upper halves of the hull are each built in one pass, dropping any point that
+ * would make the hull turn the wrong way.
+ * 
+ * The hull's points are put in hull (which needs room for count+1 pointers) 
+ * clockwise, like the rest of the program's polygons, and NULL-terminated. 
+ * They point to the original vectors rather than copies. Points in a line 
+ * along an edge are left out. Returns the number of points in the hull.
+ */
+int getConvexHull(vector* points[], int count, vector* hull[]){
+    if(count < 3){
+        int i;
+        for(i = 0; i < count; i++){
+            hull[i] = points[i];
+        }
+        hull[count] = NULL;
+        return count;
+    }
+    
+    vector** sorted = malloc(sizeof(vector*)*count);
+    vector** chain = malloc(sizeof(vector*)*(2*count));
+    memcpy(sorted, points, sizeof(vector*)*count);
+    qsort(sorted, count, sizeof(vector*), comparePoints);
+    
+    //build the lower half from left to right, then the upper half back from
+    //right to left, which gives the hull anticlockwise
+    int k = 0, i, lowerSize;
+    for(i = 0; i < count; i++){
+        while(k >= 2 && turnDirection(chain[k-2], chain[k-1], sorted[i]) <= 0){
+            k--;
+        }
+        chain[k++] = sorted[i];
+    }
+    lowerSize = k+1;
+    for(i = count-2; i >= 0; i--){
+        while(k >= lowerSize && 
+                turnDirection(chain[k-2], chain[k-1], sorted[i]) <= 0){
+            k--;
+        }
+        chain[k++] = sorted[i];
+    }
+    //the last point is the first again
+    k--;
+    
+    //reverse it to make it clockwise
+    for(i = 0; i < k; i++){
+        hull[i] = chain[k-1-i];
+    }
+    hull[k] = NULL;
+    
+    free(sorted);
+    free(chain);
+    return k;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD HULL POLYGON /////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function creates a new polygon from the convex hull of a polygon, with
+ * copies of its vertices, at the same scale and rotation.
+ */
+polygon* buildHullPolygon(polygon* p){
+    int count, i;
+    for(count = 0; p->vertices[count] != NULL; count++);
+    vector** hull = malloc(sizeof(vector*)*(count+1));
+    
+    //the hull's points are copied in place, as they are the polygon's own
+    count = getConvexHull(p->vertices, count, hull);
+    for(i = 0; i < count; i++){
+        hull[i] = createVector(hull[i]->x, hull[i]->y, hull[i]->z);
+    }
+    
+    polygon* newPoly = buildPolygon(hull);
+    free(hull);
+    newPoly->transform->scale = p->transform->scale;
+    newPoly->transform->rotationZ = p->transform->rotationZ;
+    return newPoly;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD HULL PROXY ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function creates the convex hull of a polygon to stand in for it in
+ * collision checks, which only work on convex polygons. The polygon is kept as
+ * the hull's original, and is moved, rotated and scaled with it so it can 
+ * still be exported, and is freed with it. This also turns a polygon whose 
+ * points are in any order (such as a scanned point cloud) into a clockwise 
+ * convex polygon, usually with far fewer vertices.
+ * 
+ * Returns NULL, leaving the polygon alone, if it has no area.
+ */
+polygon* buildHullProxy(polygon* p){
+    polygon* hull = buildHullPolygon(p);
+    if(hull->vertices[0] == NULL || hull->vertices[1] == NULL || 
+            hull->vertices[2] == NULL){
+        freePolygon(hull);
+        return NULL;
+    }
+    hull->original = p;
+    return hull;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CALIPER HELPERS ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function projects point i of a hull onto the direction (dx, dy).
+ */
+static double projectPoint(vector* hull[], int i, double dx, double dy){
+    return hull[i]->x*dx + hull[i]->y*dy;
+}
+
+/* This function steps a caliper forward around a hull of count points from
+ * point i, for as long as the next point is further in direction (dx, dy), and
+ * returns the furthest point. Over a whole turn of the calipers each one only
+ * goes round the hull once, which is what makes them O(n).
+ */
+static int advanceCaliper(vector* hull[], int count, int i, double dx, double dy){
+    int steps;
+    for(steps = 0; steps < count; steps++){
+        int next = (i+1)%count;
+        if(projectPoint(hull, next, dx, dy) < projectPoint(hull, i, dx, dy)){
+            break;
+        }
+        i = next;
+    }
+    return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FIND MIN AREA RECTANGLE ////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds the rectangle of smallest area, at any rotation, that
+ * contains a polygon. The smallest rectangle always has one side along an
+ * edge of the polygon's hull, so each hull edge is tried in turn. For each 
+ * one, three calipers hold the furthest hull points along the edge, back 
+ * along it, and away from it, which give the other three sides.
+ * 
+ * The result holds the rectangle's centre, its width (along the edge it 
+ * lies on) and height, the angle of that edge in degrees from the x axis, and
+ * its four corners clockwise. Returns NULL if the polygon has no area.
+ */
+orientedBox* findMinAreaRectangle(polygon* p){
+    int count;
+    for(count = 0; p->vertices[count] != NULL; count++);
+    vector** hull = malloc(sizeof(vector*)*(count+1));
+    count = getConvexHull(p->vertices, count, hull);
+    if(count < 3){
+        free(hull);
+        return NULL;
+    }
+    
+    double bestArea = HUGE_VAL;
+    double bestUx = 0, bestUy = 0, bestMinU = 0, bestMaxU = 0, bestMinW = 0, 
+            bestMaxW = 0;
+    int forward = -1, back = -1, across = -1;
+    int i, j;
+    
+    for(i = 0; i < count; i++){
+        //the unit direction of this edge, and the normal pointing into the hull
+        //(the hull is clockwise, so inwards is to the right of the edge)
+        double ux = hull[(i+1)%count]->x - hull[i]->x;
+        double uy = hull[(i+1)%count]->y - hull[i]->y;
+        double length = sqrt(ux*ux + uy*uy);
+        if(length == 0){
+            continue;
+        }
+        ux = ux/length;
+        uy = uy/length;
+        double wx = uy, wy = -ux;
+        
+        //the calipers start from a full search on the first edge, then only
+        //step forwards
+        if(forward < 0){
+            forward = back = across = i;
+            for(j = 0; j < count; j++){
+                if(projectPoint(hull, j, ux, uy) > projectPoint(hull, forward, ux, uy)){
+                    forward = j;
+                }
+                if(projectPoint(hull, j, -ux, -uy) > projectPoint(hull, back, -ux, -uy)){
+                    back = j;
+                }
+                if(projectPoint(hull, j, wx, wy) > projectPoint(hull, across, wx, wy)){
+                    across = j;
+                }
+            }
+        }
+        else{
+            forward = advanceCaliper(hull, count, forward, ux, uy);
+            across = advanceCaliper(hull, count, across, wx, wy);
+            back = advanceCaliper(hull, count, back, -ux, -uy);
+        }
+        
+        double minU = projectPoint(hull, back, ux, uy);
+        double maxU = projectPoint(hull, forward, ux, uy);
+        double minW = projectPoint(hull, i, wx, wy);
+        double maxW = projectPoint(hull, across, wx, wy);
+        double area = (maxU - minU)*(maxW - minW);
+        
+        if(area < bestArea){
+            bestArea = area;
+            bestUx = ux; bestUy = uy;
+            bestMinU = minU; bestMaxU = maxU;
+            bestMinW = minW; bestMaxW = maxW;
+        }
+    }
+    
+    //turn the best edge's projections back into a rectangle
+    orientedBox* box = malloc(sizeof(orientedBox));
+    double wx = bestUy, wy = -bestUx;
+    double u[4] = {bestMinU, bestMinU, bestMaxU, bestMaxU};
+    double w[4] = {bestMinW, bestMaxW, bestMaxW, bestMinW};
+    for(i = 0; i < 4; i++){
+        box->corners[i] = createVector(u[i]*bestUx + w[i]*wx, 
+                                       u[i]*bestUy + w[i]*wy, 0.0);
+    }
+    box->corners[4] = NULL;
+    
+    //the corners go round the same way as the hull along u and into it along
+    //w, which is clockwise - but check, in case of a reflected frame
+    if(getSignedArea(box->corners, 4) > 0){
+        vector* swap = box->corners[1];
+        box->corners[1] = box->corners[3];
+        box->corners[3] = swap;
+    }
+    
+    double midU = (bestMinU + bestMaxU)/2;
+    double midW = (bestMinW + bestMaxW)/2;
+    box->centre = createVector(midU*bestUx + midW*wx, midU*bestUy + midW*wy, 0.0);
+    box->width = bestMaxU - bestMinU;
+    box->height = bestMaxW - bestMinW;
+    box->area = bestArea;
+    box->angle = atan2(bestUy, bestUx)*180/M_PI;
+    
+    free(hull);
+    return box;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FREE ORIENTED BOX //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function frees a rectangle found by findMinAreaRectangle.
+ */
+int freeOrientedBox(orientedBox* box){
+    int i;
+    for(i = 0; box->corners[i] != NULL; i++){
+        free(box->corners[i]);
+    }
+    free(box->centre);
+    free(box);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FIND MIN SCALE EXACT ///////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds the smallest scale the convex outside polygon can be, 
+ * scaled about its centre at its current rotation, and still contain the
+ * inside polygon - the same answer as findMinScale, but exact and in a single
+ * pass rather than by shrinking step by step.
+ * 
+ * Each edge of the outside polygon lies at some distance from its centre, 
+ * which grows in proportion to the scale. The inside polygon needs the edge
+ * at least as far out as its own furthest point in the edge's outward 
+ * direction, so each edge needs a scale of (furthest point)/(edge distance),
+ * and the answer is the largest of these. The outside polygon's edges are 
+ * already in order around the circle, so a single caliper on the inside
+ * polygon's hull finds every furthest point in O(n + m).
+ * 
+ * Returns the scale as a multiple of the original size (like findMinScale),
+ * or -1 if the outside polygon isn't convex or its centre isn't inside it.
+ * Touching counts as inside here, where findMinScale needs a small gap, so
+ * this is the limit that findMinScale approaches as the precision increases.
+ */
+double findMinScaleExact(polygon* polyInside, polygon* polyOutside){
+    if(checkIfConvex(polyOutside) != 1){
+        return -1;
+    }
+    
+    int count, outsideCount, i;
+    for(count = 0; polyInside->vertices[count] != NULL; count++);
+    vector** hull = malloc(sizeof(vector*)*(count+1));
+    count = getConvexHull(polyInside->vertices, count, hull);
+    for(outsideCount = 0; polyOutside->vertices[outsideCount] != NULL; 
+            outsideCount++);
+    if(count == 0 || outsideCount < 3){
+        free(hull);
+        return -1;
+    }
+    
+    //go round the outside polygon clockwise, the same way as the hull, so
+    //the caliper only moves forwards
+    vector** outside = malloc(sizeof(vector*)*outsideCount);
+    int clockwise = getSignedArea(polyOutside->vertices, outsideCount) < 0;
+    for(i = 0; i < outsideCount; i++){
+        outside[i] = polyOutside->vertices[clockwise ? i : outsideCount-1-i];
+    }
+    
+    vector* c = polyOutside->centre;
+    double scale = 0;
+    int support = -1;
+    for(i = 0; i < outsideCount; i++){
+        vector* a = outside[i];
+        vector* b = outside[(i+1)%outsideCount];
+        
+        //the outward normal of a clockwise edge is to its left
+        double nx = -(b->y - a->y);
+        double ny = b->x - a->x;
+        double length = sqrt(nx*nx + ny*ny);
+        if(length == 0){
+            continue;
+        }
+        nx = nx/length;
+        ny = ny/length;
+        
+        double edgeDistance = (a->x - c->x)*nx + (a->y - c->y)*ny;
+        if(edgeDistance <= 0){
+            free(hull);
+            free(outside);
+            return -1;
+        }
+        
+        if(support < 0){
+            support = 0;
+            int j;
+            for(j = 1; j < count; j++){
+                if(projectPoint(hull, j, nx, ny) > projectPoint(hull, support, nx, ny)){
+                    support = j;
+                }
+            }
+        }
+        else{
+            support = advanceCaliper(hull, count, support, nx, ny);
+        }
+        
+        double reach = projectPoint(hull, support, nx, ny) - (c->x*nx + c->y*ny);
+        if(reach/edgeDistance > scale){
+            scale = reach/edgeDistance;
+        }
+    }
+    
+    free(hull);
+    free(outside);
+    return scale*polyOutside->transform->scale;
+}
@@ -0,0 +1,38 @@
+/* 
+ * File:   hull.h
+ *
+ * This header file externalises the functions in the hull.c file, which finds
+ * the convex hull of a polygon and the tightest shapes that fit around it.
+ * 
+ * For further details on any function, check there.
+ */
+
+#ifndef HULL_H
+#define HULL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct orientedBox{
+    double angle;
+    double width;
+    double height;
+    double area;
+    vector* centre;
+    vector* corners[5];
+}orientedBox;
+
+int getConvexHull(vector* points[], int count, vector* hull[]);
+polygon* buildHullPolygon(polygon* p);
+polygon* buildHullProxy(polygon* p);
+orientedBox* findMinAreaRectangle(polygon* p);
+int freeOrientedBox(orientedBox* box);
+double findMinScaleExact(polygon* polyInside, polygon* polyOutside);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HULL_H */
+
@@ -0,0 +1,232 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          INNER FIT
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to precompute the "inner-fit polygon" of
+ * two convex polygons: the region that the centre of the inside polygon can be
+ * moved to, at its current scale and rotation, while staying completely inside
+ * the outside polygon.
+ * 
+ * Each edge of the outside polygon only allows the inside polygon's centre up
+ * to a line parallel to the edge, pulled in by how far the inside polygon
+ * reaches past its centre in that direction. The region is where all of these
+ * lines allow (the outside polygon shrunk, or "eroded", by the inside one).
+ * 
+ * Once built, testing whether the inside polygon fits at a given position is a
+ * binary search over the region's vertices instead of a full 
+ * checkInsideBoundingBox, which makes it much faster to test thousands of 
+ * positions for the same pair. The region is also a polygon, so positions can
+ * be sampled directly from it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vector.h"
+#include "polygon.h"
+#include "innerfit.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CLIP TO HALF PLANE /////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function cuts a convex polygon, given as lists of x and y, down to the
+ * part where nx*x + ny*y <= limit. The result is written into outX and outY and
+ * the new number of vertices is returned. Each cut adds at most one vertex.
+ */
+static int clipToHalfPlane(double* x, double* y, int count, double nx, 
+        double ny, double limit, double* outX, double* outY){
+    int i, outCount = 0;
+    
+    for(i = 0; i < count; i++){
+        int next = (i+1) % count;
+        
+        //how far past the line each end of this edge is
+        double d1 = nx*x[i] + ny*y[i] - limit;
+        double d2 = nx*x[next] + ny*y[next] - limit;
+        
+        //keep this vertex if it is on the allowed side
+        if(d1 <= 0){
+            outX[outCount] = x[i];
+            outY[outCount] = y[i];
+            outCount++;
+        }
+        
+        //if the edge crosses the line, add the point where it crosses
+        if((d1 < 0 && d2 > 0) || (d1 > 0 && d2 < 0)){
+            double t = d1/(d1 - d2);
+            outX[outCount] = x[i] + t*(x[next] - x[i]);
+            outY[outCount] = y[i] + t*(y[next] - y[i]);
+            outCount++;
+        }
+    }
+    return outCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD INNER FIT REGION /////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function builds the inner-fit region for the inside polygon, at its
+ * current scale and rotation, in the outside polygon. Both polygons must be
+ * convex. The region is NULL if there is no position at which it fits.
+ * 
+ * The outside polygon may have its vertices in either direction.
+ */
+innerFitRegion* buildInnerFitRegion(polygon* inside, polygon* outside){
+    int count, i, j;
+    for(count = 0; outside->vertices[count] != NULL; count++);
+    
+    //each cut adds at most one vertex, so 2n vertices is enough room
+    double* x = malloc(sizeof(double)*(2*count+2));
+    double* y = malloc(sizeof(double)*(2*count+2));
+    double* clippedX = malloc(sizeof(double)*(2*count+2));
+    double* clippedY = malloc(sizeof(double)*(2*count+2));
+    
+    //start from the outside polygon itself
+    for(i = 0; i < count; i++){
+        x[i] = outside->vertices[i]->x;
+        y[i] = outside->vertices[i]->y;
+    }
+    int regionCount = count;
+    
+    //for each edge of the outside polygon
+    for(i = 0; i < count && regionCount > 0; i++){
+        vector* a = outside->vertices[i];
+        vector* b = outside->vertices[(i+1) % count];
+        vector* n = getLineNormal(a, b);
+        
+        //make sure the normal points outwards, away from the centre
+        if(n->x*(outside->centre->x - a->x) + n->y*(outside->centre->y - a->y) > 0){
+            n->x = -n->x;
+            n->y = -n->y;
+        }
+        
+        //find how far the inside polygon reaches past its centre along it
+        double reach = 0;
+        for(j = 0; inside->vertices[j] != NULL; j++){
+            double r = n->x*(inside->vertices[j]->x - inside->centre->x) +
+                       n->y*(inside->vertices[j]->y - inside->centre->y);
+            if(r > reach){
+                reach = r;
+            }
+        }
+        
+        //the centre can only go up to the edge, less that reach
+        double limit = n->x*a->x + n->y*a->y - reach;
+        regionCount = clipToHalfPlane(x, y, regionCount, n->x, n->y, limit,
+                                        clippedX, clippedY);
+        
+        //swap the lists so the clipped polygon is cut by the next edge
+        double* swap = x; x = clippedX; clippedX = swap;
+        swap = y; y = clippedY; clippedY = swap;
+        
+        free(n);
+    }
+    
+    //drop vertices that are on top of the previous one
+    int unique = 0;
+    for(i = 0; i < regionCount; i++){
+        if(unique == 0 || fabs(x[i] - x[unique-1]) > 1e-9 || 
+                            fabs(y[i] - y[unique-1]) > 1e-9){
+            x[unique] = x[i];
+            y[unique] = y[i];
+            unique++;
+        }
+    }
+    while(unique > 1 && fabs(x[0] - x[unique-1]) <= 1e-9 &&
+                        fabs(y[0] - y[unique-1]) <= 1e-9){
+        unique--;
+    }
+    
+    innerFitRegion* newRegion = malloc(sizeof(innerFitRegion));
+    newRegion->region = NULL;
+    newRegion->count = 0;
+    newRegion->orientation = 1;
+    
+    //anything smaller than a triangle has no room inside it to fit
+    if(unique >= 3){
+        vector** vertices = malloc(sizeof(vector*)*(unique+1));
+        double area = 0;
+        for(i = 0; i < unique; i++){
+            vertices[i] = createVector(x[i], y[i], outside->centre->z);
+            area = area + x[i]*y[(i+1) % unique] - x[(i+1) % unique]*y[i];
+        }
+        vertices[unique] = NULL;
+        
+        newRegion->region = buildPolygon(vertices);
+        free(vertices);
+        newRegion->count = unique;
+        newRegion->orientation = (area > 0) ? 1 : -1;
+    }
+    
+    free(x);
+    free(y);
+    free(clippedX);
+    free(clippedY);
+    
+    return newRegion;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CHECK INSIDE INNER FIT /////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function checks whether the inside polygon the region was built for 
+ * would fit completely inside the outside polygon with its centre at the given
+ * position. It returns 1 if it would, and 0 if it would touch or cross the 
+ * outside polygon, as checkInsideBoundingBox does.
+ * 
+ * The region is split into a fan of triangles from its first vertex: a binary
+ * search finds which triangle the point's direction falls in, and then only
+ * that triangle's outer edge has to be checked.
+ */
+int checkInsideInnerFit(innerFitRegion* r, vector* centre){
+    if(r->region == NULL){
+        return 0;
+    }
+    
+    vector** v = r->region->vertices;
+    double s = r->orientation;
+    double px = centre->x - v[0]->x;
+    double py = centre->y - v[0]->y;
+    
+    //the point must be strictly between the first and last edges of the fan
+    double first = s*((v[1]->x - v[0]->x)*py - (v[1]->y - v[0]->y)*px);
+    double last = s*((v[r->count-1]->x - v[0]->x)*py - 
+                     (v[r->count-1]->y - v[0]->y)*px);
+    if(first <= 0 || last >= 0){
+        return 0;
+    }
+    
+    //binary search for the triangle from v0 to vlow and vlow+1 containing it
+    int low = 1, high = r->count - 1;
+    while(high - low > 1){
+        int mid = (low + high)/2;
+        double side = s*((v[mid]->x - v[0]->x)*py - (v[mid]->y - v[0]->y)*px);
+        if(side > 0){
+            low = mid;
+        }else{
+            high = mid;
+        }
+    }
+    
+    //then check it is on the inside of that triangle's outer edge
+    double edge = s*((v[high]->x - v[low]->x)*(centre->y - v[low]->y) -
+                     (v[high]->y - v[low]->y)*(centre->x - v[low]->x));
+    if(edge > 0){
+        return 1;
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FREE INNER FIT REGION //////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function frees an inner-fit region and its polygon.
+ */
+int freeInnerFitRegion(innerFitRegion* r){
+    if(r->region != NULL){
+        freePolygon(r->region);
+    }
+    free(r);
+    return(EXIT_SUCCESS);
+}
@@ -0,0 +1,32 @@
+/* 
+ * File:   innerfit.h
+ *
+ * This header file externalises the functions in the innerfit.c file, which
+ * precompute where one polygon can be placed inside another.
+ * 
+ * For further details on any function, check there.
+ */
+
+#ifndef INNERFIT_H
+#define INNERFIT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct innerFitRegion{
+    polygon* region;
+    int count;
+    double orientation;
+}innerFitRegion;
+
+innerFitRegion* buildInnerFitRegion(polygon* inside, polygon* outside);
+int checkInsideInnerFit(innerFitRegion* r, vector* centre);
+int freeInnerFitRegion(innerFitRegion* r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INNERFIT_H */
+
@@ -0,0 +1,342 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          LOADER
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to load the polygons of an object file.
+ *
+ * A file on disk is mapped into memory and parsed straight from there, so it
+ * is never copied into a buffer first, and the system is told it will be read
+ * from start to end so it can read ahead. Large files are split into chunks
+ * read on every processor at once. Anything which can't be mapped, such
+ * as a pipe, is read as a stream instead. Either way the result is the same.
+ * Files can be text (see parser.c) or binary (see binary.c), which is told by
+ * how they start.
+ *
+ * The polygons of the last file loaded are kept, with its size and when it
+ * was last changed. If the same file is loaded again and neither has changed,
+ * copies of them are given instead of reading the file again.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#include "vector.h"
+#include "polygon.h"
+#include "parallel.h"
+#include "parser.h"
+#include "binary.h"
+#include "loader.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+//the size of the first block of a binary file read from a pipe, which is
+//doubled as needed
+#define READ_STREAM_SIZE (1 << 20)
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// LOADED FILE TYPE DEFINITION ////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This struct holds what is known of the last file loaded: enough to tell if
+ * it has changed, and the polygons read from it, which are never given out
+ * themselves, only copied.
+ */
+typedef struct loadedFile{
+    char* filename;
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    time_t modified;
+    long modifiedNanoseconds;
+    polygon** polygons;
+    int count;
+}loadedFile;
+
+static loadedFile lastLoaded = {NULL, 0, 0, 0, 0, 0, NULL, 0};
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET MODIFIED NANOSECONDS ///////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function returns the part of a second after the time a file was last
+ * changed, where the system records it, so a file changed twice in the same
+ * second isn't taken to be unchanged.
+ */
+static long getModifiedNanoseconds(struct stat* s){
+#ifdef _WIN32
+    return 0;
+#else
+    return s->st_mtim.tv_nsec;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// COPY POLYGON LIST //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function returns a NULL-terminated list of copies of the polygons in
+ * another.
+ */
+static polygon** copyPolygonList(polygon** list, int count){
+    polygon** copy = malloc(sizeof(polygon*)*(count+1));
+    int i;
+    for(i = 0; i < count; i++){
+        copy[i] = copyPolygon(list[i]);
+    }
+    copy[count] = NULL;
+    return copy;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CHECK FILE UNCHANGED ///////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function returns 1 if an open file is the last file loaded, and it
+ * hasn't changed since, or 0 if it must be read.
+ */
+static int checkFileUnchanged(const char* filename, struct stat* s){
+    if(lastLoaded.polygons == NULL || !S_ISREG(s->st_mode)){
+        return 0;
+    }
+    return strcmp(lastLoaded.filename, filename) == 0 &&
+            lastLoaded.device == s->st_dev &&
+            lastLoaded.inode == s->st_ino &&
+            lastLoaded.size == s->st_size &&
+            lastLoaded.modified == s->st_mtime &&
+            lastLoaded.modifiedNanoseconds == getModifiedNanoseconds(s);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// REMEMBER FILE //////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function keeps copies of the polygons read from a file on disk, in
+ * place of those of the last file loaded.
+ */
+static int rememberFile(const char* filename, struct stat* s, polygon** list,
+        int count){
+    forgetLoadedFile();
+    lastLoaded.filename = malloc(strlen(filename)+1);
+    strcpy(lastLoaded.filename, filename);
+    lastLoaded.device = s->st_dev;
+    lastLoaded.inode = s->st_ino;
+    lastLoaded.size = s->st_size;
+    lastLoaded.modified = s->st_mtime;
+    lastLoaded.modifiedNanoseconds = getModifiedNanoseconds(s);
+    lastLoaded.polygons = copyPolygonList(list, count);
+    lastLoaded.count = count;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FORGET LOADED FILE /////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function frees the polygons kept from the last file loaded, so the next
+ * load reads its file whatever it is.
+ */
+int forgetLoadedFile(){
+    if(lastLoaded.polygons != NULL){
+        freePolygonList(lastLoaded.polygons);
+        free(lastLoaded.filename);
+    }
+    lastLoaded.polygons = NULL;
+    lastLoaded.filename = NULL;
+    lastLoaded.count = 0;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ TEXT OR BINARY ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads every polygon from the whole of an object file in
+ * memory, whichever form it is in, spread across every processor.
+ */
+static polygon** readTextOrBinary(const char* data, size_t length, int* count,
+        parseError* error){
+    int threads = getProcessorCount();
+    if(checkBinaryObjectFile(data, length)){
+        return readBinaryPolygons(data, length, threads, count, error);
+    }
+    return readPolygonsInChunks(data, length, threads, count, error);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ STREAM ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads every polygon from a file which can't be mapped, such as
+ * a pipe. Text is read a block at a time. Binary files (which can't start with
+ * the same character as text) have to be read whole before they can be used.
+ */
+static polygon** readStream(FILE* stream, int* count, parseError* error){
+    int c = getc(stream);
+    ungetc(c, stream);
+    if(c != (unsigned char)BINARY_MAGIC[0]){
+        return readPolygons(stream, count, error);
+    }
+
+    size_t capacity = READ_STREAM_SIZE, length = 0, read;
+    char* data = malloc(capacity);
+    while((read = fread(data + length, 1, capacity - length, stream)) > 0){
+        length += read;
+        if(length == capacity){
+            capacity = capacity*2;
+            data = realloc(data, capacity);
+        }
+    }
+    polygon** list = readTextOrBinary(data, length, count, error);
+    free(data);
+    return list;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ MAPPED FILE ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function maps the whole of an open file into memory and reads its
+ * polygons from there.
+ *
+ * Sets mapped to 0, and returns NULL, if the file couldn't be mapped, so it
+ * can be read in blocks instead. Otherwise mapped is set to 1 and the polygons
+ * are read as readTextOrBinary does.
+ */
+static polygon** readMappedFile(int file, size_t size, int* count,
+        parseError* error, int* mapped){
+    polygon** list;
+    *mapped = 0;
+
+#ifdef _WIN32
+    HANDLE handle = (HANDLE)_get_osfhandle(file);
+    HANDLE mapping = CreateFileMapping(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mapping == NULL){
+        return NULL;
+    }
+    const char* text = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(text == NULL){
+        CloseHandle(mapping);
+        return NULL;
+    }
+    *mapped = 1;
+    list = readTextOrBinary(text, size, count, error);
+    UnmapViewOfFile(text);
+    CloseHandle(mapping);
+#else
+    void* text = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+    if(text == MAP_FAILED){
+        return NULL;
+    }
+    //the file is read once from start to end, so pages can be read well ahead
+    //and dropped once passed
+    madvise(text, size, MADV_SEQUENTIAL);
+    *mapped = 1;
+    list = readTextOrBinary(text, size, count, error);
+    munmap(text, size);
+#endif
+
+    return list;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// OPEN OBJECT FILE ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function opens the named file and finds its details. It returns the
+ * open file, or -1 (with the error set to line 0) if it can't be opened.
+ */
+static int openObjectFile(const char* filename, struct stat* s,
+        parseError* error){
+    int file = open(filename, O_RDONLY | O_BINARY);
+    if(file >= 0 && fstat(file, s) == 0){
+        return file;
+    }
+    if(file >= 0){
+        close(file);
+    }
+    error->line = 0;
+    error->column = 0;
+    snprintf(error->message, sizeof(error->message), "could not open the file");
+    return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ OPEN FILE /////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads every polygon from an open object file, and closes it.
+ * Files on disk are mapped, and anything else (or an empty file, which can't
+ * be) is read as a stream.
+ */
+static polygon** readOpenFile(int file, struct stat* s, int* count,
+        parseError* error){
+    polygon** list = NULL;
+    int mapped = 0;
+    if(S_ISREG(s->st_mode) && s->st_size > 0){
+        list = readMappedFile(file, (size_t)s->st_size, count, error, &mapped);
+    }
+    if(mapped == 0){
+        FILE* stream = fdopen(file, "rb");
+        list = readStream(stream, count, error);
+        fclose(stream);
+    }
+    else{
+        close(file);
+    }
+    return list;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ OBJECT FILE ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads every polygon in the named object file, text or binary,
+ * as loadPolygons does, but always reads the file and doesn't keep what it
+ * read.
+ */
+polygon** readObjectFile(const char* filename, int* count, parseError* error){
+    struct stat s;
+    *count = 0;
+    int file = openObjectFile(filename, &s, error);
+    if(file < 0){
+        return NULL;
+    }
+    return readOpenFile(file, &s, count, error);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// LOAD POLYGONS //////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads every polygon in the named object file, text or binary,
+ * and returns them as a NULL-terminated list, with the number read stored in
+ * count. reused is set to 1 if they are copies kept from the last time the
+ * file was loaded, or 0 if the file was read.
+ *
+ * If the file can't be opened, NULL is returned and the error has line 0. If it
+ * isn't in the right form, NULL is returned and the error says why, and where
+ * for text files (binary files give line -1).
+ */
+polygon** loadPolygons(const char* filename, int* count, parseError* error,
+        int* reused){
+    *reused = 0;
+    *count = 0;
+
+    struct stat s;
+    int file = openObjectFile(filename, &s, error);
+    if(file < 0){
+        return NULL;
+    }
+
+    if(checkFileUnchanged(filename, &s)){
+        close(file);
+        *reused = 1;
+        *count = lastLoaded.count;
+        return copyPolygonList(lastLoaded.polygons, lastLoaded.count);
+    }
+
+    polygon** list = readOpenFile(file, &s, count, error);
+    if(list != NULL && S_ISREG(s.st_mode)){
+        rememberFile(filename, &s, list, *count);
+    }
+    return list;
+}
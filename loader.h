@@ -0,0 +1,27 @@
+/*
+ * File:   loader.h
+ *
+ * This header file externalises the functions in the loader.c file, which
+ * loads the polygons of an object file.
+ *
+ * For further details on any function, check there.
+ */
+
+#ifndef LOADER_H
+#define LOADER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+polygon** loadPolygons(const char* filename, int* count, parseError* error,
+        int* reused);
+polygon** readObjectFile(const char* filename, int* count, parseError* error);
+int forgetLoadedFile();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOADER_H */
+
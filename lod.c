@@ -0,0 +1,503 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          LEVEL OF DETAIL
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to keep simplified versions ("levels of 
+ * detail") of polygons with many vertices, so that most collision and 
+ * containment checks can be answered from a few vertices instead of all of
+ * them.
+ * 
+ * Each level has two approximations, found with the Douglas-Peucker method,
+ * which keeps only the vertices needed to stay within a tolerance of the
+ * outline:
+ * 
+ *  - the outer approximation is the convex hull of the kept vertices pushed
+ *    out by the tolerance, so it always contains the whole polygon
+ *  - the inner approximation is the kept vertices themselves. For a convex
+ *    polygon this is always inside it. Concave polygons have no inner 
+ *    approximation.
+ * 
+ * If the outer approximations don't collide, the polygons can't; if the inner
+ * ones do, the polygons must. Containment works the same way. Only when a 
+ * level can't decide is the next, finer, level (and finally the polygon
+ * itself) checked.
+ * 
+ * The approximations are stored relative to the polygon's centre, scale and
+ * rotation when they were made, and are moved to match the polygon before
+ * each use, so they stay correct however it is transformed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vector.h"
+#include "polygon.h"
+#include "collision.h"
+#include "hull.h"
+#include "lod.h"
+
+//polygons with fewer vertices than this are quicker to check directly than to
+//place and check their levels of detail first
+#define DETAIL_MIN_VERTICES 64
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// DOUGLAS-PEUCKER ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds the distance from vertex i of p to the line segment 
+ * between vertices a and b.
+ */
+static double getSegmentDistance(polygon* p, int i, int a, int b){
+    vector* v = p->vertices[i];
+    vector* s = p->vertices[a];
+    vector* e = p->vertices[b];
+    double dx = e->x - s->x, dy = e->y - s->y;
+    double length = dx*dx + dy*dy;
+    double t = 0;
+    if(length > 0){
+        t = ((v->x - s->x)*dx + (v->y - s->y)*dy)/length;
+        t = (t < 0) ? 0 : ((t > 1) ? 1 : t);
+    }
+    double x = s->x + t*dx - v->x, y = s->y + t*dy - v->y;
+    return sqrt(x*x + y*y);
+}
+
+/* This function marks which vertices of the outline between vertices first 
+ * and last (going round, in order) are kept: if any is further than the 
+ * tolerance from the straight line between them, the furthest is kept and 
+ * each side is simplified again. Every dropped vertex ends up within the
+ * tolerance of the edge that replaces it.
+ */
+static int simplifyChain(polygon* p, int count, int first, int last, 
+        double tolerance, char* keep){
+    double furthest = 0;
+    int furthestIndex = -1, i;
+    for(i = (first+1)%count; i != last; i = (i+1)%count){
+        double d = getSegmentDistance(p, i, first, last);
+        if(d > furthest){
+            furthest = d;
+            furthestIndex = i;
+        }
+    }
+    if(furthestIndex >= 0 && furthest > tolerance){
+        keep[furthestIndex] = 1;
+        simplifyChain(p, count, first, furthestIndex, tolerance, keep);
+        simplifyChain(p, count, furthestIndex, last, tolerance, keep);
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD DETAIL LEVEL /////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function stores a list of points relative to the polygon's centre, and
+ * builds a polygon of them to be moved into place before each use.
+ */
+static polygon* buildLevelPolygon(polygon* p, double x[], double y[], int count,
+        double** local){
+    vector** v = malloc(sizeof(vector*)*(count+1));
+    int i;
+    *local = malloc(sizeof(double)*2*count);
+    for(i = 0; i < count; i++){
+        (*local)[i*2] = x[i] - p->centre->x;
+        (*local)[i*2+1] = y[i] - p->centre->y;
+        v[i] = createVector(x[i], y[i], p->centre->z);
+    }
+    v[count] = NULL;
+    polygon* level = buildPolygon(v);
+    free(v);
+    return level;
+}
+
+/* This function builds one level of detail of a polygon at the given 
+ * tolerance. It returns the number of vertices kept, so levels which don't
+ * simplify the polygon enough can be thrown away.
+ */
+static int buildDetailLevel(polygon* p, int count, int convex, double tolerance,
+        detailLevel* level){
+    char* keep = calloc(count, sizeof(char));
+    int i, j;
+    
+    //split the outline in two at vertex 0 and the vertex furthest from it,
+    //and simplify each half
+    int far = 0;
+    double farDistance = 0;
+    for(i = 1; i < count; i++){
+        double dx = p->vertices[i]->x - p->vertices[0]->x;
+        double dy = p->vertices[i]->y - p->vertices[0]->y;
+        if(dx*dx + dy*dy > farDistance){
+            farDistance = dx*dx + dy*dy;
+            far = i;
+        }
+    }
+    keep[0] = 1;
+    keep[far] = 1;
+    simplifyChain(p, count, 0, far, tolerance, keep);
+    simplifyChain(p, count, far, 0, tolerance, keep);
+    
+    vector** kept = malloc(sizeof(vector*)*(count+1));
+    int keptCount = 0;
+    for(i = 0; i < count; i++){
+        if(keep[i] == 1){
+            kept[keptCount++] = p->vertices[i];
+        }
+    }
+    free(keep);
+    
+    //the outer approximation: the hull of the kept vertices, with each edge
+    //pushed out by the tolerance (a little more, to be safe from rounding)
+    vector** hull = malloc(sizeof(vector*)*(keptCount+1));
+    int hullCount = getConvexHull(kept, keptCount, hull);
+    if(hullCount < 3){
+        free(kept);
+        free(hull);
+        return count;
+    }
+    double offset = tolerance*(1 + 1e-9);
+    double* x = malloc(sizeof(double)*keptCount);
+    double* y = malloc(sizeof(double)*keptCount);
+    for(i = 0; i < hullCount; i++){
+        vector* prev = hull[(i+hullCount-1)%hullCount];
+        vector* v = hull[i];
+        vector* next = hull[(i+1)%hullCount];
+        
+        //the outward normals of the edges either side (the hull is clockwise,
+        //so outwards is to the left)
+        double n1x = -(v->y - prev->y), n1y = v->x - prev->x;
+        double n2x = -(next->y - v->y), n2y = next->x - v->x;
+        double l1 = sqrt(n1x*n1x + n1y*n1y), l2 = sqrt(n2x*n2x + n2y*n2y);
+        n1x /= l1; n1y /= l1; n2x /= l2; n2y /= l2;
+        
+        //where the two pushed-out edges meet
+        double d = 1 + n1x*n2x + n1y*n2y;
+        x[i] = v->x + offset*(n1x + n2x)/d;
+        y[i] = v->y + offset*(n1y + n2y)/d;
+    }
+    level->tolerance = tolerance;
+    level->outer = buildLevelPolygon(p, x, y, hullCount, &level->outerLocal);
+    
+    //the inner approximation: the kept vertices, in order, which are inside
+    //the polygon if it is convex
+    level->inner = NULL;
+    level->innerLocal = NULL;
+    if(convex == 1 && keptCount >= 3){
+        for(j = 0; j < keptCount; j++){
+            x[j] = kept[j]->x;
+            y[j] = kept[j]->y;
+        }
+        level->inner = buildLevelPolygon(p, x, y, keptCount, &level->innerLocal);
+    }
+    
+    level->placedScale = p->transform->scale;
+    level->placedAngle = p->transform->rotationZ;
+    level->placedX = p->centre->x;
+    level->placedY = p->centre->y;
+    
+    free(kept);
+    free(hull);
+    free(x);
+    free(y);
+    return (hullCount > keptCount) ? hullCount : keptCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// ATTACH POLYGON DETAIL //////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function builds the levels of detail for a polygon and keeps them with
+ * it, so its checks use them from then on. Levels are made at tolerances of 
+ * 1/16, 1/64 and 1/256 of the polygon's size, keeping only those which drop at
+ * least a quarter of the vertices. Returns the number of levels made (0 for a 
+ * polygon too simple to need any).
+ */
+int attachPolygonDetail(polygon* p){
+    if(p->detail != NULL){
+        freePolygonDetail(p->detail);
+        p->detail = NULL;
+    }
+    int count;
+    for(count = 0; p->vertices[count] != NULL; count++);
+    if(count < DETAIL_MIN_VERTICES){
+        return 0;
+    }
+    
+    bounds b;
+    getPolygonBounds(p, &b);
+    double size = sqrt((b.maxX - b.minX)*(b.maxX - b.minX) + 
+                       (b.maxY - b.minY)*(b.maxY - b.minY));
+    int convex = checkIfConvex(p);
+    
+    polygonDetail* d = malloc(sizeof(polygonDetail));
+    d->levels = malloc(sizeof(detailLevel)*3);
+    d->count = 0;
+    d->baseScale = p->transform->scale;
+    d->baseAngle = p->transform->rotationZ;
+    
+    double tolerance = size/16;
+    int i;
+    for(i = 0; i < 3; i++){
+        detailLevel* level = &d->levels[d->count];
+        level->outer = NULL;
+        int kept = buildDetailLevel(p, count, convex, tolerance, level);
+        if(level->outer != NULL && kept*4 <= count*3){
+            d->count++;
+        }
+        else if(level->outer != NULL){
+            freePolygon(level->outer);
+            free(level->outerLocal);
+            if(level->inner != NULL){
+                freePolygon(level->inner);
+                free(level->innerLocal);
+            }
+        }
+        tolerance = tolerance/4;
+    }
+    
+    if(d->count == 0){
+        freePolygonDetail(d);
+        return 0;
+    }
+    p->detail = d;
+    return d->count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET POLYGON DETAIL /////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function returns a polygon's levels of detail, or NULL for a polygon 
+ * with none.
+ */
+polygonDetail* getPolygonDetail(polygon* p){
+    return p->detail;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// PLACE DETAIL LEVEL /////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function moves a level's approximations to match the polygon's current
+ * centre, scale and rotation. Nothing is done if they already match.
+ */
+static int placePoints(polygon* level, double* local, double scale, 
+        double cosA, double sinA, vector* centre){
+    int i;
+    for(i = 0; level->vertices[i] != NULL; i++){
+        double x = local[i*2]*scale, y = local[i*2+1]*scale;
+        level->vertices[i]->x = centre->x + x*cosA - y*sinA;
+        level->vertices[i]->y = centre->y + x*sinA + y*cosA;
+        level->vertices[i]->z = centre->z;
+    }
+    level->centre->x = centre->x;
+    level->centre->y = centre->y;
+    level->centre->z = centre->z;
+    return(EXIT_SUCCESS);
+}
+
+static detailLevel* placeDetailLevel(polygon* p, polygonDetail* d, int index){
+    detailLevel* level = &d->levels[index];
+    if(level->placedScale == p->transform->scale && 
+            level->placedAngle == p->transform->rotationZ &&
+            level->placedX == p->centre->x && level->placedY == p->centre->y){
+        return level;
+    }
+    
+    double scale = p->transform->scale/d->baseScale;
+    double angle = (p->transform->rotationZ - d->baseAngle)*M_PI/180;
+    double cosA = cos(angle), sinA = sin(angle);
+    placePoints(level->outer, level->outerLocal, scale, cosA, sinA, p->centre);
+    if(level->inner != NULL){
+        placePoints(level->inner, level->innerLocal, scale, cosA, sinA, p->centre);
+    }
+    
+    level->placedScale = p->transform->scale;
+    level->placedAngle = p->transform->rotationZ;
+    level->placedX = p->centre->x;
+    level->placedY = p->centre->y;
+    return level;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// PLACE POLYGON DETAIL ///////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function moves every level of a polygon's detail to where the polygon
+ * is now, which the checks would otherwise do the first time they use each
+ * level after it moves.
+ */
+int placePolygonDetail(polygon* p){
+    polygonDetail* d = getPolygonDetail(p);
+    if(d == NULL){
+        return(EXIT_SUCCESS);
+    }
+    int i;
+    for(i = 0; i < d->count; i++){
+        placeDetailLevel(p, d, i);
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD OUTER APPROXIMATION //////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function creates a new polygon from the coarsest outer approximation
+ * that is within the given tolerance of the polygon, at the polygon's current
+ * position, with the same centre, scale and rotation so it can be transformed
+ * in the same way. Anything that fits around it fits around the polygon. 
+ * Returns NULL if the polygon has no level of detail that close.
+ */
+polygon* buildOuterApproximation(polygon* p, double tolerance){
+    polygonDetail* d = getPolygonDetail(p);
+    if(d == NULL){
+        return NULL;
+    }
+    
+    //the tolerances were set at the scale the levels were made at
+    double scale = p->transform->scale/d->baseScale;
+    int level;
+    for(level = 0; level < d->count && 
+            d->levels[level].tolerance*scale > tolerance; level++);
+    if(level == d->count){
+        return NULL;
+    }
+    detailLevel* placed = placeDetailLevel(p, d, level);
+    
+    polygon* approximation = copyPolygon(placed->outer);
+    approximation->centre->x = p->centre->x;
+    approximation->centre->y = p->centre->y;
+    approximation->centre->z = p->centre->z;
+    approximation->transform->scale = p->transform->scale;
+    approximation->transform->rotationZ = p->transform->rotationZ;
+    return approximation;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CHECK DETAIL COLLISIONS ////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function tries to decide whether two polygons collide from their levels
+ * of detail, coarsest first. It returns 1 if they definitely don't collide, 0 
+ * if they definitely do, and -1 if no level can tell (so the polygons 
+ * themselves must be checked). A polygon without levels stands for both of
+ * its own approximations.
+ */
+int checkDetailCollisions(polygon* a, polygon* b){
+    polygonDetail* detailA = getPolygonDetail(a);
+    polygonDetail* detailB = getPolygonDetail(b);
+    int countA = (detailA != NULL) ? detailA->count : 0;
+    int countB = (detailB != NULL) ? detailB->count : 0;
+    int levels = (countA > countB) ? countA : countB;
+    int i;
+    
+    for(i = 0; i < levels; i++){
+        polygon *outerA = a, *innerA = a, *outerB = b, *innerB = b;
+        if(detailA != NULL){
+            detailLevel* l = placeDetailLevel(a, detailA, (i < countA) ? i : countA-1);
+            outerA = l->outer;
+            innerA = l->inner;
+        }
+        if(detailB != NULL){
+            detailLevel* l = placeDetailLevel(b, detailB, (i < countB) ? i : countB-1);
+            outerB = l->outer;
+            innerB = l->inner;
+        }
+        
+        if(checkCollisions(outerA, outerB) == 1){
+            return 1;
+        }
+        if(innerA != NULL && innerB != NULL && checkCollisions(innerA, innerB) == 0){
+            return 0;
+        }
+    }
+    return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CHECK DETAIL INSIDE ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function tries to decide whether polygon a is inside the bound from 
+ * their levels of detail, coarsest first. It returns 1 if a is definitely
+ * inside, 0 if it definitely isn't, and -1 if no level can tell.
+ */
+int checkDetailInside(polygon* a, polygon* bound){
+    polygonDetail* detailA = getPolygonDetail(a);
+    polygonDetail* detailB = getPolygonDetail(bound);
+    int countA = (detailA != NULL) ? detailA->count : 0;
+    int countB = (detailB != NULL) ? detailB->count : 0;
+    int levels = (countA > countB) ? countA : countB;
+    int i;
+    
+    for(i = 0; i < levels; i++){
+        polygon *outerA = a, *innerA = a, *outerB = bound, *innerB = bound;
+        if(detailA != NULL){
+            detailLevel* l = placeDetailLevel(a, detailA, (i < countA) ? i : countA-1);
+            outerA = l->outer;
+            innerA = l->inner;
+        }
+        if(detailB != NULL){
+            detailLevel* l = placeDetailLevel(bound, detailB, (i < countB) ? i : countB-1);
+            outerB = l->outer;
+            innerB = l->inner;
+        }
+        
+        //all of a fits in the part of the bound that is certainly there
+        if(innerB != NULL && checkInsideBoundingBox(outerA, innerB) == 1){
+            return 1;
+        }
+        //part of a is certainly outside everything the bound could cover
+        if(innerA != NULL && checkInsideBoundingBox(innerA, outerB) == 0){
+            return 0;
+        }
+    }
+    return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// COPY POLYGON DETAIL ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function makes a copy of a polygon's levels of detail, for a copy of
+ * the polygon, so that each can be moved separately.
+ */
+static polygon* copyLevelPolygon(polygon* p, double** local, int count){
+    if(p == NULL){
+        return NULL;
+    }
+    double* copy = malloc(sizeof(double)*2*count);
+    memcpy(copy, *local, sizeof(double)*2*count);
+    *local = copy;
+    return copyPolygon(p);
+}
+
+polygonDetail* copyPolygonDetail(polygonDetail* d){
+    polygonDetail* copy = malloc(sizeof(polygonDetail));
+    *copy = *d;
+    copy->levels = malloc(sizeof(detailLevel)*d->count);
+    int i, count;
+    for(i = 0; i < d->count; i++){
+        copy->levels[i] = d->levels[i];
+        for(count = 0; d->levels[i].outer->vertices[count] != NULL; count++);
+        copy->levels[i].outer = copyLevelPolygon(d->levels[i].outer, 
+                &copy->levels[i].outerLocal, count);
+        if(d->levels[i].inner != NULL){
+            for(count = 0; d->levels[i].inner->vertices[count] != NULL; count++);
+        }
+        copy->levels[i].inner = copyLevelPolygon(d->levels[i].inner, 
+                &copy->levels[i].innerLocal, count);
+    }
+    return copy;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FREE POLYGON DETAIL ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function frees a polygon's levels of detail.
+ */
+int freePolygonDetail(polygonDetail* d){
+    int i;
+    for(i = 0; i < d->count; i++){
+        freePolygon(d->levels[i].outer);
+        free(d->levels[i].outerLocal);
+        if(d->levels[i].inner != NULL){
+            freePolygon(d->levels[i].inner);
+            free(d->levels[i].innerLocal);
+        }
+    }
+    free(d->levels);
+    free(d);
+    return(EXIT_SUCCESS);
+}
@@ -0,0 +1,50 @@
+/* 
+ * File:   lod.h
+ *
+ * This header file externalises the functions in the lod.c file, which keeps
+ * simplified versions of detailed polygons for quick checks.
+ * 
+ * For further details on any function, check there.
+ */
+
+#ifndef LOD_H
+#define LOD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct detailLevel{
+    double tolerance;
+    polygon* outer;
+    polygon* inner;
+    double* outerLocal;
+    double* innerLocal;
+    double placedScale;
+    double placedAngle;
+    double placedX;
+    double placedY;
+}detailLevel;
+
+typedef struct polygonDetail{
+    int count;
+    detailLevel* levels;
+    double baseScale;
+    double baseAngle;
+}polygonDetail;
+
+int attachPolygonDetail(polygon* p);
+polygonDetail* getPolygonDetail(polygon* p);
+polygonDetail* copyPolygonDetail(polygonDetail* d);
+int freePolygonDetail(polygonDetail* d);
+int placePolygonDetail(polygon* p);
+polygon* buildOuterApproximation(polygon* p, double tolerance);
+int checkDetailCollisions(polygon* a, polygon* b);
+int checkDetailInside(polygon* a, polygon* bound);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOD_H */
+
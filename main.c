@@ -11,16 +11,26 @@
 #include "vector.h"
 #include "polygon.h"
 #include "collision.h"
+#include "hull.h"
+#include "decompose.h"
+#include "lod.h"
+#include "parser.h"
+#include "loader.h"
+#include "scene.h"
 #include "menu.h"
+#include "cli.h"
 
-// Declare needed arrays and functions
-char* polygonsPreConversion[20][20];
-struct polygon* polygons[20];
+// Declare needed arrays and functions. The polygons are a NULL-terminated 
+// list, of length polygonCount, which is the list of the current scene.
+struct polygon** polygons = NULL;
+int polygonCount = 0;
+scene* currentScene = NULL;
 
 int openFile(int firstRun);
-int readFile(FILE* objectFile);
-int vectorsListToVectorsObject();
+int readFile(char* objectFilename);
+int updatePolygons();
 int checkAllConvex();
+int simplifyAllPolygons();
 
 
 
@@ -35,6 +45,11 @@ int main(int argc, char** argv) {
     //get the time for random seeds
     srand(time(NULL));
     
+    //with a command given, run it instead of the menu (see cli.c)
+    if(argc > 1){
+        return runCommandLine(argc, argv);
+    }
+    
     //print the opening splash
     printOpening();
     
@@ -43,6 +58,7 @@ int main(int argc, char** argv) {
     
     //check all shapes are convex
     checkAllConvex();
+    simplifyAllPolygons();
     
     //run the menu and get the character it returns
     char caseChar;
@@ -79,6 +95,8 @@ int main(int argc, char** argv) {
             case 'I' :
                 //input a different file
                 openFile(0);
+                checkAllConvex();
+                simplifyAllPolygons();
                 break;
                 
             case 'e':
@@ -87,11 +105,53 @@ int main(int argc, char** argv) {
                 exportToHTML();
                 break;
             
+            case 'r':
+            case 'R':
+                //Find the tightest shapes around an object
+                fitToBound();
+                break;
+                
             case 's':
             case 'S':
                 //Fit one object to another
                 fitObject();
                 break;
+                
+            case 'n':
+            case 'N':
+                //Nest objects inside one bound
+                nestObjects();
+                break;
+                
+            case 'j':
+            case 'J':
+                //Run a list of fits from a file
+                batchFit();
+                break;
+                
+            case 'm':
+            case 'M':
+                //Move two objects until they touch
+                moveObjects();
+                break;
+                
+            case 'v':
+            case 'V':
+                //Convert an object file between text and binary
+                convertFile();
+                break;
+                
+            case 'u':
+            case 'U':
+                //Change some polygons without reading the whole file again
+                updatePolygons();
+                break;
+                
+            case 'l':
+            case 'L':
+                //Log the results of comparisons and fits to a file
+                logResults();
+                break;
             
             //case 'd':
             //case 'D':
@@ -113,13 +173,13 @@ int main(int argc, char** argv) {
 ////////////////////////////////////////////////////////////////////////////////
 //////////////////// OPEN FILE /////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
-/* This function gets the details needed for the input file, opens it, and
- * passes it to the readFile function. */
+/* This function gets the details needed for the input file, and passes it to
+ * the readFile function. If the file can't be read, another is asked for, and
+ * any polygons already loaded are kept until one can. */
 int openFile(int firstRun){
     
     //set up the needed file details
-    char objectFilename[50];
-    FILE *objectFile;
+    char objectFilename[256];
     
     //until a file is successfully loaded
     for(;;){
@@ -127,21 +187,12 @@ int openFile(int firstRun){
         //print an instruction to the user on opening the file
         printf(" Please input the filename of the object list.\n");
 
-        if(firstRun == 0){
-            //clear the polygonsPreConversion and polygons array by setting each to NULL
-            int a, b;
-            for(a = 0; a<20; a++){
-                for(b = 0; b<20; b++){
-                    polygonsPreConversion[a][b] = NULL;
-                }
-                polygons[a] = NULL;
-            }
-        } else if (firstRun == 1){
+        if (firstRun == 1){
             printf(" Or press F to see the file details.\n");
         }
 
         //read the filename string from the user's response
-        scanf("%s", objectFilename);
+        scanf("%255s", objectFilename);
         
         //if the filename is equal to either F or f, print the file details and
         //repeat
@@ -152,22 +203,19 @@ int openFile(int firstRun){
             continue;
         }
 
-        //create the file as a FILE object and open it
-        objectFile = fopen (&objectFilename, "rt");
-        
-        //if the file is valid, break out of the loop.
-        if(objectFile != NULL){
-            printf(" Opening %s\n", objectFilename);
+        //read the file, and if that works break out of the loop.
+        int result = readFile(objectFilename);
+        if(result == EXIT_SUCCESS){
             break;
         }
+        if(result == -1){
+            printf(" Please correct the file and try again.\n");
+            continue;
+        }
     
         //if the program reaches here print a warning and return to the top
         printf(" Could not find file. Check filename. \n");
     }
-        
-    //continue on to reading the file
-    readFile(objectFile);
-    fclose(objectFile);
     
     return(EXIT_SUCCESS);
 }
@@ -175,162 +223,68 @@ int openFile(int firstRun){
  * =========================== READ FILE ================================
  * ======================================================================
  * 
- * This function reads in a correctly-formatted file into the 
- * "PolygonsPreConversion" array. In this 2D array, the first "Dimension" acts
- * as a list of the polygons, while the second acts as a list of the vertices of
- * each polygon in string format.
+ * This function reads a correctly-formatted file (see parser.c, or binary.c
+ * for binary files) into a new scene, replacing any polygons loaded before. If the file hasn't
+ * changed since it was last read, the polygons read then are used again (see
+ * loader.c).
  * 
- * This function also prints out instructions to the user.
+ * This function also prints out instructions to the user, and returns -1 if
+ * the file could not be read, or -2 if it could not be opened, leaving the
+ * polygons as they were.
  * 
  */
-int readFile(FILE* objectFile){
-    
-    //create the integers and the strings we'll be using to read the file
-    int i= 0;
-    int j= 0;
+int readFile(char* objectFilename){
     
-    //this is an array of strings, each 600char
-    char currentObjectString[20][600]; 
+    int count, reused;
+    parseError error;
+    polygon** read = loadPolygons(objectFilename, &count, &error, &reused);
+    if(read == NULL && error.line == 0){
+        return -2;
+    }
     
-    char* currentVectorString;
-   
     /*This helps display the read-in objects more efficiently*/
+    printf(" Opening %s\n", objectFilename);
     printf(" Reading:\n"); 
     
-    /* for each line
-     * -- the line is a polygon, the first [] in PolygonsPreConversion
-     * -- read the vectors into a list
-     * fgets gets the object string from the file
-     * 
-     * the while function runs if this does not return NULL
-     * 
-     * (I.E if the string is not empty)
-     */
-    while(fgets(currentObjectString[i], 256, objectFile) != NULL){
-            
-        //set J to 0
-        j = 0;
-
-        //read the first vector in by taking the token of the first object up to ;
-        currentVectorString = strtok(currentObjectString[i], ";\0");
-
-        //print which polygon is being read
-        printf(" Reading polygon %d: \n", i+1);
-
-        /*while the first point on the string currently being read is not 
-         * null
-         */
-        while(currentVectorString !=NULL && currentVectorString[1] != NULL){
-
-            //set the string for the vertex for polygon i to the read string
-            polygonsPreConversion[i][j] = currentVectorString;
-
-            //replace the read string with another, the next vertex
-            currentVectorString = strtok(NULL, ";\0");
-
-            //increment j, moving on to the next vertex of the same polygon
-            j++;
-        }
-
-        /* when the end of the line is reached, the first char in
-         * currentVectorString will be null and the while loop will break
-         * When this happens, increment i, moving on to the next line and
-         * next polygon
-         */
-        i++;
+    if(read == NULL && error.line < 0){
+        //binary files have no lines
+        printf(" ERROR: %s.\n", error.message);
+        return -1;
+    }
+    if(read == NULL){
+        printf(" ERROR: line %d, column %d: %s.\n", error.line, error.column, 
+                error.message);
+        return -1;
     }
     
-    printf(" Reading complete. Analysing.\n");
-    
-    //Convert the vectors list to the objects
-    vectorsListToVectorsObject();
-    
-    return(EXIT_SUCCESS);
-}
-
-/*===========================================================================
- *=================== VECTORS LIST TO VECTORS OBJECTS =======================
- * ==========================================================================
- * 
- * This method converts the PolygonsPreConversion array into the Polygons array.
- * 
- * It also converts the strings containing vector data into Vector objects, and
- * as part of setting up the Polygon objects gets the object centres.
- * 
- */
-int vectorsListToVectorsObject(){
-    
-    //set up the integers and strings we will need.
-    int i = 0;
-    int j = 0;
-    char *xString, *yString, *zString;
-    float x, y, z;
+    //replace the old polygons with the new
+    if(currentScene != NULL){
+        freeScene(currentScene);
+    }
+    currentScene = buildScene(read, count);
+    polygons = currentScene->polygons;
+    polygonCount = currentScene->count;
     
-    //while the first part of the current object is not null
-    while(polygonsPreConversion[i][0] != NULL){
-        
-        //set/reset j to 0
-        j = 0;
-        
-        /* Create PolygonVectors, an array of pointers to vector objects, and set
-         * them to 0
-         */
-        vector* polygonVectors[20] = {NULL};
-        
-        //while the current point on the current part of the array is not null
-        while(polygonsPreConversion[i][j] != NULL){
-            
-            //break the string down into individual strings for X Y and Z
-            xString = strtok(polygonsPreConversion[i][j], ",");
-            yString = strtok(NULL, ",");
-            zString = strtok(NULL, ";");
-            
-            //check that none are null
-            if(xString == NULL || yString == NULL || zString == NULL){
-                printf(" ERROR: Could not convert polygon %d to a number.\n"
-                        " Please read file instructions and try to input the file"
-                        " again.\n", i+1);
-                return -1 ;
-            }
-            
-            //convert those strings to doubles. if any cannot be converted,
-            //break the loop and return an error.
-            if( sscanf(xString, "%f", &x) == -1 ||
-                sscanf(yString, "%f", &y) == -1 ||
-                sscanf(zString, "%f", &z) == -1){
-                
-                printf(" Could not convert polygon %d vector %d to a number.\n"
-                        " Please read file instructions and try to input the file"
-                        " again.\n", i+1, j+1);
-                return -1 ;
-            }
-            
-            //use those doubles to create a vector
-            polygonVectors[j] = createVector(x,y,z);
-        
-            //increment j, moving on to the next vertex
-            j++;
-        }
-        polygonVectors[j] = NULL;
-        
-        /*When the while loop breaks, now we have a full list of vectors for the
-         * polygon. Use this to make a polygon and save it.
-         */
-        polygons[i] = buildPolygon(polygonVectors);
-        
-        //increment i, move on to the next polygon.
-        i++;
+    if(reused == 1){
+        printf(" File unchanged since it was last read, so not read again.\n");
     }
+    printf(" Read %d polygons.\n", polygonCount);
+    printf(" Reading complete. Analysing.\n");
     
     return(EXIT_SUCCESS);
 }
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////// CHECK ALL CONVEX ////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
-/* This function checks that all polygons in the list are convex.*/
+/* This function checks that all polygons in the list are convex. If any are
+ * not, it offers to replace each of them with its convex hull for collision
+ * checks, keeping the original shape for export. Otherwise they are split 
+ * into convex pieces, which the collision checks use instead. Polygons added
+ * to the scene later are treated in the same way.*/
 int checkAllConvex(){
     int i;
-    int any;
+    int any = 0;
     
     //for each polygon, check if it is convex
     for(i = 0; polygons[i] != NULL; i++){
@@ -342,12 +296,104 @@ int checkAllConvex(){
     }
     //if any polygon has been found convex, print a explanation once
     if(any == 1){
-        printf(" Functions using concave polygons may not work correctly.\n");
+        printf(" Concave polygons are split into convex pieces for collisions,\n"
+                " but fitting functions may not work correctly with them.\n"
+                " Input H to use the convex hull of each concave polygon instead\n"
+                " (its original shape is kept for export), or anything else to\n"
+                " keep them as they are.\n");
+        char c;
+        scanf(" %c", &c);
+        currentScene->preparation = (c == 'h' || c == 'H') ? SCENE_HULL : 
+                SCENE_SPLIT;
+        for(i = 0; polygons[i] != NULL; i++){
+            if(checkIfConvex(polygons[i]) == 1){
+                continue;
+            }
+            polygon* hull = NULL;
+            if(c == 'h' || c == 'H'){
+                hull = buildHullProxy(polygons[i]);
+            }
+            if(hull != NULL){
+                polygons[i] = hull;
+                printf(" Polygon %d replaced by its hull.\n", i+1);
+            }
+            else{
+                printf(" Polygon %d split into %d convex pieces.\n", i+1,
+                        attachConvexPieces(polygons[i]));
+            }
+        }
     }
     //otherwise print that all are fine.
     else{
         printf(" All polygons convex.\n");
+        currentScene->preparation = SCENE_SPLIT;
     }
     
     return(EXIT_SUCCESS);
 }
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////// SIMPLIFY ALL POLYGONS ///////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function builds the levels of detail for every polygon with enough 
+ * vertices to need them, so that checks on them can be answered quickly.*/
+int simplifyAllPolygons(){
+    int i;
+    for(i = 0; polygons[i] != NULL; i++){
+        int levels = attachPolygonDetail(polygons[i]);
+        if(levels > 0){
+            printf(" Polygon %d simplified to %d levels of detail.\n", i+1, levels);
+        }
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////// UPDATE POLYGONS /////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads an update file (see scene.c) and makes its changes to
+ * the loaded polygons, without reading the object file again. Only the
+ * polygons it names are changed, and each of them that is still there is then
+ * checked against the polygons near it, to show what it now collides with.
+ * Polygons are named by their ids, which are their numbers in the file they
+ * were read from, or the ids they were added with.*/
+int updatePolygons(){
+    char updateFilename[256];
+    printf(" Please input the filename of the update file.\n");
+    scanf("%255s", updateFilename);
+    
+    sceneSummary summary;
+    parseError error;
+    if(applySceneFile(currentScene, updateFilename, &summary, &error) != 
+            EXIT_SUCCESS){
+        if(error.line == 0){
+            printf(" Could not find file. Check filename.\n");
+        }
+        else{
+            printf(" ERROR: line %d, column %d: %s.\n", error.line, 
+                    error.column, error.message);
+            printf(" No changes were made.\n");
+        }
+        return(EXIT_FAILURE);
+    }
+    polygons = currentScene->polygons;
+    polygonCount = currentScene->count;
+    printf(" %d added, %d replaced, %d removed, %d moved. %d polygons now.\n",
+            summary.added, summary.replaced, summary.removed, summary.moved,
+            polygonCount);
+    
+    int* colliding = NULL;
+    int capacity = 0;
+    int i, j;
+    for(i = 0; i < summary.changedCount; i++){
+        int found = findSceneCollisions(currentScene, summary.changed[i], 
+                &colliding, &capacity);
+        for(j = 0; j < found; j++){
+            printf(" Polygon %d collides with polygon %d.\n", 
+                    summary.changed[i], colliding[j]);
+        }
+    }
+    free(colliding);
+    free(summary.changed);
+    return(EXIT_SUCCESS);
+}
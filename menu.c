@@ -8,14 +8,41 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <signal.h>
 #include "menu.h"
 #include "vector.h"
 #include "polygon.h"
 #include "collision.h"
+#include "sampler.h"
+#include "scalecache.h"
 #include "applications.h"
+#include "applicationsMultiple.h"
+#include "batch.h"
+#include "hull.h"
+#include "continuous.h"
+#include "distance.h"
+#include "parallel.h"
+#include "parser.h"
+#include "binary.h"
+#include "scene.h"
+#include "export.h"
+#include "results.h"
+
+//externalise the polygons function, a NULL-terminated list, and its length,
+//and the scene they are kept in
+extern struct polygon** polygons;
+extern int polygonCount;
+extern scene* currentScene;
+
+//the file the results of checks and fits are logged to, if any (see L)
+static struct resultSink* resultLog = NULL;
+
+//moves a polygon, numbered from 1 as in the menu, to where it now is in the
+//scene's grid, once it has been saved somewhere new
+static int refreshPolygon(int number){
+    return refreshScenePolygon(currentScene, currentScene->ids[number-1]);
+}
 
-//externalise the polygons function
-extern struct polygon* polygons[20];
 /*===========================================================================
  *======================= PRINT OPENING =====================================
  * ==========================================================================
@@ -51,6 +78,9 @@ char runMenu(){
             "  B: Check object inside bound.    R: Fit object to bound.\n" 
             "  F: See input file format.        I: Input different file.\n"
             "  E: Export objects as image.      S: Shrink objects to fit.\n"
+            "  N: Nest objects in bound.        J: Run a batch of fits.\n"
+            "  M: Move objects into contact.    V: Convert an object file.\n"
+            "  U: Apply an update file.         L: Log results to a file.\n"
             "  X: Close.\n");
             
     //create a char for menu response
@@ -98,11 +128,30 @@ int compareTwoObjects(){
         }
     }
     
-    //check collisions between the two given shapes
-    if(checkCollisions(polygons[num1-1], polygons[num2-1]) == 1){
+    //check collisions between the two given shapes, logging the result if
+    //asked
+    int result;
+    if(resultLog != NULL){
+        resultRecord record;
+        result = measureCollision(polygons[num1-1], polygons[num2-1], num1, 
+                num2, &record);
+        writeResult(resultLog, &record);
+        flushResultSink(resultLog);
+    }
+    else{
+        result = checkCollisions(polygons[num1-1], polygons[num2-1]);
+    }
+    if(result == 1){
         //if the return value from the function is one, a gap has been found
         printf(" RESULT: Gap found. Objects %d and %d do not collide.\n", 
                 num1, num2);
+        
+        //and say how far apart they are
+        clearance* gap = findClearance(polygons[num1-1], polygons[num2-1], NULL);
+        printf(" They are %f apart, closest at %f %f on object %d and\n"
+                " %f %f on object %d.\n", gap->distance, gap->pointA->x, 
+                gap->pointA->y, num1, gap->pointB->x, gap->pointB->y, num2);
+        freeClearance(gap);
     }else{
         //otherwise a gap has not been found.
         printf(" RESULT: Gap not found. Objects %d and %d collide.\n", 
@@ -130,8 +179,19 @@ int compareAllObjects(){
         //for each polygon with a lower number than it
         for(j=0; j < i; j++){
             
-            //check collisions between the two given shapes
-            if(checkCollisions(polygons[i], polygons[j]) == 1){
+            //check collisions between the two given shapes, logging the
+            //result if asked
+            int result;
+            if(resultLog != NULL){
+                resultRecord record;
+                result = measureCollision(polygons[j], polygons[i], j+1, i+1,
+                        &record);
+                writeResult(resultLog, &record);
+            }
+            else{
+                result = checkCollisions(polygons[i], polygons[j]);
+            }
+            if(result == 1){
                 //if the return value from the function is one, a gap has been found
                 printf(" Objects %d and %d do not collide.\n", j+1, i+1);
             }else{
@@ -143,6 +203,9 @@ int compareAllObjects(){
         //reset J to 0 to start the cycle again
         j=0;
     }
+    if(resultLog != NULL){
+        flushResultSink(resultLog);
+    }
     return(EXIT_SUCCESS);
 }
 
@@ -163,7 +226,9 @@ int printFileDetails(){
             " lines.\n"
             " On windows, I would suggest using Notepad++\n\n"
             " For all functions to work properly, vertices should be in\n"
-            " clockwise order around a polygon, and polygons should be convex.\n");
+            " clockwise order around a polygon, and polygons should be convex.\n\n"
+            " Files can also be converted to a binary form (see V), which is\n"
+            " smaller and much quicker to read, and read in the same way.\n");
     return(EXIT_SUCCESS);
 }
 
@@ -201,8 +266,19 @@ int compareBoundingBox(){
         }
     }
     
-    //check if polygon num1 is inside polygon num2
-    if(checkInsideBoundingBox(polygons[num1-1], polygons[num2-1]) == 1){
+    //check if polygon num1 is inside polygon num2, logging the result if asked
+    int result;
+    if(resultLog != NULL){
+        resultRecord record;
+        result = measureContainment(polygons[num1-1], polygons[num2-1], num1,
+                num2, &record);
+        writeResult(resultLog, &record);
+        flushResultSink(resultLog);
+    }
+    else{
+        result = checkInsideBoundingBox(polygons[num1-1], polygons[num2-1]);
+    }
+    if(result == 1){
         //if the return value from the function is one, it is inside
         printf(" RESULT: Object %d is fully inside object %d.\n", 
                 num1, num2);
@@ -220,7 +296,7 @@ int compareBoundingBox(){
  * 
  * This method gets the information needed from the user to export the current
  * state of the polygons as an SVG image file, wrapped in an HTML shell so it
- * should be viewable in any browser.
+ * should be viewable in any browser (see export.c).
  * 
  */
 int exportToHTML(){
@@ -232,18 +308,12 @@ int exportToHTML(){
     
     //get a filename from the user and use it to open a new file
     char filename[100];
-    scanf("%s", filename);
+    scanf("%99s", filename);
     FILE* exportFile = fopen(filename, "w");
-    
-    //initialise a list of colors for the polygons, as strings
-    char *colors[] = {
-        "Blue","Red","Black",
-        "Green","Fuchsia","Purple",
-        "Navy","Gray","Maroon","Olive",
-        "Blue","Red","Black",
-        "Green","Fuchsia","Purple",
-        "Navy","Gray","Maroon","Olive"
-    };
+    if(exportFile == NULL){
+        printf(" Could not open %s to write.\n", filename);
+        return(EXIT_FAILURE);
+    }
     
     int height = 0;
     int width = 0;
@@ -270,49 +340,64 @@ int exportToHTML(){
         }
     }
     
-    //print the opening of the file to the file, including the given dimensions
-    fprintf(exportFile, "<!DOCTYPE html>\n"
-                        "<html>\n"
-                        "<body>\n"
-                        "\n"
-                        "<svg height=\"%d\" width=\"%d\">\n", height, width);
-
-
-    
-    //print each polyline
-    int polylines;
-    for(polylines = 0; polygons[polylines] != NULL; polylines++){
-        //open the polyline
-        fprintf(exportFile, "    <polyline points=\"");
-        
-        //print each vector of the polyline
-        int v;
-        for(v = 0; polygons[polylines]->vertices[v] != NULL; v++){
-            fprintf(exportFile, "%f,%f ", polygons[polylines]->vertices[v]->x,
-                                          polygons[polylines]->vertices[v]->y);
+    //the area of the scene to draw
+    exportView view;
+    view.width = width;
+    view.height = height;
+    view.detail = 0.5;
+    view.area.minX = 0;
+    view.area.minY = 0;
+    view.area.maxX = width;
+    view.area.maxY = height;
+    printf(" Input A to draw every polygon fitted to the canvas, V to give the\n"
+            " area to draw, or anything else to draw the canvas area as it is.\n");
+    char c;
+    scanf(" %c", &c);
+    if(c == 'a' || c == 'A'){
+        setViewToFit(&view, polygons);
+    }
+    else if(c == 'v' || c == 'V'){
+        printf(" Please input the area as min x, min y, max x and max y:\n");
+        while(scanf("%lf %lf %lf %lf", &view.area.minX, &view.area.minY,
+                &view.area.maxX, &view.area.maxY) != 4 || 
+                view.area.maxX <= view.area.minX || 
+                view.area.maxY <= view.area.minY){
+            scanf("%*[^\n]");
+            printf(" Please input four numbers, with each max above its min.\n");
         }
-        
-        //print the first vector again to close the polyline
-        fprintf(exportFile, "%f,%f ", polygons[polylines]->vertices[0]->x,
-                                      polygons[polylines]->vertices[0]->y);
-        
-        //close the polyline with some style info, including a picked color
-        fprintf(exportFile, "\"\n");
-        fprintf(exportFile, "    style=\"fill:none;stroke: %s ;stroke-width:2\" />\n", 
-                                                            colors[polylines]);
-    }
-    
-    //finish the file, including a note for if SVG is not supported
-    fprintf(exportFile, "Your browser does not support inline SVG.\n"
-                        "</svg>\n"
-                        "<div>Generated by Collision Checker\n"
-                        "</body>\n"
-                        "</html>");
+    }
+    
+    int drawn = writeHTML(exportFile, polygons, currentScene, &view);
+    if(fclose(exportFile) != 0 || drawn < 0){
+        printf(" Could not write all of %s.\n", filename);
+        return(EXIT_FAILURE);
+    }
+    printf("Exported %d polygons to %s\n", drawn, filename);
+    return(EXIT_SUCCESS);
+}
+/* These functions let the user follow and stop a running fit. printFitProgress
+ * is called by the fitting functions after each position tried, and rewrites
+ * one line with the best fit so far. cancelFit is called when Ctrl+C is
+ * pressed during a fit, and sets the flag the fitting functions check.
+ * 
+ * fitCache keeps the results of every fit run from the menu, so that running
+ * the same fit again reuses them.
+ */
+static volatile int fitCancelled = 0;
+static scaleCache* fitCache = NULL;
 
-    printf("Exported to %s\n", filename);  
-    fclose(exportFile);
+static void cancelFit(int signal){
+    fitCancelled = 1;
+}
+
+static int printFitProgress(int done, int total, transformation* best, 
+        void* data){
+    printf("\r Tested %d of %d positions. Best scale so far: %f", done, total,
+            best->scale);
+    fflush(stdout);
     return(EXIT_SUCCESS);
 }
+
 /*===========================================================================
  *=========================== FIT OBJECT ============================
  * ==========================================================================
@@ -329,8 +414,9 @@ int fitObject(){
             " a multiple of the original size.\n");
     //create chars for responses
     int num1 = 1, num2 = 1, p = 0, iterations = 0;
+    double timeLimit = 0;
     
-    //for each of polygon numbers, precision, and iterations,
+    //for each of polygon numbers, precision, iterations and time limit,
     //loop through the function until we get a correct response and can break
     for(;;){
         //read the first number from the user's response
@@ -377,9 +463,62 @@ int fitObject(){
             printf(" Please input a valid number.\n");
         }
     }
+    printf(" The fit can be stopped after a number of seconds, returning the\n"
+            " best fit found so far.\n");
+    for(;;){
+        //read the time limit from the user's response
+        printf(" Input the time limit in seconds, or 0 for no limit.\n");
+        if(scanf("%lf", &timeLimit) > 0 && timeLimit >= 0){
+            break;
+        }
+        else{
+            printf(" Please input a valid number.\n");
+        }
+    }
+    
+    //pick a seed for the random positions, and print it so the run can be
+    //repeated
+    fitOptions* options = buildFitOptions((unsigned long)rand(), 0);
+    options->timeLimit = timeLimit;
+    options->progress = printFitProgress;
+    options->cancel = &fitCancelled;
     
+    //keep results between fits, so repeating a fit is quicker
+    if(fitCache == NULL){
+        fitCache = buildScaleCache(100000);
+    }
+    options->cache = fitCache;
+    printf(" Fitting with seed %lu on %d threads.\n", options->seed,
+            getProcessorCount());
+    printf(" Press Ctrl+C to stop early and keep the best fit so far.\n");
+    
+    //let Ctrl+C stop the fit rather than the program while it runs
+    fitCancelled = 0;
+    signal(SIGINT, cancelFit);
+    //the cache counts over every fit, so note where it was before this one
+    long hits = fitCache->hits, misses = fitCache->misses;
+    double start = getTimeSeconds();
     transformation* t = findMinScaleWithTranslation(polygons[num1-1], 
-                            polygons[num2-1], p, iterations);
+                            polygons[num2-1], p, iterations, options);
+    double seconds = getTimeSeconds() - start;
+    signal(SIGINT, SIG_DFL);
+    
+    //log the fit if asked
+    if(resultLog != NULL){
+        resultRecord record;
+        fillFitRecord(t, options, num1, num2, seconds, &record);
+        writeResult(resultLog, &record);
+        flushResultSink(resultLog);
+    }
+    
+    if(options->stopped == 1){
+        printf("\n Stopped early after %ld evaluations.", options->evaluations);
+    }
+    hits = fitCache->hits - hits;
+    misses = fitCache->misses - misses;
+    printf("\n Reused %ld of %ld scales from previous results.", hits,
+            hits + misses);
+    free(options);
     
     printf("\n The minimum scale that object %d can be to still contain object %d\n"
             " is %f times it's original scale. This occurs  at %f degrees of \n"
@@ -397,6 +536,8 @@ int fitObject(){
         scalePolygonTo(polygons[num2-1], t->scale);
         rotatePolygonZTo(polygons[num1-1], t->rotationZ);
         translatePolygonTo(polygons[num1-1], t->translation);
+        refreshPolygon(num1);
+        refreshPolygon(num2);
         printf(" Saving polygons.\n");
     }
     else{
@@ -406,6 +547,391 @@ int fitObject(){
     return(EXIT_SUCCESS);
 }
 
+/*===========================================================================
+ *=========================== LOG RESULTS ===================================
+ * ==========================================================================
+ * 
+ * This method gets a file from the user to log the results of comparing (C, A
+ * and B) and fitting (S and J) objects to, as CSV or, for files ending .jsonl, as
+ * JSON Lines (see results.c), or stops logging them.
+ * 
+ */
+int logResults(){
+    printf(" This function writes the result of each comparison and fit to a\n"
+            " file as well, for other programs to read. Files ending .jsonl are\n"
+            " written as JSON Lines, and any others as CSV.\n"
+            " Please type the filename to log to, or - to stop logging.\n");
+    char filename[100];
+    scanf("%99s", filename);
+    
+    //stop logging to any file already open
+    if(resultLog != NULL){
+        if(closeResultSink(resultLog) != EXIT_SUCCESS){
+            printf(" Could not write all of the previous log.\n");
+        }
+        resultLog = NULL;
+    }
+    if(strcmp(filename, "-") == 0){
+        printf(" Results are no longer logged.\n");
+        return(EXIT_SUCCESS);
+    }
+    
+    resultLog = openResultSink(filename);
+    if(resultLog == NULL){
+        printf(" Could not open %s to write.\n", filename);
+        return(EXIT_FAILURE);
+    }
+    printf(" Logging results to %s.\n", filename);
+    return(EXIT_SUCCESS);
+}
+
+/*===========================================================================
+ *=========================== NEST OBJECTS ==================================
+ * ==========================================================================
+ * 
+ * This method gathers the bound to use from the user, and then places as many
+ * of the other polygons inside it as possible without any overlapping. It
+ * prints where each polygon goes and how much of the bound is used, and offers
+ * to move the polygons there.
+ * 
+ */
+int nestObjects(){
+    printf(" This function places as many of the objects as possible inside one\n"
+            " bound without any of them overlapping, moving and rotating them but\n"
+            " not changing their size.\n");
+    int num = 1, rotations = 1, i, count = 0;
+    
+    for(;;){
+        //read the bound's number from the user's response
+        printf(" Input the number of the bound to nest the objects in.\n");
+        if(scanf("%d", &num) > 0 && num > 0 && num <= polygonCount && 
+                polygons[num-1] != NULL){
+            break;
+        }
+        else{
+            printf(" Please input the number of a polygon.\n");
+        }
+    }
+    printf(" Each object can be tried at a number of rotations spread evenly\n"
+            " around a full turn (1 for no rotation, 4 for every 90 degrees).\n");
+    for(;;){
+        printf(" Input the number of rotations to try.\n");
+        if(scanf("%d", &rotations) > 0 && rotations > 0){
+            break;
+        }
+        else{
+            printf(" Please input a number above 0.\n");
+        }
+    }
+    
+    //list every polygon except the bound as a part
+    polygon** parts = malloc(sizeof(polygon*)*(polygonCount+1));
+    int* partNumbers = malloc(sizeof(int)*polygonCount);
+    for(i = 0; polygons[i] != NULL; i++){
+        if(i != num-1){
+            parts[count] = polygons[i];
+            partNumbers[count] = i+1;
+            count++;
+        }
+    }
+    parts[count] = NULL;
+    
+    packResult* r = packPolygons(parts, polygons[num-1], rotations);
+    
+    for(i = 0; i < r->count; i++){
+        transformation* t = r->placements[i];
+        if(t != NULL){
+            printf(" Object %d: %f degrees of rotation, at centre %f %f.\n",
+                    partNumbers[i], t->rotationZ, t->translation->x,
+                    t->translation->y);
+        }
+        else{
+            printf(" Object %d: does not fit.\n", partNumbers[i]);
+        }
+    }
+    printf("\n Placed %d of %d objects, using %f%% of the bound.\n", r->placed,
+            r->count, r->utilisation*100);
+    
+    printf(" \n Input S to save the polygons' new locations or anything else to\n"
+            " leave them in their previous position.\n");
+    
+    char c;
+    scanf(" %c", &c);
+    if(c == 's' || c == 'S'){
+        for(i = 0; i < r->count; i++){
+            transformation* t = r->placements[i];
+            if(t != NULL){
+                rotatePolygonZTo(parts[i], t->rotationZ);
+                translatePolygonTo(parts[i], t->translation);
+                refreshPolygon(partNumbers[i]);
+            }
+        }
+        printf(" Saving polygons.\n");
+    }
+    else{
+        printf(" Returning polygons to original positions.\n");
+    }
+    
+    freePackResult(r);
+    free(parts);
+    free(partNumbers);
+    return(EXIT_SUCCESS);
+}
+
+/*===========================================================================
+ *=========================== BATCH FIT =====================================
+ * ==========================================================================
+ * 
+ * This method gathers a job file and an output file from the user and runs
+ * every fit listed in the job file on the loaded polygons, without asking for
+ * anything else. See batch.c for the format of the job file.
+ * 
+ */
+int batchFit(){
+    printf(" This function runs a list of fits from a job file. Each line of the\n"
+            " job file holds one fit as:\n"
+            "   inside outside precision iterations [seconds]\n"
+            " Results are written to the output file as each finishes. If the\n"
+            " output file already has results, those jobs are skipped.\n");
+    char jobFilename[256], outputFilename[256];
+    printf(" Input the filename of the job file.\n");
+    scanf("%255s", jobFilename);
+    printf(" Input the filename of the output file.\n");
+    scanf("%255s", outputFilename);
+    
+    printf(" Press Ctrl+C to stop. Running the same files again carries on.\n");
+    fitCancelled = 0;
+    signal(SIGINT, cancelFit);
+    int result = runBatch(polygons, jobFilename, outputFilename, 0, &fitCancelled,
+            resultLog);
+    signal(SIGINT, SIG_DFL);
+    if(resultLog != NULL){
+        flushResultSink(resultLog);
+    }
+    
+    if(fitCancelled != 0){
+        printf(" Stopped. Run again with the same files to carry on.\n");
+    }
+    return result;
+}
+
+/*===========================================================================
+ *=========================== FIT TO BOUND ==================================
+ * ==========================================================================
+ * 
+ * This method gathers two polygons from the user and finds the tightest shapes
+ * around the first directly, rather than by searching: the smallest rectangle
+ * at any rotation, and the smallest scale of the second polygon (the bound) at
+ * its current position and rotation.
+ * 
+ */
+int fitToBound(){
+    printf(" This function finds the smallest rectangle around an object at any\n"
+            " rotation, and the smallest scale of a bound that still contains\n"
+            " the object without moving or rotating either.\n");
+    int num1 = 1, num2 = 1;
+    for(;;){
+        printf(" Input the number of the object.\n");
+        if(scanf("%d", &num1) > 0 && num1 > 0 && num1 <= polygonCount &&
+                polygons[num1-1] != NULL){
+            break;
+        }
+        else{
+            printf(" Please input the number of a polygon.\n");
+        }
+    }
+    for(;;){
+        printf(" Input the number of the bound.\n");
+        if(scanf("%d", &num2) > 0 && num2 > 0 && num2 <= polygonCount &&
+                polygons[num2-1] != NULL){
+            break;
+        }
+        else{
+            printf(" Please input the number of a polygon.\n");
+        }
+    }
+    
+    orientedBox* box = findMinAreaRectangle(polygons[num1-1]);
+    if(box != NULL){
+        printf("\n The smallest rectangle around object %d is %f by %f (area %f),\n"
+                " at centre %f %f with its long side at %f degrees.\n", num1,
+                box->width, box->height, box->area, box->centre->x,
+                box->centre->y, (box->width >= box->height) ? box->angle :
+                box->angle + 90);
+        freeOrientedBox(box);
+    }
+    else{
+        printf("\n Object %d has no area, so has no smallest rectangle.\n", num1);
+    }
+    
+    double scale = findMinScaleExact(polygons[num1-1], polygons[num2-1]);
+    if(scale < 0){
+        printf(" Object %d is not convex, so the smallest scale can't be found\n"
+                " directly. Use S to shrink it to fit instead.\n", num2);
+        return(EXIT_SUCCESS);
+    }
+    printf(" The minimum scale that object %d can be to still contain object %d\n"
+            " is %f times it's original scale.\n", num2, num1, scale);
+    
+    printf(" \n Input S to save the bound's new scale or anything else to leave\n"
+            " it at its previous scale.\n");
+    char c;
+    scanf(" %c", &c);
+    if(c == 's' || c == 'S'){
+        scalePolygonTo(polygons[num2-1], scale);
+        refreshPolygon(num2);
+        printf(" Saving polygons.\n");
+    }
+    else{
+        printf(" Returning polygons to original positions.\n");
+    }
+    return(EXIT_SUCCESS);
+}
+
+/*===========================================================================
+ *=========================== MOVE OBJECTS ==================================
+ * ==========================================================================
+ * 
+ * This method gets two objects and where each should move to, and finds when
+ * on their way they first touch.
+ * 
+ */
+static int readMovingObject(const char* which, int* num, transformation** start,
+        transformation** end){
+    for(;;){
+        printf(" Input the number of the %s object.\n", which);
+        if(scanf("%d", num) > 0 && *num > 0 && *num <= polygonCount &&
+                polygons[*num-1] != NULL){
+            break;
+        }
+        else{
+            printf(" Please input the number of a polygon.\n");
+        }
+    }
+    polygon* p = polygons[*num-1];
+    double x, y, angle;
+    for(;;){
+        printf(" Input the x and y co-ordinates that object %d's centre moves to, and\n"
+                " the angle in degrees it turns to, separated by spaces.\n", *num);
+        if(scanf("%lf %lf %lf", &x, &y, &angle) == 3){
+            break;
+        }
+        else{
+            printf(" Please input three numbers.\n");
+        }
+    }
+    *start = buildTransformation(p->transform->scale, p->transform->rotationZ,
+            createVector(p->centre->x, p->centre->y, p->centre->z));
+    *end = buildTransformation(p->transform->scale, angle,
+            createVector(x, y, p->centre->z));
+    return(EXIT_SUCCESS);
+}
+
+int moveObjects(){
+    printf(" This function moves two objects in straight lines from where they\n"
+            " are now, turning as they go, and finds when they first touch.\n");
+    int num1 = 1, num2 = 1;
+    transformation *start1, *end1, *start2, *end2;
+    readMovingObject("first", &num1, &start1, &end1);
+    readMovingObject("second", &num2, &start2, &end2);
+    
+    impact* result = findTimeOfImpact(polygons[num1-1], start1, end1,
+            polygons[num2-1], start2, end2, 1e-6);
+    double time = 1;
+    if(result->collide == 1){
+        time = result->time;
+        printf("\n RESULT: Objects %d and %d first touch %f of the way along\n"
+                " their paths, where they meet along the direction %f %f.\n",
+                num1, num2, time, result->axis->x, result->axis->y);
+    }
+    else if(result->collide == IMPACT_UNRESOLVED){
+        //they are only known to be apart up to the time reached, so they are
+        //stopped there
+        time = result->time;
+        printf("\n RESULT: Could not tell whether objects %d and %d touch in %d\n"
+                " steps. They don't touch for the first %f of the way along\n"
+                " their paths.\n", num1, num2, result->steps, time);
+    }
+    else{
+        printf("\n RESULT: Objects %d and %d do not touch on their paths.\n",
+                num1, num2);
+    }
+    freeImpact(result);
+    
+    printf(" \n Input S to save the objects where they stop or anything else\n"
+            " to leave them in their previous positions.\n");
+    char c;
+    scanf(" %c", &c);
+    if(c == 's' || c == 'S'){
+        movePolygonAlong(polygons[num1-1], start1, end1, time);
+        movePolygonAlong(polygons[num2-1], start2, end2, time);
+        refreshPolygon(num1);
+        refreshPolygon(num2);
+        printf(" Saving polygons.\n");
+    }
+    else{
+        printf(" Returning polygons to original positions.\n");
+    }
+    
+    free(start1->translation);
+    free(start1);
+    free(end1->translation);
+    free(end1);
+    free(start2->translation);
+    free(start2);
+    free(end2->translation);
+    free(end2);
+    return(EXIT_SUCCESS);
+}
+
+/*===========================================================================
+ *=========================== CONVERT FILE ==================================
+ * ==========================================================================
+ * 
+ * This method converts an object file between text and binary form, in either
+ * direction, without changing the objects already loaded.
+ * 
+ */
+int convertFile(){
+    char from[256], to[256];
+    char form;
+    
+    printf(" Please input the filename of the object file to convert:\n");
+    scanf("%255s", from);
+    printf(" Please input the filename to save it as:\n");
+    scanf("%255s", to);
+    
+    int format = -1;
+    while(format < 0){
+        printf(" Save it as T: text, D: binary (doubles), F: binary (floats),\n"
+                " or Q: binary (quantised to 65535 steps across the objects)?\n");
+        scanf(" %c", &form);
+        switch(form){
+            case 't': case 'T': format = OBJECT_TEXT; break;
+            case 'd': case 'D': format = BINARY_DOUBLE; break;
+            case 'f': case 'F': format = BINARY_FLOAT; break;
+            case 'q': case 'Q': format = BINARY_QUANTISED; break;
+            default: printf(" Please choose T, D, F or Q.\n");
+        }
+    }
+    
+    parseError error;
+    double start = getTimeSeconds();
+    if(convertObjectFile(from, to, format, &error) != EXIT_SUCCESS){
+        if(error.line > 0){
+            printf(" ERROR: line %d, column %d: %s.\n", error.line, 
+                    error.column, error.message);
+        }
+        else{
+            printf(" ERROR: %s.\n", error.message);
+        }
+        return(EXIT_FAILURE);
+    }
+    printf(" Converted %s to %s in %.3f seconds.\n", from, to, 
+            getTimeSeconds() - start);
+    return(EXIT_SUCCESS);
+}
+
 /// debug
 //by uncommenting the section in the *run Menu* function, this can be used to
 //run code directly.
@@ -26,6 +26,12 @@ extern "C" {
     int compareBoundingBox();
     int exportToHTML();
     int fitObject();
+    int logResults();
+    int nestObjects();
+    int batchFit();
+    int fitToBound();
+    int moveObjects();
+    int convertFile();
     int debug();
 
 #ifdef __cplusplus
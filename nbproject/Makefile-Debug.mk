@@ -37,10 +37,31 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 OBJECTFILES= \
 	${OBJECTDIR}/applications.o \
 	${OBJECTDIR}/applicationsMultiple.o \
+	${OBJECTDIR}/batch.o \
+	${OBJECTDIR}/binary.o \
+	${OBJECTDIR}/broadphase.o \
+	${OBJECTDIR}/cli.o \
 	${OBJECTDIR}/collision.o \
+	${OBJECTDIR}/continuous.o \
+	${OBJECTDIR}/decompose.o \
+	${OBJECTDIR}/distance.o \
+	${OBJECTDIR}/export.o \
+	${OBJECTDIR}/extreme.o \
+	${OBJECTDIR}/hull.o \
+	${OBJECTDIR}/innerfit.o \
+	${OBJECTDIR}/loader.o \
+	${OBJECTDIR}/lod.o \
 	${OBJECTDIR}/main.o \
 	${OBJECTDIR}/menu.o \
+	${OBJECTDIR}/parallel.o \
+	${OBJECTDIR}/parser.o \
 	${OBJECTDIR}/polygon.o \
+	${OBJECTDIR}/results.o \
+	${OBJECTDIR}/sampler.o \
+	${OBJECTDIR}/scalecache.o \
+	${OBJECTDIR}/scene.o \
+	${OBJECTDIR}/server.o \
+	${OBJECTDIR}/simulation.o \
 	${OBJECTDIR}/vector.o
 
 
@@ -58,7 +79,7 @@ FFLAGS=
 ASFLAGS=
 
 # Link Libraries and Options
-LDLIBSOPTIONS=
+LDLIBSOPTIONS=-lm -lpthread
 
 # Build Targets
 .build-conf: ${BUILD_SUBPROJECTS}
@@ -78,11 +99,76 @@ ${OBJECTDIR}/applicationsMultiple.o: applicationsMultiple.c
 	${RM} "$@.d"
 	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/applicationsMultiple.o applicationsMultiple.c
 
+${OBJECTDIR}/batch.o: batch.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/batch.o batch.c
+
+${OBJECTDIR}/binary.o: binary.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/binary.o binary.c
+
+${OBJECTDIR}/broadphase.o: broadphase.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/broadphase.o broadphase.c
+
+${OBJECTDIR}/cli.o: cli.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/cli.o cli.c
+
 ${OBJECTDIR}/collision.o: collision.c 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
 	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/collision.o collision.c
 
+${OBJECTDIR}/continuous.o: continuous.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/continuous.o continuous.c
+
+${OBJECTDIR}/decompose.o: decompose.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/decompose.o decompose.c
+
+${OBJECTDIR}/distance.o: distance.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/distance.o distance.c
+
+${OBJECTDIR}/export.o: export.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/export.o export.c
+
+${OBJECTDIR}/extreme.o: extreme.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/extreme.o extreme.c
+
+${OBJECTDIR}/hull.o: hull.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/hull.o hull.c
+
+${OBJECTDIR}/innerfit.o: innerfit.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/innerfit.o innerfit.c
+
+${OBJECTDIR}/loader.o: loader.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/loader.o loader.c
+
+${OBJECTDIR}/lod.o: lod.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/lod.o lod.c
+
 ${OBJECTDIR}/main.o: main.c 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -93,11 +179,51 @@ ${OBJECTDIR}/menu.o: menu.c
 	${RM} "$@.d"
 	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/menu.o menu.c
 
+${OBJECTDIR}/parallel.o: parallel.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/parallel.o parallel.c
+
+${OBJECTDIR}/parser.o: parser.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/parser.o parser.c
+
 ${OBJECTDIR}/polygon.o: polygon.c 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
 	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/polygon.o polygon.c
 
+${OBJECTDIR}/results.o: results.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/results.o results.c
+
+${OBJECTDIR}/sampler.o: sampler.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/sampler.o sampler.c
+
+${OBJECTDIR}/scalecache.o: scalecache.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/scalecache.o scalecache.c
+
+${OBJECTDIR}/scene.o: scene.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/scene.o scene.c
+
+${OBJECTDIR}/server.o: server.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/server.o server.c
+
+${OBJECTDIR}/simulation.o: simulation.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -Wall -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/simulation.o simulation.c
+
 ${OBJECTDIR}/vector.o: vector.c 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -0,0 +1,184 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          PARALLEL
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains a small thread pool used to run independent pieces of
+ * work - such as the trials of the fitting functions - on several processors at
+ * once.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <time.h>
+#endif
+#include "parallel.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// PARALLEL WORK TYPE DEFINITION //////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This struct holds the state shared by all the threads of one parallelFor
+ * call: the job to run, the next index to hand out, and whether a job has asked
+ * for the work to stop.
+ */
+typedef struct parallelWork{
+    parallelJob job;
+    void* data;
+    int count;
+    int next;
+    int stop;
+    pthread_mutex_t lock;
+}parallelWork;
+
+typedef struct parallelWorker{
+    parallelWork* work;
+    int thread;
+}parallelWorker;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET PROCESSOR COUNT ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function returns the number of processors available, for use as the
+ * default number of threads. It always returns at least 1.
+ */
+int getProcessorCount(){
+    int count;
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    count = (int)info.dwNumberOfProcessors;
+#else
+    count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if(count < 1){
+        count = 1;
+    }
+    return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET TIME SECONDS ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function returns the time in seconds from a steady clock, for measuring
+ * how long something has taken. Unlike clock() it counts real time rather than
+ * processor time, so it isn't thrown off by several threads running at once.
+ */
+double getTimeSeconds(){
+#ifdef _WIN32
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (double)count.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1000000000.0;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RUN WORKER /////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function is run by each thread. It repeatedly takes the next unclaimed
+ * index and runs the job for it, until every index has been handed out or a
+ * job has returned a failure.
+ */
+static void* runWorker(void* arg){
+    parallelWorker* worker = (parallelWorker*)arg;
+    parallelWork* work = worker->work;
+    
+    for(;;){
+        //claim the next index
+        pthread_mutex_lock(&work->lock);
+        if(work->stop == 1 || work->next >= work->count){
+            pthread_mutex_unlock(&work->lock);
+            break;
+        }
+        int index = work->next;
+        work->next++;
+        pthread_mutex_unlock(&work->lock);
+        
+        //run the job, and if it fails stop handing out indices
+        if(work->job(index, worker->thread, work->data) != EXIT_SUCCESS){
+            pthread_mutex_lock(&work->lock);
+            work->stop = 1;
+            pthread_mutex_unlock(&work->lock);
+        }
+    }
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// PARALLEL FOR ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function runs job(index, thread, data) once for every index from 0 to
+ * count-1, spread across the given number of threads. Indices are handed out in
+ * order as threads become free. "thread" runs from 0 to threads-1 and can be 
+ * used to pick a per-thread workspace out of data.
+ * 
+ * If threads is 1 or less the jobs are simply run in order on this thread.
+ * 
+ * If any job returns something other than EXIT_SUCCESS no further indices are
+ * started, and this function returns EXIT_FAILURE once running jobs finish.
+ */
+int parallelFor(int count, int threads, parallelJob job, void* data){
+    parallelWork work;
+    work.job = job;
+    work.data = data;
+    work.count = count;
+    work.next = 0;
+    work.stop = 0;
+    
+    if(threads > count){
+        threads = count;
+    }
+    
+    //with one thread there is no need for the pool
+    if(threads <= 1){
+        int i;
+        for(i = 0; i < count; i++){
+            if(job(i, 0, data) != EXIT_SUCCESS){
+                return(EXIT_FAILURE);
+            }
+        }
+        return(EXIT_SUCCESS);
+    }
+    
+    pthread_mutex_init(&work.lock, NULL);
+    pthread_t* handles = malloc(sizeof(pthread_t)*threads);
+    parallelWorker* workers = malloc(sizeof(parallelWorker)*threads);
+    
+    //start a thread for each worker. This thread acts as worker 0.
+    int i;
+    for(i = 0; i < threads; i++){
+        workers[i].work = &work;
+        workers[i].thread = i;
+    }
+    for(i = 1; i < threads; i++){
+        if(pthread_create(&handles[i], NULL, runWorker, &workers[i]) != 0){
+            //if a thread can't be started, the others will take its share
+            workers[i].work = NULL;
+        }
+    }
+    runWorker(&workers[0]);
+    
+    //wait for the other threads to finish
+    for(i = 1; i < threads; i++){
+        if(workers[i].work != NULL){
+            pthread_join(handles[i], NULL);
+        }
+    }
+    
+    pthread_mutex_destroy(&work.lock);
+    free(handles);
+    free(workers);
+    
+    if(work.stop == 1){
+        return(EXIT_FAILURE);
+    }
+    return(EXIT_SUCCESS);
+}
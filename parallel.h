@@ -0,0 +1,28 @@
+/* 
+ * File:   parallel.h
+ *
+ * This header file externalises the functions in the parallel.c file, which
+ * spread independent pieces of work across several threads.
+ * 
+ * For further details on any function, check there.
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int (*parallelJob)(int index, int thread, void* data);
+
+int getProcessorCount();
+double getTimeSeconds();
+int parallelFor(int count, int threads, parallelJob job, void* data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PARALLEL_H */
+
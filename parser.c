@@ -0,0 +1,604 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          PARSER
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to read polygons from an object file.
+ *
+ * The file is read in large blocks (or given already in memory, see loader.c)
+ * and passed over once, turning each number straight into a vertex and each
+ * line straight into a polygon. Nothing is kept of the text once it has been
+ * read, so lines can be any length and files can hold any number of polygons.
+ *
+ * Each line of the file is one polygon. Its vertices are separated by
+ * semicolons (with one allowed after the last), and the x, y and z
+ * co-ordinates of each by commas. Spaces and tabs can go between any of these,
+ * and blank lines are skipped. A polygon needs at least three vertices.
+ *
+ * If the file can't be read, the line and column (both counted from 1) where
+ * the problem was found are given with a description of it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "vector.h"
+#include "polygon.h"
+#include "parallel.h"
+#include "parser.h"
+
+//the number of bytes read from the file at once
+#define READ_BLOCK_SIZE (1 << 18)
+
+//text shorter than this is read on one thread, as starting more would take
+//longer than reading it
+#define CHUNK_MIN_SIZE (1 << 20)
+
+//the number of chunks text is split into for each thread, so that threads
+//given quick chunks can take more
+#define CHUNKS_PER_THREAD 4
+
+typedef struct textChunk{
+    const char* text;
+    size_t start;
+    size_t end;
+    polygon** polygons;
+    int count;
+    parseError error;
+}textChunk;
+
+typedef struct reader{
+    FILE* file;
+    char* buffer;
+    size_t length;
+    size_t position;
+    int line;
+    int column;
+    char* token;
+    int tokenCapacity;
+}reader;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// PARSE NUMBER ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads a number from the start of some text of the given
+ * length, in the same form as strtod: an optional sign, digits with an
+ * optional decimal point, and an optional exponent. The value is stored in
+ * value and the number of characters read is returned (0 if the text doesn't
+ * start with a number).
+ *
+ * Up to 19 significant digits are read into a whole number, and the decimal
+ * point and exponent into a power of ten. When the whole number fits exactly
+ * in a double and the power is at most 22 either way, both are exact and one
+ * multiplication or division gives the correctly rounded result, which covers
+ * almost every number written by hand or by other programs. Anything else is
+ * passed to strtod, so the result is always the same as strtod's.
+ */
+static const double powersOfTen[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+    1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+int parseNumber(const char* text, int length, double* value){
+    int i = 0;
+    int negative = 0;
+    if(i < length && (text[i] == '+' || text[i] == '-')){
+        negative = (text[i] == '-');
+        i++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0, anyDigits = 0, exact = 1;
+    long exponent = 0;
+
+    //the whole part. Leading zeros aren't significant, and digits past the
+    //19th only move the decimal point
+    while(i < length && text[i] >= '0' && text[i] <= '9'){
+        int d = text[i] - '0';
+        anyDigits = 1;
+        if(mantissa != 0 || d != 0){
+            if(digits < 19){
+                mantissa = mantissa*10 + d;
+                digits++;
+            }
+            else{
+                exponent++;
+                exact = exact && (d == 0);
+            }
+        }
+        i++;
+    }
+
+    //the fraction
+    if(i < length && text[i] == '.'){
+        i++;
+        while(i < length && text[i] >= '0' && text[i] <= '9'){
+            int d = text[i] - '0';
+            anyDigits = 1;
+            if(mantissa == 0 && d == 0){
+                exponent--;
+            }
+            else if(digits < 19){
+                mantissa = mantissa*10 + d;
+                digits++;
+                exponent--;
+            }
+            else{
+                exact = exact && (d == 0);
+            }
+            i++;
+        }
+    }
+    if(anyDigits == 0){
+        return 0;
+    }
+
+    //the exponent, which is only part of the number if it has digits
+    if(i < length && (text[i] == 'e' || text[i] == 'E')){
+        int j = i+1;
+        int negativeExponent = 0;
+        if(j < length && (text[j] == '+' || text[j] == '-')){
+            negativeExponent = (text[j] == '-');
+            j++;
+        }
+        if(j < length && text[j] >= '0' && text[j] <= '9'){
+            long e = 0;
+            while(j < length && text[j] >= '0' && text[j] <= '9'){
+                if(e < 100000){
+                    e = e*10 + (text[j] - '0');
+                }
+                j++;
+            }
+            exponent += negativeExponent ? -e : e;
+            i = j;
+        }
+    }
+
+    if(mantissa == 0){
+        *value = negative ? -0.0 : 0.0;
+    }
+    else if(exact && mantissa <= ((uint64_t)1 << 53) &&
+            exponent >= -22 && exponent <= 22){
+        *value = (double)mantissa;
+        if(exponent < 0){
+            *value = *value/powersOfTen[-exponent];
+        }
+        else{
+            *value = *value*powersOfTen[exponent];
+        }
+        if(negative){
+            *value = -*value;
+        }
+    }
+    else{
+        //strtod needs the number on its own
+        char small[64];
+        char* copy = (i < 64) ? small : malloc(i+1);
+        memcpy(copy, text, i);
+        copy[i] = '\0';
+        *value = strtod(copy, NULL);
+        if(copy != small){
+            free(copy);
+        }
+    }
+    return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READER /////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* These functions pass through the file a character at a time, reading the
+ * next block when one runs out and keeping track of the line and column.
+ * peekCharacter returns EOF at the end of the file, or at the end of the text
+ * if it was all given at once (when there is no file).
+ */
+static int peekCharacter(reader* r){
+    if(r->position == r->length){
+        if(r->file == NULL){
+            return EOF;
+        }
+        r->length = fread(r->buffer, 1, READ_BLOCK_SIZE, r->file);
+        r->position = 0;
+        if(r->length == 0){
+            return EOF;
+        }
+    }
+    return (unsigned char)r->buffer[r->position];
+}
+
+static int nextCharacter(reader* r){
+    int c = peekCharacter(r);
+    if(c == EOF){
+        return EOF;
+    }
+    r->position++;
+    if(c == '\n'){
+        r->line++;
+        r->column = 1;
+    }
+    else{
+        r->column++;
+    }
+    return c;
+}
+
+static int skipSpaces(reader* r){
+    int c = peekCharacter(r);
+    while(c == ' ' || c == '\t' || c == '\r'){
+        nextCharacter(r);
+        c = peekCharacter(r);
+    }
+    return c;
+}
+
+static int setError(parseError* error, int line, int column,
+        const char* message){
+    error->line = line;
+    error->column = column;
+    snprintf(error->message, sizeof(error->message), "%s", message);
+    return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ COORDINATE ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads one number from the file. The characters which could
+ * be part of it are gathered first, then they must all make up one number.
+ */
+static int isNumberCharacter(int c){
+    return (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+' ||
+            c == 'e' || c == 'E';
+}
+
+static int readCoordinate(reader* r, double* value, parseError* error){
+    skipSpaces(r);
+    int line = r->line, column = r->column;
+    int length = 0;
+
+    //usually the whole number is in the block already read, and can be read
+    //from there without copying it. Numbers never hold a new line, so only
+    //the column changes
+    const char* start = r->buffer + r->position;
+    size_t available = r->length - r->position;
+    while(length < available && isNumberCharacter(start[length])){
+        length++;
+    }
+    if(length > 0 && length < available){
+        if(parseNumber(start, length, value) != length){
+            return setError(error, line, column,
+                    "could not read this as a number");
+        }
+        r->position += length;
+        r->column += length;
+        if(isinf(*value)){
+            return setError(error, line, column, "number is too large");
+        }
+        return 0;
+    }
+
+    //otherwise it runs on into the next block, so is gathered a character at
+    //a time
+    length = 0;
+    int c = peekCharacter(r);
+    while(isNumberCharacter(c)){
+        if(length == r->tokenCapacity){
+            r->tokenCapacity = r->tokenCapacity*2;
+            r->token = realloc(r->token, r->tokenCapacity);
+        }
+        r->token[length++] = (char)nextCharacter(r);
+        c = peekCharacter(r);
+    }
+
+    if(length == 0){
+        return setError(error, line, column, "expected a number");
+    }
+    if(parseNumber(r->token, length, value) != length){
+        return setError(error, line, column, "could not read this as a number");
+    }
+    if(isinf(*value)){
+        return setError(error, line, column, "number is too large");
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FREE POLYGON LIST //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function frees a NULL-terminated list of polygons, and the polygons.
+ */
+int freePolygonList(polygon** list){
+    int i;
+    for(i = 0; list[i] != NULL; i++){
+        freePolygon(list[i]);
+    }
+    free(list);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// PARSE POLYGONS /////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads every polygon from a reader, and returns them as a
+ * NULL-terminated list, with the number read stored in count.
+ *
+ * If the text isn't in the right form, nothing is kept, the problem is stored
+ * in error, and NULL is returned.
+ */
+static polygon** parsePolygons(reader* r, int* count, parseError* error){
+    int polygonCapacity = 64, vertexCapacity = 64;
+    polygon** list = malloc(sizeof(polygon*)*polygonCapacity);
+    vector** vertices = malloc(sizeof(vector*)*vertexCapacity);
+    int listCount = 0, vertexCount = 0;
+    int failed = 0;
+    list[0] = NULL;
+
+    for(;;){
+        int c = skipSpaces(r);
+        if(c == EOF){
+            break;
+        }
+        if(c == '\n'){
+            //a blank line
+            nextCharacter(r);
+            continue;
+        }
+
+        //read the vertices of one polygon, up to the end of the line
+        int line = r->line;
+        vertexCount = 0;
+        while(failed == 0){
+            double x, y, z;
+            if(readCoordinate(r, &x, error) != 0){
+                failed = 1;
+                break;
+            }
+            if(skipSpaces(r) != ','){
+                failed = setError(error, r->line, r->column,
+                        "expected ',' between co-ordinates");
+                break;
+            }
+            nextCharacter(r);
+            if(readCoordinate(r, &y, error) != 0){
+                failed = 1;
+                break;
+            }
+            if(skipSpaces(r) != ','){
+                failed = setError(error, r->line, r->column,
+                        "expected ',' between co-ordinates");
+                break;
+            }
+            nextCharacter(r);
+            if(readCoordinate(r, &z, error) != 0){
+                failed = 1;
+                break;
+            }
+
+            if(vertexCount+1 >= vertexCapacity){
+                vertexCapacity = vertexCapacity*2;
+                vertices = realloc(vertices, sizeof(vector*)*vertexCapacity);
+            }
+            vertices[vertexCount++] = createVector(x, y, z);
+
+            //after a vertex comes a semicolon, the end of the line, or both
+            c = skipSpaces(r);
+            if(c == ';'){
+                nextCharacter(r);
+                c = skipSpaces(r);
+            }
+            else if(c != '\n' && c != EOF){
+                failed = setError(error, r->line, r->column,
+                        "expected ';' between vertices");
+                break;
+            }
+            if(c == '\n' || c == EOF){
+                break;
+            }
+        }
+        if(failed == 0 && vertexCount < 3){
+            failed = setError(error, line, 1,
+                    "a polygon needs at least three vertices");
+        }
+        if(failed != 0){
+            int i;
+            for(i = 0; i < vertexCount; i++){
+                free(vertices[i]);
+            }
+            break;
+        }
+
+        vertices[vertexCount] = NULL;
+        if(listCount+1 >= polygonCapacity){
+            polygonCapacity = polygonCapacity*2;
+            list = realloc(list, sizeof(polygon*)*polygonCapacity);
+        }
+        list[listCount++] = buildPolygon(vertices);
+        list[listCount] = NULL;
+    }
+
+    free(vertices);
+    free(r->token);
+    if(failed != 0){
+        freePolygonList(list);
+        *count = 0;
+        return NULL;
+    }
+    *count = listCount;
+    return list;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ POLYGONS //////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads every polygon in an object file, a block at a time, and
+ * returns them as a NULL-terminated list, with the number read stored in count.
+ *
+ * If the file isn't in the right form, nothing is kept, the problem is stored
+ * in error, and NULL is returned.
+ */
+polygon** readPolygons(FILE* file, int* count, parseError* error){
+    reader r;
+    r.file = file;
+    r.buffer = malloc(READ_BLOCK_SIZE);
+    r.length = 0;
+    r.position = 0;
+    r.line = 1;
+    r.column = 1;
+    r.tokenCapacity = 64;
+    r.token = malloc(r.tokenCapacity);
+
+    polygon** list = parsePolygons(&r, count, error);
+    free(r.buffer);
+    return list;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ POLYGONS FROM TEXT ////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads every polygon from the whole of an object file already
+ * in memory, such as one mapped by loadPolygons, straight from where it is.
+ * The text doesn't need to end with a '\0'.
+ *
+ * The result is the same as readPolygons.
+ */
+polygon** readPolygonsFromText(const char* text, size_t length, int* count,
+        parseError* error){
+    reader r;
+    r.file = NULL;
+    r.buffer = (char*)text;
+    r.length = length;
+    r.position = 0;
+    r.line = 1;
+    r.column = 1;
+    r.tokenCapacity = 64;
+    r.token = malloc(r.tokenCapacity);
+
+    return parsePolygons(&r, count, error);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ CHUNK /////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function is the job run by readPolygonsInChunks for each chunk: it
+ * reads the polygons of one chunk into that chunk's own list.
+ */
+static int readChunk(int index, int thread, void* data){
+    textChunk* chunk = &((textChunk*)data)[index];
+    chunk->polygons = readPolygonsFromText(chunk->text + chunk->start,
+            chunk->end - chunk->start, &chunk->count, &chunk->error);
+    if(chunk->polygons == NULL){
+        return(EXIT_FAILURE);
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ POLYGONS IN CHUNKS ////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads every polygon from the whole of an object file already
+ * in memory, as readPolygonsFromText does, but spread across the given number
+ * of threads.
+ *
+ * As each line is one polygon, the text is split into chunks which start and
+ * end at the start of a line, and each chunk is read on its own. The lists
+ * read from the chunks are then joined in order, so the polygons are numbered
+ * just as if the file were read from start to end.
+ *
+ * If any chunk can't be read, the problem found first in the file is given,
+ * with its line counted from the start of the file.
+ */
+polygon** readPolygonsInChunks(const char* text, size_t length, int threads,
+        int* count, parseError* error){
+    if(threads <= 1 || length < CHUNK_MIN_SIZE){
+        return readPolygonsFromText(text, length, count, error);
+    }
+
+    //split the text evenly, then move each split on to the next line
+    int chunkCount = threads*CHUNKS_PER_THREAD;
+    textChunk* chunks = malloc(sizeof(textChunk)*chunkCount);
+    size_t start = 0;
+    int used = 0;
+    int i;
+    for(i = 0; i < chunkCount && start < length; i++){
+        size_t end = length/chunkCount*(i+1);
+        if(end < start){
+            end = start;
+        }
+        if(i == chunkCount-1){
+            end = length;
+        }
+        else{
+            const char* newLine = memchr(text + end, '\n', length - end);
+            end = (newLine == NULL) ? length : (size_t)(newLine - text) + 1;
+        }
+        chunks[used].text = text;
+        chunks[used].start = start;
+        chunks[used].end = end;
+        chunks[used].polygons = NULL;
+        chunks[used].count = 0;
+        used++;
+        start = end;
+    }
+
+    int failed = parallelFor(used, threads, readChunk, chunks);
+
+    //chunks are handed out in order, so every chunk before the first to fail
+    //has been read
+    if(failed != EXIT_SUCCESS){
+        i = 0;
+        while(chunks[i].polygons != NULL){
+            i++;
+        }
+        *error = chunks[i].error;
+        const char* c;
+        for(c = text; c < text + chunks[i].start; c++){
+            error->line += (*c == '\n');
+        }
+        for(i = 0; i < used; i++){
+            if(chunks[i].polygons != NULL){
+                freePolygonList(chunks[i].polygons);
+            }
+        }
+        free(chunks);
+        *count = 0;
+        return NULL;
+    }
+
+    //join the lists in order
+    int total = 0;
+    for(i = 0; i < used; i++){
+        total += chunks[i].count;
+    }
+    polygon** list = malloc(sizeof(polygon*)*(total+1));
+    total = 0;
+    for(i = 0; i < used; i++){
+        memcpy(list + total, chunks[i].polygons,
+                sizeof(polygon*)*chunks[i].count);
+        total += chunks[i].count;
+        free(chunks[i].polygons);
+    }
+    list[total] = NULL;
+    free(chunks);
+
+    *count = total;
+    return list;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// WRITE POLYGONS /////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function writes a NULL-terminated list of polygons to a file in the
+ * text form read by readPolygons, one polygon per line. Each number is written
+ * with as many digits as it needs to be read back exactly.
+ */
+int writePolygons(FILE* file, polygon** list){
+    int i, j;
+    for(i = 0; list[i] != NULL; i++){
+        vector** v = list[i]->vertices;
+        for(j = 0; v[j] != NULL; j++){
+            fprintf(file, "%.17g,%.17g,%.17g;%s", v[j]->x, v[j]->y, v[j]->z,
+                    (v[j+1] != NULL) ? " " : "\n");
+        }
+    }
+    return(EXIT_SUCCESS);
+}
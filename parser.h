@@ -0,0 +1,37 @@
+/*
+ * File:   parser.h
+ *
+ * This header file externalises the functions in the parser.c file, which
+ * reads polygons from an object file.
+ *
+ * For further details on any function, check there.
+ */
+
+#ifndef PARSER_H
+#define PARSER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct parseError{
+    int line;
+    int column;
+    char message[100];
+}parseError;
+
+polygon** readPolygons(FILE* file, int* count, parseError* error);
+polygon** readPolygonsFromText(const char* text, size_t length, int* count,
+        parseError* error);
+polygon** readPolygonsInChunks(const char* text, size_t length, int threads,
+        int* count, parseError* error);
+int writePolygons(FILE* file, polygon** list);
+int parseNumber(const char* text, int length, double* value);
+int freePolygonList(polygon** list);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PARSER_H */
+
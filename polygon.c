@@ -39,20 +39,76 @@ transformation* buildTransformation(double newScale, double rotateZ, vector* v){
     return newTransform;
 }
 
+/////////////////////////////////////////////////////////////////
+////////////////////BOUNDS TYPE DEFINITION //////////////////////
+/////////////////////////////////////////////////////////////////
+/* This defines a struct for an axis-aligned bounding box: the smallest
+ * rectangle, lined up with the X and Y axes, that a polygon fits in. Two
+ * polygons whose boxes don't overlap can't collide, so boxes are a quick
+ * first check before the full collision check.
+ */
+typedef struct bounds{
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+}bounds;
+
 /////////////////////////////////////////////////////////////////
 ////////////////////POLYGON TYPE DEFINITION /////////////////////
 /////////////////////////////////////////////////////////////////
 /* This defines a struct for the polygon object. A polygon is defined by
- * a list of up to twenty vertices - sets of cartesian co-ordinates - and the
+ * a NULL-terminated list of vertices - sets of cartesian co-ordinates - and the
  * centre, which does not define any aspect of the polygon but is stored so as
  * to simplify the multiple calls for the centre.
+ * 
+ * The id is unique to each polygon built, and is shared by its copies. Once
+ * built a polygon's shape never changes, only where it is, how it is turned
+ * and its scale, which are kept in the transform: a new shape is a new
+ * polygon. So the id, with the transform, lets cached results about a polygon
+ * be recognised.
+ * 
+ * A polygon can stand in as a simpler "proxy" for another, such as its convex
+ * hull, which is then kept as the original. Collisions use the proxy's 
+ * vertices, but moving, rotating or scaling the proxy does the same to the
+ * original (about the proxy's centre), so the original can still be exported.
+ * Original is NULL for any other polygon, and isn't kept by copies.
+ * 
+ * A concave polygon can also be split into convex pieces (see decompose.c),
+ * which share its vertices and are used for its collision checks. Pieces is
+ * NULL for a polygon that hasn't been split.
+ * 
+ * A polygon with many vertices can also keep simplified versions of itself
+ * (see lod.c) which answer most checks more quickly. Detail is NULL for a 
+ * polygon without them.
+ * 
+ * A large polygon also keeps a table of its edge angles (see extreme.c), which
+ * is made the first time it is projected onto an axis. Normals is NULL until
+ * then, and for small polygons.
  */
 typedef struct polygon{
-    vector* vertices[20];
+    vector** vertices;
     vector* centre;
     transformation* transform;
+    unsigned long id;
+    struct polygon* original;
+    struct convexPieces* pieces;
+    struct polygonDetail* detail;
+    struct normalTable* normals;
 }polygon;
 
+//the convex pieces are made in decompose.c, the levels of detail in lod.c and
+//the tables of edge angles in extreme.c
+struct convexPieces* copyConvexPieces(struct convexPieces* c, vector** vertices);
+int freeConvexPieces(struct convexPieces* c);
+struct polygonDetail* copyPolygonDetail(struct polygonDetail* d);
+int freePolygonDetail(struct polygonDetail* d);
+struct normalTable* copyNormalTable(struct normalTable* t);
+int freeNormalTable(struct normalTable* t);
+
+//the id given to the last polygon built
+static unsigned long lastPolygonId = 0;
+
 
 
 /////////////////////////////////////////////////////////////////
@@ -92,6 +148,75 @@ vector* getCentre(polygon* p){
     return v;
 }
 
+/////////////////////////////////////////////////////////////////
+/////////// GET THE CENTRE OF MULTIPLE POLYGONS /////////////////
+/////////////////////////////////////////////////////////////////
+/* This function takes a NULL-terminated list of polygons and finds the centre
+ * of the group, as the average of each polygon's centre.
+ */
+vector* getMultipleCentres(polygon* p[]){
+    int i = 0;
+    double x=0, y=0, z=0;
+    
+    //add up the centre of each polygon
+    for(i = 0; p[i] != NULL; i++){
+        x = x + p[i]->centre->x;
+        y = y + p[i]->centre->y;
+        z = z + p[i]->centre->z;
+    }
+    
+    //and divide by the number of polygons to get the average
+    if(i > 0){
+        x = x/i;
+        y = y/i;
+        z = z/i;
+    }
+    
+    return createVector(x, y, z);
+}
+
+/////////////////////////////////////////////////////////////////
+/////////// GET THE AREA OF A POLYGON ///////////////////////////
+/////////////////////////////////////////////////////////////////
+/* This function finds the area of a polygon in the X-Y plane, using the 
+ * shoelace formula: half the sum of the cross products of each pair of
+ * neighbouring vertices. The result is positive whichever way round the
+ * vertices are.
+ */
+double getPolygonArea(polygon* p){
+    int i;
+    double area = 0;
+    
+    for(i = 0; p->vertices[i] != NULL; i++){
+        vector* a = p->vertices[i];
+        vector* b = (p->vertices[i+1] != NULL) ? p->vertices[i+1] : p->vertices[0];
+        area = area + a->x*b->y - b->x*a->y;
+    }
+    
+    return fabs(area)/2;
+}
+
+/////////////////////////////////////////////////////////////////
+/////////// GET THE BOUNDS OF A POLYGON /////////////////////////
+/////////////////////////////////////////////////////////////////
+/* This function finds the axis-aligned bounding box of a polygon, as it is now,
+ * and stores it in b.
+ */
+int getPolygonBounds(polygon* p, bounds* b){
+    int i;
+    b->minX = b->maxX = p->vertices[0]->x;
+    b->minY = b->maxY = p->vertices[0]->y;
+    
+    for(i = 1; p->vertices[i] != NULL; i++){
+        if(p->vertices[i]->x < b->minX) b->minX = p->vertices[i]->x;
+        if(p->vertices[i]->x > b->maxX) b->maxX = p->vertices[i]->x;
+        if(p->vertices[i]->y < b->minY) b->minY = p->vertices[i]->y;
+        if(p->vertices[i]->y > b->maxY) b->maxY = p->vertices[i]->y;
+    }
+    
+    return(EXIT_SUCCESS);
+}
+
 /////////////////////////////////////////////////////////////////////////
 //////////////// BUILD POLYGON //////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////
@@ -99,11 +224,17 @@ vector* getCentre(polygon* p){
  * before taking the list and generating a centre from it. It also sets the
  * default scale and rotation.
  * 
+ * The list given must be NULL-terminated. The polygon keeps its own copy of 
+ * the list (but not of the vertices), so the list can be reused afterwards.
+ * 
  */
-polygon* buildPolygon(vector* v[20]){
+polygon* buildPolygon(vector* v[]){
     
-    //allocate space for the polygon
+    //allocate space for the polygon and its list of vertices
     polygon* newPoly = malloc(sizeof(polygon));
+    int count;
+    for(count = 0; v[count] != NULL; count++);
+    newPoly->vertices = malloc(sizeof(vector*)*(count+1));
 
     //for each vertex in the list
     int i = 0;
@@ -117,11 +248,90 @@ polygon* buildPolygon(vector* v[20]){
 
     //set the default scale and rotation of the new polygon
     newPoly->transform = buildTransformation(1.0, 0.0, createVector(0.0,0.0,0.0));
+    
+    //give it the next id. Polygons can be built on several threads at once, so
+    //the counter is increased atomically.
+    newPoly->id = __sync_add_and_fetch(&lastPolygonId, 1);
+    newPoly->original = NULL;
+    newPoly->pieces = NULL;
+    newPoly->detail = NULL;
+    newPoly->normals = NULL;
         
     //return the new polygon
     return newPoly;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//////// COPY POLYGON TO ///////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function resets an existing copy of a polygon (made by copyPolygon) back
+ * to the vertices, centre and transformation of the source, without allocating
+ * anything. It is used to reuse one workspace polygon for many trials.
+ * 
+ * Both polygons must have the same number of vertices.
+ */
+int copyPolygonTo(polygon* dest, polygon* src){
+    int i;
+    for(i = 0; src->vertices[i] != NULL; i++){
+        dest->vertices[i]->x = src->vertices[i]->x;
+        dest->vertices[i]->y = src->vertices[i]->y;
+        dest->vertices[i]->z = src->vertices[i]->z;
+    }
+    
+    dest->centre->x = src->centre->x;
+    dest->centre->y = src->centre->y;
+    dest->centre->z = src->centre->z;
+    
+    dest->transform->scale = src->transform->scale;
+    dest->transform->rotationZ = src->transform->rotationZ;
+    dest->transform->translation->x = src->transform->translation->x;
+    dest->transform->translation->y = src->transform->translation->y;
+    dest->transform->translation->z = src->transform->translation->z;
+    
+    dest->id = src->id;
+    
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//////// COPY POLYGON //////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function creates a new polygon which is an exact copy of the given one,
+ * with its own vertices, centre and transformation, so that the copy can be
+ * moved, scaled and rotated without affecting the original.
+ */
+polygon* copyPolygon(polygon* p){
+    int count;
+    for(count = 0; p->vertices[count] != NULL; count++);
+    vector** newVertices = malloc(sizeof(vector*)*(count+1));
+    
+    //copy each vertex
+    int i;
+    for(i = 0; p->vertices[i] != NULL; i++){
+        newVertices[i] = createVector(p->vertices[i]->x, p->vertices[i]->y,
+                                        p->vertices[i]->z);
+    }
+    newVertices[count] = NULL;
+    
+    //build the polygon, then copy the centre and transform over the defaults
+    polygon* newPoly = buildPolygon(newVertices);
+    free(newVertices);
+    copyPolygonTo(newPoly, p);
+    
+    //give the copy the same convex pieces, made from its own vertices
+    if(p->pieces != NULL){
+        newPoly->pieces = copyConvexPieces(p->pieces, newPoly->vertices);
+    }
+    if(p->detail != NULL){
+        newPoly->detail = copyPolygonDetail(p->detail);
+    }
+    if(p->normals != NULL){
+        newPoly->normals = copyNormalTable(p->normals);
+    }
+    
+    return newPoly;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //////// FREE POLYGON //////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
@@ -134,6 +344,19 @@ int freePolygon(polygon* p){
     for(i = 0; p->vertices[i] != NULL; i++){
         free(p->vertices[i]);
     }
+    if(p->original != NULL){
+        freePolygon(p->original);
+    }
+    if(p->pieces != NULL){
+        freeConvexPieces(p->pieces);
+    }
+    if(p->detail != NULL){
+        freePolygonDetail(p->detail);
+    }
+    if(p->normals != NULL){
+        freeNormalTable(p->normals);
+    }
+    free(p->vertices);
     free(p->transform->translation);
     free(p->centre);
     free(p);
@@ -204,6 +427,47 @@ int checkIfConvex(polygon* p){
     return 1;   
 }
 
+/////////////////////////////////////////////////////////////////////////
+//////////////// MOVE ORIGINAL //////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////
+/* This function does the same transformation to a proxy's original polygon as
+ * to the proxy: it scales and rotates the original about the proxy's centre
+ * (as it was before the change), then moves it by the given offset. Polygons 
+ * without an original are left alone.
+ */
+static int moveOriginalPoint(polygon* p, vector* v, double scale, double cosA,
+        double sinA, double dx, double dy, double dz){
+    double x = (v->x - p->centre->x)*scale;
+    double y = (v->y - p->centre->y)*scale;
+    double z = (v->z - p->centre->z)*scale;
+    v->x = p->centre->x + x*cosA - y*sinA + dx;
+    v->y = p->centre->y + x*sinA + y*cosA + dy;
+    v->z = p->centre->z + z + dz;
+    return(EXIT_SUCCESS);
+}
+
+static int moveOriginal(polygon* p, double scale, double angle, double dx, 
+        double dy, double dz){
+    polygon* o = p->original;
+    if(o == NULL){
+        return(EXIT_SUCCESS);
+    }
+    
+    double angleRad = angle*M_PI/180;
+    double cosA = cos(angleRad), sinA = sin(angleRad);
+    int i;
+    
+    //move each vertex, then the original's centre, the same way
+    for(i = 0; o->vertices[i] != NULL; i++){
+        moveOriginalPoint(p, o->vertices[i], scale, cosA, sinA, dx, dy, dz);
+    }
+    moveOriginalPoint(p, o->centre, scale, cosA, sinA, dx, dy, dz);
+    
+    o->transform->scale = o->transform->scale*scale;
+    o->transform->rotationZ = o->transform->rotationZ+angle;
+    return(EXIT_SUCCESS);
+}
+
 /////////////////////////////////////////////////////////////////////////
 //////////////// SCALE POLYGON ////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////
@@ -214,6 +478,7 @@ int checkIfConvex(polygon* p){
  */
 int scalePolygon(polygon* p, double scale){
     int i;
+    moveOriginal(p, scale, 0, 0, 0, 0);
     
     //for each vertex in the polygon
     for(i=0;p->vertices[i]!=NULL;i++){
@@ -259,6 +524,7 @@ int scalePolygonTo(polygon* p, double scale){
  */
 int translatePolygon(polygon* p, vector*v){
     int i;
+    moveOriginal(p, 1, 0, v->x, v->y, v->z);
     
     //for each vertex in the polygon
     for(i=0;p->vertices[i]!=NULL;i++){
@@ -285,6 +551,7 @@ int translatePolygonTo(polygon* p, vector* v){
     double dx = v->x - p->centre->x;
     double dy = v->y - p->centre->y;
     double dz = v->z - p->centre->z;
+    moveOriginal(p, 1, 0, dx, dy, dz);
     
     //translate the centre
     p->centre->x = v->x;
@@ -318,6 +585,7 @@ int translatePolygonTo(polygon* p, vector* v){
 int rotatePolygonZ(polygon* p, double angle){
     int i;
     double angleRad = angle*M_PI/180;
+    moveOriginal(p, 1, angle, 0, 0, 0);
     
     //for each vertex in the polygon
     for(i=0;p->vertices[i]!=NULL;i++){
@@ -23,18 +23,34 @@ typedef struct transformation{
     vector* translation;
 }transformation;
     
+typedef struct bounds{
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+}bounds;
+    
 typedef struct polygon{
-    vector* vertices[20];
+    vector** vertices;
     vector* centre;
     transformation* transform;
+    unsigned long id;
+    struct polygon* original;
+    struct convexPieces* pieces;
+    struct polygonDetail* detail;
+    struct normalTable* normals;
 }polygon;
 
-polygon* buildPolygon(vector* v[20]);
+polygon* buildPolygon(vector* v[]);
+polygon* copyPolygon(polygon* p);
+int copyPolygonTo(polygon* dest, polygon* src);
 int freePolygon(polygon* p);
 transformation* buildTransformation(double scale, double rotationZ, vector* v);
 
 vector* getCentre(polygon* p);
 vector* getMultipleCentres(polygon* p[]);
+double getPolygonArea(polygon* p);
+int getPolygonBounds(polygon* p, bounds* b);
 int checkIfConvex(polygon* p);
 int scalePolygon(polygon* p, double scale);
 int scalePolygonTo(polygon* p, double scale);
@@ -0,0 +1,328 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          RESULTS
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to write the results of checks and fits to
+ * a file as records, one per line, for other programs to read, as they are
+ * found.
+ *
+ * Files ending .jsonl, .ndjson or .json are written as JSON Lines, with only
+ * the fields that apply to each record:
+ *
+ *      {"kind":"collide","first":1,"second":2,"result":"clear",
+ *       "distance":3.5,"seconds":1.2e-05}
+ *
+ * and anything else as CSV, with a header line and every field in every
+ * record, left empty where it doesn't apply:
+ *
+ *      kind,first,second,result,distance,mtv_x,mtv_y,scale,angle,x,y,
+ *      evaluations,seconds
+ *
+ * The kinds and their results are:
+ *
+ *      collide     clear (with distance) or collide (with mtv_x and mtv_y,
+ *                  the smallest move of the second polygon which separates
+ *                  them)
+ *      contain     inside or outside (the first polygon in the second)
+ *      fit         fitted or stopped (with scale, angle and x and y, the
+ *                  centre, of the fit, and the positions tried)
+ *
+ * Polygons are numbered from 1, as in the menu, and seconds is the time taken
+ * to find the result.
+ *
+ * Records are gathered in a buffer and written out when it is full or flushed,
+ * so writing them costs little next to finding them. Any number of threads can
+ * write to the same file at once: each record is written out in full before
+ * the next.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "vector.h"
+#include "polygon.h"
+#include "collision.h"
+#include "distance.h"
+#include "parallel.h"
+#include "sampler.h"
+#include "scalecache.h"
+#include "applications.h"
+#include "results.h"
+
+//the size of the buffer records are gathered in
+#define RESULT_BUFFER_SIZE (1 << 16)
+
+//the longest a single record can be
+#define RESULT_RECORD_SIZE 512
+
+typedef struct resultSink{
+    FILE* file;
+    int format;
+    char* text;
+    size_t length;
+    long records;
+    int failed;
+    pthread_mutex_t lock;
+}resultSink;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RESULT NAMES ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* The names written for each result code, and for the kind of check it is a
+ * result of, in the order of the codes in results.h.
+ */
+static const char* resultNames[] = {"clear", "collide", "inside", "outside",
+        "fitted", "stopped"};
+static const char* kindNames[] = {"collide", "collide", "contain", "contain",
+        "fit", "fit"};
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// OPEN RESULT SINK ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function opens the named file to write records to, replacing anything
+ * in it, in the form its name asks for (see above). Returns NULL if it can't
+ * be opened.
+ */
+resultSink* openResultSink(const char* filename){
+    FILE* file = fopen(filename, "w");
+    if(file == NULL){
+        return NULL;
+    }
+    resultSink* sink = malloc(sizeof(resultSink));
+    sink->file = file;
+    sink->format = RESULTS_CSV;
+    const char* extension = strrchr(filename, '.');
+    if(extension != NULL && (strcmp(extension, ".jsonl") == 0 ||
+            strcmp(extension, ".ndjson") == 0 ||
+            strcmp(extension, ".json") == 0)){
+        sink->format = RESULTS_JSON;
+    }
+    sink->text = malloc(RESULT_BUFFER_SIZE);
+    sink->length = 0;
+    sink->records = 0;
+    sink->failed = 0;
+    pthread_mutex_init(&sink->lock, NULL);
+
+    if(sink->format == RESULTS_CSV){
+        const char* header = "kind,first,second,result,distance,mtv_x,mtv_y,"
+                "scale,angle,x,y,evaluations,seconds\n";
+        sink->length = strlen(header);
+        memcpy(sink->text, header, sink->length);
+    }
+    return sink;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// WRITE OUT //////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function writes out everything in a sink's buffer. The sink must be
+ * locked.
+ */
+static int writeOut(resultSink* sink){
+    if(sink->length > 0 &&
+            fwrite(sink->text, 1, sink->length, sink->file) != sink->length){
+        sink->failed = 1;
+    }
+    sink->length = 0;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// ADD FIELD //////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function adds a number to a record being written: in CSV, as a field
+ * (empty if it doesn't apply), and in JSON, as a named field, left out if it
+ * doesn't apply. Numbers which aren't finite are written as empty fields, or
+ * null in JSON.
+ */
+static int addField(char* record, int* length, int format, const char* name,
+        double value, int applies){
+    int space = RESULT_RECORD_SIZE - *length;
+    int written = 0;
+    //adding zero turns -0 into 0
+    value += 0.0;
+    if(format == RESULTS_CSV){
+        if(applies && isfinite(value)){
+            written = snprintf(record + *length, space, ",%.10g", value);
+        }
+        else{
+            written = snprintf(record + *length, space, ",");
+        }
+    }
+    else if(applies){
+        if(isfinite(value)){
+            written = snprintf(record + *length, space, ",\"%s\":%.10g", name,
+                    value);
+        }
+        else{
+            written = snprintf(record + *length, space, ",\"%s\":null", name);
+        }
+    }
+    if(written > 0 && written < space){
+        *length += written;
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// WRITE RESULT ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function adds one record to a sink. It can be called from several
+ * threads at once: the record is written out on its own first, so the sink is
+ * only locked to copy it in.
+ */
+int writeResult(resultSink* sink, resultRecord* r){
+    char record[RESULT_RECORD_SIZE];
+    int length;
+    int format = sink->format;
+    int code = (r->code >= 0 && r->code <= RESULT_STOPPED) ? r->code : 0;
+    int fit = (code == RESULT_FITTED || code == RESULT_STOPPED);
+
+    if(format == RESULTS_CSV){
+        length = snprintf(record, sizeof(record), "%s,%d,%d,%s",
+                kindNames[code], r->first, r->second, resultNames[code]);
+    }
+    else{
+        length = snprintf(record, sizeof(record), "{\"kind\":\"%s\","
+                "\"first\":%d,\"second\":%d,\"result\":\"%s\"",
+                kindNames[code], r->first, r->second, resultNames[code]);
+    }
+    addField(record, &length, format, "distance", r->distance,
+            code == RESULT_CLEAR);
+    addField(record, &length, format, "mtv_x", r->mtvX,
+            code == RESULT_COLLIDE);
+    addField(record, &length, format, "mtv_y", r->mtvY,
+            code == RESULT_COLLIDE);
+    addField(record, &length, format, "scale", r->scale, fit);
+    addField(record, &length, format, "angle", r->angle, fit);
+    addField(record, &length, format, "x", r->x, fit);
+    addField(record, &length, format, "y", r->y, fit);
+    addField(record, &length, format, "evaluations", (double)r->evaluations,
+            fit);
+    addField(record, &length, format, "seconds", r->seconds, 1);
+    length += snprintf(record + length, sizeof(record) - length, "%s\n",
+            (format == RESULTS_CSV) ? "" : "}");
+
+    pthread_mutex_lock(&sink->lock);
+    if(sink->length + length > RESULT_BUFFER_SIZE){
+        writeOut(sink);
+    }
+    memcpy(sink->text + sink->length, record, length);
+    sink->length += length;
+    sink->records++;
+    pthread_mutex_unlock(&sink->lock);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FLUSH RESULT SINK //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function writes every record added so far to the file, so it can be
+ * read while more are found. Returns EXIT_FAILURE if any record couldn't be
+ * written.
+ */
+int flushResultSink(resultSink* sink){
+    pthread_mutex_lock(&sink->lock);
+    writeOut(sink);
+    if(fflush(sink->file) != 0){
+        sink->failed = 1;
+    }
+    int failed = sink->failed;
+    pthread_mutex_unlock(&sink->lock);
+    return (failed == 1) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CLOSE RESULT SINK //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function writes out any records left, closes the file and frees the
+ * sink. Returns EXIT_FAILURE if any record couldn't be written.
+ */
+int closeResultSink(resultSink* sink){
+    int result = flushResultSink(sink);
+    if(fclose(sink->file) != 0){
+        result = EXIT_FAILURE;
+    }
+    pthread_mutex_destroy(&sink->lock);
+    free(sink->text);
+    free(sink);
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// MEASURE COLLISION //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function checks whether two polygons collide, and fills in a record of
+ * the result: the distance between them if they don't, or the move which
+ * would separate them if they do, and the time taken. For polygons split into
+ * pieces, the move separates the pair of pieces which overlap most. Returns
+ * the result of checkCollisions.
+ */
+int measureCollision(polygon* a, polygon* b, int first, int second,
+        resultRecord* r){
+    memset(r, 0, sizeof(resultRecord));
+    r->first = first;
+    r->second = second;
+    double start = getTimeSeconds();
+    int result = checkCollisions(a, b);
+    if(result == 1){
+        r->code = RESULT_CLEAR;
+        clearance* gap = findClearance(a, b, NULL);
+        r->distance = gap->distance;
+        freeClearance(gap);
+    }
+    else{
+        //the separation is the overlap along the axis from a towards b, as a
+        //negative number
+        r->code = RESULT_COLLIDE;
+        vector axis;
+        double separation = getSeparation(a, b, &axis);
+        r->mtvX = -separation*axis.x;
+        r->mtvY = -separation*axis.y;
+    }
+    r->seconds = getTimeSeconds() - start;
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// MEASURE CONTAINMENT ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function checks whether one polygon is inside another, and fills in a
+ * record of the result and the time taken. Returns the result of
+ * checkInsideBoundingBox.
+ */
+int measureContainment(polygon* inside, polygon* bound, int first, int second,
+        resultRecord* r){
+    memset(r, 0, sizeof(resultRecord));
+    r->first = first;
+    r->second = second;
+    double start = getTimeSeconds();
+    int result = checkInsideBoundingBox(inside, bound);
+    r->seconds = getTimeSeconds() - start;
+    r->code = (result == 1) ? RESULT_INSIDE : RESULT_OUTSIDE;
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FILL FIT RECORD ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function fills in a record of a fit which has been run: the
+ * transformation it found, whether it was stopped early and how many
+ * positions it tried (from its options), and the time it took.
+ */
+int fillFitRecord(transformation* t, fitOptions* options, int first,
+        int second, double seconds, resultRecord* r){
+    memset(r, 0, sizeof(resultRecord));
+    r->code = (options->stopped == 1) ? RESULT_STOPPED : RESULT_FITTED;
+    r->first = first;
+    r->second = second;
+    r->scale = t->scale;
+    r->angle = t->rotationZ;
+    r->x = t->translation->x;
+    r->y = t->translation->y;
+    r->evaluations = options->evaluations;
+    r->seconds = seconds;
+    return(EXIT_SUCCESS);
+}
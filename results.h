@@ -0,0 +1,62 @@
+/*
+ * File:   results.h
+ *
+ * This header file externalises the functions in the results.c file, which
+ * write the results of checks and fits to a file as CSV or JSON Lines records.
+ *
+ * For further details on any function, check there.
+ */
+
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//the forms records can be written in
+#define RESULTS_CSV 0
+#define RESULTS_JSON 1
+
+//the results a record can give
+#define RESULT_CLEAR 0
+#define RESULT_COLLIDE 1
+#define RESULT_INSIDE 2
+#define RESULT_OUTSIDE 3
+#define RESULT_FITTED 4
+#define RESULT_STOPPED 5
+
+struct resultSink;
+struct fitOptions;
+
+typedef struct resultRecord{
+    int code;
+    int first;
+    int second;
+    double distance;
+    double mtvX;
+    double mtvY;
+    double scale;
+    double angle;
+    double x;
+    double y;
+    long evaluations;
+    double seconds;
+}resultRecord;
+
+struct resultSink* openResultSink(const char* filename);
+int writeResult(struct resultSink* sink, resultRecord* r);
+int flushResultSink(struct resultSink* sink);
+int closeResultSink(struct resultSink* sink);
+int measureCollision(polygon* a, polygon* b, int first, int second,
+        resultRecord* r);
+int measureContainment(polygon* inside, polygon* bound, int first, int second,
+        resultRecord* r);
+int fillFitRecord(transformation* t, struct fitOptions* options, int first,
+        int second, double seconds, resultRecord* r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RESULTS_H */
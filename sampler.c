@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          SAMPLER
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the samplers used to pick candidate positions for the
+ * fitting functions. A sampler turns an index (such as the trial number) into a
+ * point, so the same sampler and index always give the same point whatever
+ * thread asks for it.
+ * 
+ * Three types are available:
+ *  SAMPLER_RANDOM - independent random points from a seeded PCG stream
+ *  SAMPLER_HALTON - the Halton sequence in bases 2 and 3
+ *  SAMPLER_SOBOL  - the first two dimensions of the Sobol sequence
+ * 
+ * Halton and Sobol are "low-discrepancy" sequences: each new point falls in the
+ * largest gap left by the previous ones, so they cover an area evenly in far
+ * fewer points than random sampling, which clumps. The seed shifts the whole
+ * sequence so different seeds still give different points.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vector.h"
+#include "polygon.h"
+#include "sampler.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD SAMPLER //////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function creates a sampler of the given type. The seed is used to pick
+ * the random shift applied to the Halton and Sobol sequences, and as the seed
+ * of the random sampler.
+ */
+sampler* buildSampler(samplerType type, unsigned long long seed){
+    sampler* newSampler = malloc(sizeof(sampler));
+    newSampler->type = type;
+    newSampler->seed = seed;
+    
+    //pick the shifts from a stream no trial will use
+    randomState r;
+    seedRandom(&r, seed, 0xFFFFFFFFULL);
+    newSampler->shiftX = randomDouble(&r);
+    newSampler->shiftY = randomDouble(&r);
+    newSampler->scrambleX = (unsigned int)(randomDouble(&r)*4294967296.0);
+    newSampler->scrambleY = (unsigned int)(randomDouble(&r)*4294967296.0);
+    
+    return newSampler;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RADICAL INVERSE ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function mirrors the digits of n in the given base around the decimal
+ * point: in base 10, 123 becomes 0.321. This is one dimension of the Halton 
+ * sequence.
+ */
+static double radicalInverse(unsigned int n, unsigned int base){
+    double result = 0.0;
+    double fraction = 1.0/base;
+    
+    while(n > 0){
+        result = result + (n % base)*fraction;
+        n = n/base;
+        fraction = fraction/base;
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SOBOL //////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function gives the first two dimensions of the Sobol sequence for n, as
+ * 32-bit fractions. The first dimension has direction numbers 2^-k (the bits of
+ * n reversed) and the second uses the polynomial x+1, where each direction
+ * number is the previous one XORed with itself shifted right by one.
+ */
+static int sobol2D(unsigned int n, unsigned int* x, unsigned int* y){
+    unsigned int directionX = 0x80000000u;
+    unsigned int directionY = 0x80000000u;
+    *x = 0;
+    *y = 0;
+    
+    //for each set bit of n, XOR in that bit's direction numbers
+    while(n > 0){
+        if(n & 1u){
+            *x = *x ^ directionX;
+            *y = *y ^ directionY;
+        }
+        n = n >> 1;
+        directionX = directionX >> 1;
+        directionY = directionY ^ (directionY >> 1);
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SAMPLE POINT ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function gives point number "index" of the sampler, as u and v between 
+ * 0 and 1.
+ */
+int samplePoint(sampler* s, int index, double* u, double* v){
+    if(s->type == SAMPLER_HALTON){
+        //skip the point at 0, then shift each dimension, wrapping back past 1
+        *u = radicalInverse((unsigned int)index + 1, 2) + s->shiftX;
+        *v = radicalInverse((unsigned int)index + 1, 3) + s->shiftY;
+        *u = *u - floor(*u);
+        *v = *v - floor(*v);
+    }
+    else if(s->type == SAMPLER_SOBOL){
+        //XORing every point with the same bits keeps the even spread
+        unsigned int x, y;
+        sobol2D((unsigned int)index, &x, &y);
+        *u = (double)(x ^ s->scrambleX) / 4294967296.0;
+        *v = (double)(y ^ s->scrambleY) / 4294967296.0;
+    }
+    else{
+        randomState r;
+        seedRandom(&r, s->seed, (unsigned long long)index);
+        *u = randomDouble(&r);
+        *v = randomDouble(&r);
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SAMPLE POINT IN POLYGON ////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function maps point number "index" of the sampler to a point inside a 
+ * convex polygon, spread evenly over its area.
+ * 
+ * The polygon is split into triangles from its centre to each edge. u picks a
+ * triangle in proportion to its area, and what is left of u is used with v to
+ * pick a point in that triangle: the square root of u gives the distance from
+ * the centre, so each band of the triangle gets its fair share of points.
+ */
+vector* samplePointInPolygon(sampler* s, int index, polygon* p){
+    double u, v;
+    samplePoint(s, index, &u, &v);
+    
+    //find the total area of the triangles from the centre to each edge
+    double total = 0;
+    int i, next;
+    for(i = 0; p->vertices[i] != NULL; i++){
+        next = (p->vertices[i+1] != NULL) ? i+1 : 0;
+        total = total + fabs((p->vertices[i]->x - p->centre->x) *
+                             (p->vertices[next]->y - p->centre->y) -
+                             (p->vertices[next]->x - p->centre->x) *
+                             (p->vertices[i]->y - p->centre->y)) / 2;
+    }
+    
+    //if the polygon has no area, the centre is the only point in it
+    if(total <= 0){
+        return createVector(p->centre->x, p->centre->y, p->centre->z);
+    }
+    
+    //walk through the triangles until the one u falls in is reached
+    double target = u*total;
+    double area = 0;
+    for(i = 0; p->vertices[i] != NULL; i++){
+        next = (p->vertices[i+1] != NULL) ? i+1 : 0;
+        area = fabs((p->vertices[i]->x - p->centre->x) *
+                    (p->vertices[next]->y - p->centre->y) -
+                    (p->vertices[next]->x - p->centre->x) *
+                    (p->vertices[i]->y - p->centre->y)) / 2;
+        if(target <= area || p->vertices[next] == p->vertices[0]){
+            break;
+        }
+        target = target - area;
+    }
+    
+    //the rest of u is how far through this triangle's area the point is
+    double along = (area > 0) ? target/area : 0;
+    if(along > 1){
+        along = 1;
+    }
+    double distance = sqrt(along);
+    
+    double x = p->centre->x + distance *
+                ((1-v)*(p->vertices[i]->x - p->centre->x) +
+                    v*(p->vertices[next]->x - p->centre->x));
+    double y = p->centre->y + distance *
+                ((1-v)*(p->vertices[i]->y - p->centre->y) +
+                    v*(p->vertices[next]->y - p->centre->y));
+    
+    return createVector(x, y, p->centre->z);
+}
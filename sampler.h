@@ -0,0 +1,41 @@
+/* 
+ * File:   sampler.h
+ *
+ * This header file externalises the functions in the sampler.c file, which
+ * generate the candidate positions tried by the fitting functions.
+ * 
+ * For further details on any function, check there.
+ */
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum samplerType{
+    SAMPLER_RANDOM,
+    SAMPLER_HALTON,
+    SAMPLER_SOBOL
+}samplerType;
+
+typedef struct sampler{
+    samplerType type;
+    unsigned long long seed;
+    double shiftX;
+    double shiftY;
+    unsigned int scrambleX;
+    unsigned int scrambleY;
+}sampler;
+
+sampler* buildSampler(samplerType type, unsigned long long seed);
+int samplePoint(sampler* s, int index, double* u, double* v);
+vector* samplePointInPolygon(sampler* s, int index, polygon* p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLER_H */
+
@@ -0,0 +1,277 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          SCALE CACHE
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains a cache for the results of findMinScale. The fitting
+ * functions call findMinScale for the same pair of polygons in the same place
+ * many times: the edges of the angle bands overlap, 0 and 360 degrees are the 
+ * same angle, and separate trials often end up at the same centre.
+ * 
+ * Each result is stored against the ids of the two polygons, and their
+ * positions, rotations and scales rounded to a millionth. A polygon's shape
+ * never changes (see polygon.c), so the ids stand for the shapes.
+ * 
+ * The cache holds a fixed number of results. When it is full the one that was
+ * used least recently is replaced. It can be shared between threads.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "vector.h"
+#include "polygon.h"
+#include "scalecache.h"
+
+#define SCALE_KEY_VALUES 9
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CACHE ENTRY TYPE DEFINITION ////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This struct holds one cached result and its key. Entries are kept in a fixed
+ * array and linked together by index: "chain" links entries in the same hash
+ * bucket, and "newer" and "older" link all entries from most to least recently
+ * used. -1 marks the end of a list.
+ */
+typedef struct scaleCacheEntry{
+    unsigned long insideId;
+    unsigned long outsideId;
+    long long values[SCALE_KEY_VALUES];
+    int precision;
+    unsigned long long hash;
+    double scale;
+    int chain;
+    int newer;
+    int older;
+}scaleCacheEntry;
+
+/* This function empties every bucket and list. The cache must be locked.
+ */
+static int emptyEntries(scaleCache* cache){
+    int i;
+    for(i = 0; i < cache->bucketCount; i++){
+        cache->buckets[i] = -1;
+    }
+    cache->count = 0;
+    cache->newest = -1;
+    cache->oldest = -1;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD SCALE CACHE //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function creates an empty cache that can hold up to "capacity" results.
+ */
+scaleCache* buildScaleCache(int capacity){
+    scaleCache* cache = malloc(sizeof(scaleCache));
+    
+    if(capacity < 1){
+        capacity = 1;
+    }
+    cache->capacity = capacity;
+    cache->entries = malloc(sizeof(scaleCacheEntry)*capacity);
+    
+    //use at least twice as many buckets as entries, as a power of two
+    cache->bucketCount = 1;
+    while(cache->bucketCount < capacity*2){
+        cache->bucketCount = cache->bucketCount*2;
+    }
+    cache->buckets = malloc(sizeof(int)*cache->bucketCount);
+    
+    pthread_mutex_t* lock = malloc(sizeof(pthread_mutex_t));
+    pthread_mutex_init(lock, NULL);
+    cache->lock = lock;
+    
+    cache->hits = 0;
+    cache->misses = 0;
+    emptyEntries(cache);
+    
+    return cache;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// MAKE KEY ///////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function fills the key part of an entry for the given pair of polygons
+ * as they are now, and works out its hash.
+ */
+static int makeKey(scaleCacheEntry* key, polygon* polyInside, 
+        polygon* polyOutside, int precision){
+    key->insideId = polyInside->id;
+    key->outsideId = polyOutside->id;
+    key->precision = precision;
+    
+    //rotations are kept between 0 and 360, so a full turn gives the same key
+    double insideAngle = fmod(polyInside->transform->rotationZ, 360.0);
+    double outsideAngle = fmod(polyOutside->transform->rotationZ, 360.0);
+    if(insideAngle < 0) insideAngle = insideAngle + 360.0;
+    if(outsideAngle < 0) outsideAngle = outsideAngle + 360.0;
+    
+    double values[SCALE_KEY_VALUES] = {
+        insideAngle, polyInside->transform->scale,
+        polyInside->centre->x, polyInside->centre->y,
+        outsideAngle, polyOutside->transform->scale,
+        polyOutside->centre->x, polyOutside->centre->y,
+        polyOutside->centre->z - polyInside->centre->z
+    };
+    
+    //round each value to a millionth and mix it into the hash
+    unsigned long long hash = 14695981039346656037ULL;
+    hash = (hash ^ key->insideId) * 1099511628211ULL;
+    hash = (hash ^ key->outsideId) * 1099511628211ULL;
+    hash = (hash ^ (unsigned long long)precision) * 1099511628211ULL;
+    int i;
+    for(i = 0; i < SCALE_KEY_VALUES; i++){
+        key->values[i] = llround(values[i]*1000000.0);
+        hash = (hash ^ (unsigned long long)key->values[i]) * 1099511628211ULL;
+    }
+    key->hash = hash;
+    
+    return(EXIT_SUCCESS);
+}
+
+/* This function returns 1 if two entries have the same key, otherwise 0.
+ */
+static int sameKey(scaleCacheEntry* a, scaleCacheEntry* b){
+    if(a->hash != b->hash || a->insideId != b->insideId ||
+            a->outsideId != b->outsideId || a->precision != b->precision){
+        return 0;
+    }
+    int i;
+    for(i = 0; i < SCALE_KEY_VALUES; i++){
+        if(a->values[i] != b->values[i]){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// LINKING ENTRIES ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* These functions take an entry out of, or put it into, the most-to-least 
+ * recently used list and its hash bucket. The cache must be locked.
+ */
+static int unlinkEntry(scaleCache* cache, int index){
+    scaleCacheEntry* e = &cache->entries[index];
+    
+    //take it out of the recently used list
+    if(e->newer != -1) cache->entries[e->newer].older = e->older;
+    else cache->newest = e->older;
+    if(e->older != -1) cache->entries[e->older].newer = e->newer;
+    else cache->oldest = e->newer;
+    
+    //take it out of its bucket's chain
+    int* link = &cache->buckets[e->hash & (cache->bucketCount - 1)];
+    while(*link != index){
+        link = &cache->entries[*link].chain;
+    }
+    *link = e->chain;
+    
+    return(EXIT_SUCCESS);
+}
+
+static int linkEntry(scaleCache* cache, int index){
+    scaleCacheEntry* e = &cache->entries[index];
+    
+    //make it the most recently used
+    e->newer = -1;
+    e->older = cache->newest;
+    if(cache->newest != -1) cache->entries[cache->newest].newer = index;
+    cache->newest = index;
+    if(cache->oldest == -1) cache->oldest = index;
+    
+    //and add it to the front of its bucket's chain
+    int bucket = e->hash & (cache->bucketCount - 1);
+    e->chain = cache->buckets[bucket];
+    cache->buckets[bucket] = index;
+    
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// LOOKUP SCALE ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function looks for a stored findMinScale result for the two polygons 
+ * as they are now. If there is one it is put in "scale" and 1 is returned,
+ * otherwise 0 is returned. Either way the hit or miss is counted.
+ */
+int lookupScale(scaleCache* cache, polygon* polyInside, polygon* polyOutside,
+                int precision, double* scale){
+    scaleCacheEntry key;
+    makeKey(&key, polyInside, polyOutside, precision);
+    
+    pthread_mutex_lock((pthread_mutex_t*)cache->lock);
+    int index = cache->buckets[key.hash & (cache->bucketCount - 1)];
+    while(index != -1 && sameKey(&cache->entries[index], &key) == 0){
+        index = cache->entries[index].chain;
+    }
+    
+    int found = 0;
+    if(index != -1){
+        //move it to the front, as the most recently used
+        *scale = cache->entries[index].scale;
+        unlinkEntry(cache, index);
+        linkEntry(cache, index);
+        cache->hits++;
+        found = 1;
+    }else{
+        cache->misses++;
+    }
+    pthread_mutex_unlock((pthread_mutex_t*)cache->lock);
+    
+    return found;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// STORE SCALE ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function stores a findMinScale result for the two polygons as they are
+ * now. If the cache is full, the least recently used result is replaced.
+ */
+int storeScale(scaleCache* cache, polygon* polyInside, polygon* polyOutside,
+                int precision, double scale){
+    scaleCacheEntry key;
+    makeKey(&key, polyInside, polyOutside, precision);
+    
+    pthread_mutex_lock((pthread_mutex_t*)cache->lock);
+    
+    //if another thread has already stored it, there is nothing to do
+    int index = cache->buckets[key.hash & (cache->bucketCount - 1)];
+    while(index != -1 && sameKey(&cache->entries[index], &key) == 0){
+        index = cache->entries[index].chain;
+    }
+    
+    if(index == -1){
+        //use the next empty entry, or the least recently used one
+        if(cache->count < cache->capacity){
+            index = cache->count;
+            cache->count++;
+        }else{
+            index = cache->oldest;
+            unlinkEntry(cache, index);
+        }
+        cache->entries[index] = key;
+        cache->entries[index].scale = scale;
+        linkEntry(cache, index);
+    }
+    pthread_mutex_unlock((pthread_mutex_t*)cache->lock);
+    
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FREE SCALE CACHE ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function frees a cache and everything in it.
+ */
+int freeScaleCache(scaleCache* cache){
+    pthread_mutex_destroy((pthread_mutex_t*)cache->lock);
+    free(cache->lock);
+    free(cache->entries);
+    free(cache->buckets);
+    free(cache);
+    return(EXIT_SUCCESS);
+}
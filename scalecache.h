@@ -0,0 +1,45 @@
+/* 
+ * File:   scalecache.h
+ *
+ * This header file externalises the functions in the scalecache.c file, which
+ * remembers the results of findMinScale so they don't have to be worked out
+ * again.
+ * 
+ * For further details on any function, check there.
+ */
+
+#ifndef SCALECACHE_H
+#define SCALECACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct scaleCacheEntry;
+
+typedef struct scaleCache{
+    struct scaleCacheEntry* entries;
+    int* buckets;
+    int bucketCount;
+    int capacity;
+    int count;
+    int newest;
+    int oldest;
+    long hits;
+    long misses;
+    void* lock;
+}scaleCache;
+
+scaleCache* buildScaleCache(int capacity);
+int lookupScale(scaleCache* cache, polygon* polyInside, polygon* polyOutside,
+                int precision, double* scale);
+int storeScale(scaleCache* cache, polygon* polyInside, polygon* polyOutside,
+                int precision, double scale);
+int freeScaleCache(scaleCache* cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCALECACHE_H */
+
@@ -0,0 +1,607 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          SCENE
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to keep a loaded list of polygons up to
+ * date as it is edited, by applying a log of changes to it, instead of reading
+ * the whole file again when a few polygons change.
+ *
+ * Every polygon in a scene has an id that doesn't change while the scene is
+ * kept. Polygons read from a file have their number in it (from 1), and
+ * polygons added later have the id they are added with. The scene keeps a
+ * broadphase grid (see broadphase.c) of them by id, which is updated as each
+ * polygon changes, so finding what a changed polygon now touches only looks
+ * near it.
+ *
+ * An update file has one change per line:
+ *
+ *      add ID VERTICES             add a polygon, with an id not in use
+ *      replace ID VERTICES         give a polygon a new shape
+ *      remove ID                   remove a polygon
+ *      move ID DX DY               move a polygon by DX and DY
+ *      transform ID SCALE ANGLE X Y
+ *                                  set a polygon's scale, its rotation in
+ *                                  degrees and the position of its centre
+ *
+ * where VERTICES are written as a line of an object file (see parser.c).
+ * Blank lines and lines starting with # are ignored. Changes are made in
+ * order, and either all of them are made or, if any line is wrong, none are.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "vector.h"
+#include "polygon.h"
+#include "collision.h"
+#include "hull.h"
+#include "decompose.h"
+#include "lod.h"
+#include "broadphase.h"
+#include "parser.h"
+#include "scene.h"
+
+//the kinds of change
+#define CHANGE_ADD 0
+#define CHANGE_REPLACE 1
+#define CHANGE_REMOVE 2
+#define CHANGE_MOVE 3
+#define CHANGE_TRANSFORM 4
+
+//the largest id a polygon can have, as the grid keeps a slot for every id up
+//to the largest
+#define SCENE_MAX_ID (1 << 24)
+
+//the size of the first block of an update file read, which is doubled as
+//needed
+#define SCENE_READ_SIZE (1 << 16)
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SCENE CHANGE TYPE DEFINITION ///////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This holds one change read from an update file, before it is made: its kind,
+ * the id of the polygon it changes, the line it was on, and either the new
+ * shape or the numbers given.
+ */
+typedef struct sceneChange{
+    int type;
+    int id;
+    int line;
+    polygon* shape;
+    double values[4];
+}sceneChange;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD SCENE ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function makes a scene of a NULL-terminated list of count polygons (as
+ * read by loadPolygons), which it then owns: the list is kept as the scene's
+ * list, and is freed with it. The polygons are given the ids 1 to count.
+ *
+ * Polygons added later are used as they are given. Set the scene's preparation
+ * to SCENE_SPLIT or SCENE_HULL to have them prepared as the rest were.
+ */
+scene* buildScene(polygon** list, int count){
+    scene* s = malloc(sizeof(scene));
+    s->polygons = list;
+    s->count = count;
+    s->capacity = count+1;
+    s->ids = malloc(sizeof(int)*(count+1));
+    s->idCapacity = count+1;
+    s->slots = malloc(sizeof(int)*s->idCapacity);
+    s->preparation = SCENE_AS_GIVEN;
+
+    bounds* boxes = malloc(sizeof(bounds)*(count+1));
+    int i;
+    s->slots[0] = -1;
+    for(i = 0; i < count; i++){
+        s->ids[i] = i+1;
+        s->slots[i+1] = i;
+        getPolygonBounds(list[i], &boxes[i]);
+    }
+    s->grid = buildGridOfBoxes(boxes, count, 1);
+    free(boxes);
+    return s;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GET SCENE POLYGON //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function returns the polygon with the given id, or NULL if there isn't
+ * one.
+ */
+polygon* getScenePolygon(scene* s, int id){
+    if(id < 0 || id >= s->idCapacity || s->slots[id] < 0){
+        return NULL;
+    }
+    return s->polygons[s->slots[id]];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// REFRESH SCENE POLYGON //////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function moves the polygon with the given id to where it now is in the
+ * grid. It must be called whenever a scene's polygon is moved, turned or scaled
+ * other than by applySceneChanges, or the checks which use the grid miss it.
+ * Returns EXIT_FAILURE if there is no polygon with that id.
+ */
+int refreshScenePolygon(scene* s, int id){
+    polygon* p = getScenePolygon(s, id);
+    if(p == NULL){
+        return(EXIT_FAILURE);
+    }
+    bounds b;
+    getPolygonBounds(p, &b);
+    gridUpdate(s->grid, id, &b);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FIND SCENE COLLISIONS //////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function finds every polygon which collides with the polygon with the
+ * given id, and puts their ids, from lowest to highest, in *results, which is
+ * grown as gridQuery does. Returns the number found, or -1 if there is no
+ * polygon with that id. Only the polygons near it in the grid are checked.
+ */
+static int compareIds(const void* a, const void* b){
+    return *(const int*)a - *(const int*)b;
+}
+
+int findSceneCollisions(scene* s, int id, int** results, int* capacity){
+    polygon* p = getScenePolygon(s, id);
+    if(p == NULL){
+        return -1;
+    }
+    bounds b;
+    getPolygonBounds(p, &b);
+    int near = gridQuery(s->grid, &b, results, capacity);
+    int i, found = 0;
+    for(i = 0; i < near; i++){
+        int other = (*results)[i];
+        if(other != id && checkCollisions(p, getScenePolygon(s, other)) == 0){
+            (*results)[found] = other;
+            found++;
+        }
+    }
+    qsort(*results, found, sizeof(int), compareIds);
+    return found;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SET CHANGE ERROR ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function records what is wrong with a line of an update file.
+ */
+static int setChangeError(parseError* error, int line, int column,
+        const char* message, int id){
+    error->line = line;
+    error->column = column;
+    snprintf(error->message, sizeof(error->message), message, id);
+    return(EXIT_FAILURE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ CHANGE ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads one line of an update file, from start to end (not
+ * including its new line), into a change. Returns EXIT_FAILURE, with the error
+ * set, if it can't be read.
+ */
+static int readChange(const char* start, const char* end, int line,
+        sceneChange* change, parseError* error){
+    const char* names[] = {"add", "replace", "remove", "move", "transform"};
+    int valueCounts[] = {0, 0, 0, 2, 4};
+    const char* c = start;
+
+    //the kind of change
+    const char* word = c;
+    while(c < end && isalpha((unsigned char)*c)){
+        c++;
+    }
+    change->type = -1;
+    int i;
+    for(i = 0; i < 5; i++){
+        if((size_t)(c - word) == strlen(names[i]) &&
+                strncmp(word, names[i], c - word) == 0){
+            change->type = i;
+        }
+    }
+    if(change->type < 0){
+        return setChangeError(error, line, 1, "unknown change", 0);
+    }
+
+    //the id, and any numbers after it. The line is copied so strtod stops at
+    //its end
+    size_t length = end - c;
+    char* rest = malloc(length+1);
+    memcpy(rest, c, length);
+    rest[length] = '\0';
+    char* next;
+    long id = strtol(rest, &next, 10);
+    if(next == rest || id < 1 || id > SCENE_MAX_ID){
+        free(rest);
+        return setChangeError(error, line, (int)(c - start) + 1,
+                "expected an id from 1 to %d", SCENE_MAX_ID);
+    }
+    change->id = (int)id;
+    change->line = line;
+    change->shape = NULL;
+    for(i = 0; i < valueCounts[change->type]; i++){
+        char* number = next;
+        change->values[i] = strtod(number, &next);
+        if(next == number){
+            int column = (int)(c - start) + (int)(number - rest) + 1;
+            free(rest);
+            return setChangeError(error, line, column, "expected a number", 0);
+        }
+    }
+    while(*next == ' ' || *next == '\t' || *next == '\r'){
+        next++;
+    }
+
+    if(change->type == CHANGE_ADD || change->type == CHANGE_REPLACE){
+        //the rest of the line is a polygon
+        int count;
+        parseError shapeError;
+        polygon** shapes = readPolygonsFromText(next, strlen(next), &count,
+                &shapeError);
+        if(shapes == NULL || count != 1){
+            if(shapes != NULL){
+                freePolygonList(shapes);
+                setChangeError(error, line, (int)(c - start) +
+                        (int)(next - rest) + 1, "expected one polygon", 0);
+            }
+            else{
+                *error = shapeError;
+                error->line = line;
+                error->column += (int)(c - start) + (int)(next - rest);
+            }
+            free(rest);
+            return(EXIT_FAILURE);
+        }
+        change->shape = shapes[0];
+        free(shapes);
+    }
+    else if(*next != '\0'){
+        int column = (int)(c - start) + (int)(next - rest) + 1;
+        free(rest);
+        return setChangeError(error, line, column,
+                "unexpected text at the end of the line", 0);
+    }
+    free(rest);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ CHANGES ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads every change in the text of an update file into a newly
+ * allocated list, which *changes is set to. It returns the number read, or -1
+ * (with nothing allocated) if any line can't be read.
+ */
+static int readChanges(const char* text, size_t length, sceneChange** changes,
+        parseError* error){
+    int count = 0, capacity = 16, line = 0;
+    *changes = malloc(sizeof(sceneChange)*capacity);
+    const char* c = text;
+    const char* end = text + length;
+    while(c < end){
+        const char* lineEnd = memchr(c, '\n', end - c);
+        if(lineEnd == NULL){
+            lineEnd = end;
+        }
+        line++;
+
+        const char* first = c;
+        while(first < lineEnd && (*first == ' ' || *first == '\t' ||
+                *first == '\r')){
+            first++;
+        }
+        if(first < lineEnd && *first != '#'){
+            if(count == capacity){
+                capacity = capacity*2;
+                *changes = realloc(*changes, sizeof(sceneChange)*capacity);
+            }
+            if(readChange(first, lineEnd, line, &(*changes)[count], error) !=
+                    EXIT_SUCCESS){
+                error->column += (int)(first - c);
+                int i;
+                for(i = 0; i < count; i++){
+                    if((*changes)[i].shape != NULL){
+                        freePolygon((*changes)[i].shape);
+                    }
+                }
+                free(*changes);
+                *changes = NULL;
+                return -1;
+            }
+            count++;
+        }
+        c = lineEnd + 1;
+    }
+    return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CHECK CHANGES //////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function checks, before any change is made, that every change names a
+ * polygon which will be there when it is made, and that every added polygon's
+ * id won't be in use. Returns EXIT_FAILURE, with the error set to the first
+ * change which fails, if not.
+ */
+static int checkChanges(scene* s, sceneChange* changes, int count,
+        parseError* error){
+    int size = s->idCapacity;
+    int i;
+    for(i = 0; i < count; i++){
+        if(changes[i].id >= size){
+            size = changes[i].id + 1;
+        }
+    }
+    char* present = calloc(size, 1);
+    for(i = 0; i < s->idCapacity; i++){
+        present[i] = (s->slots[i] >= 0);
+    }
+
+    int result = EXIT_SUCCESS;
+    for(i = 0; i < count && result == EXIT_SUCCESS; i++){
+        sceneChange* change = &changes[i];
+        if(change->type == CHANGE_ADD){
+            if(present[change->id]){
+                result = setChangeError(error, change->line, 1,
+                        "polygon %d is already in use", change->id);
+            }
+            present[change->id] = 1;
+        }
+        else if(!present[change->id]){
+            result = setChangeError(error, change->line, 1, "no polygon %d",
+                    change->id);
+        }
+        else if(change->type == CHANGE_REMOVE){
+            present[change->id] = 0;
+        }
+    }
+    free(present);
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// PREPARE SCENE POLYGON //////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function prepares a polygon added to a scene in the same way as the
+ * polygons it was loaded with, and returns it (or the hull standing in for
+ * it).
+ */
+static polygon* prepareScenePolygon(scene* s, polygon* p){
+    if(s->preparation == SCENE_AS_GIVEN){
+        return p;
+    }
+    if(checkIfConvex(p) == 0){
+        polygon* hull = NULL;
+        if(s->preparation == SCENE_HULL){
+            hull = buildHullProxy(p);
+        }
+        if(hull != NULL){
+            p = hull;
+        }
+        else{
+            attachConvexPieces(p);
+        }
+    }
+    attachPolygonDetail(p);
+    return p;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// ADD SCENE POLYGON //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function adds a polygon to the end of a scene's list with the given id,
+ * which must not be in use.
+ */
+static int addScenePolygon(scene* s, int id, polygon* p){
+    if(s->count+1 >= s->capacity){
+        s->capacity = s->capacity*2 + 16;
+        s->polygons = realloc(s->polygons, sizeof(polygon*)*s->capacity);
+        s->ids = realloc(s->ids, sizeof(int)*s->capacity);
+    }
+    if(id >= s->idCapacity){
+        int newCapacity = s->idCapacity*2;
+        if(newCapacity <= id){
+            newCapacity = id+1;
+        }
+        s->slots = realloc(s->slots, sizeof(int)*newCapacity);
+        int i;
+        for(i = s->idCapacity; i < newCapacity; i++){
+            s->slots[i] = -1;
+        }
+        s->idCapacity = newCapacity;
+    }
+    s->polygons[s->count] = p;
+    s->ids[s->count] = id;
+    s->slots[id] = s->count;
+    s->count++;
+    s->polygons[s->count] = NULL;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// REMOVE GAPS ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function closes the gaps left in a scene's list by removed polygons,
+ * keeping the rest in order. Removed polygons are only taken out of the list
+ * once all the changes are made, so removing many costs the same as one.
+ */
+static int removeGaps(scene* s){
+    int i, kept = 0;
+    for(i = 0; i < s->count; i++){
+        if(s->polygons[i] != NULL){
+            s->polygons[kept] = s->polygons[i];
+            s->ids[kept] = s->ids[i];
+            s->slots[s->ids[kept]] = kept;
+            kept++;
+        }
+    }
+    s->count = kept;
+    s->polygons[kept] = NULL;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// MAKE CHANGE ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function makes one change, which has been checked, to a scene, and
+ * moves the polygon it changes in the grid. Returns 1 if it left a gap in the
+ * list.
+ */
+static int makeChange(scene* s, sceneChange* change){
+    int slot = (change->type == CHANGE_ADD) ? -1 : s->slots[change->id];
+    polygon* p = (slot >= 0) ? s->polygons[slot] : NULL;
+    vector* v;
+    switch(change->type){
+        case CHANGE_ADD:
+            p = prepareScenePolygon(s, change->shape);
+            addScenePolygon(s, change->id, p);
+            break;
+        case CHANGE_REPLACE:
+            freePolygon(p);
+            p = prepareScenePolygon(s, change->shape);
+            s->polygons[slot] = p;
+            break;
+        case CHANGE_REMOVE:
+            freePolygon(p);
+            s->polygons[slot] = NULL;
+            s->slots[change->id] = -1;
+            gridRemove(s->grid, change->id);
+            return 1;
+        case CHANGE_MOVE:
+            v = createVector(change->values[0], change->values[1], 0);
+            translatePolygon(p, v);
+            free(v);
+            break;
+        case CHANGE_TRANSFORM:
+            scalePolygonTo(p, change->values[0]);
+            rotatePolygonZTo(p, change->values[1]);
+            v = createVector(change->values[2], change->values[3], p->centre->z);
+            translatePolygonTo(p, v);
+            free(v);
+            break;
+    }
+    change->shape = NULL;
+    refreshScenePolygon(s, change->id);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// APPLY SCENE CHANGES ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function makes every change in the text of an update file to a scene.
+ * Only the polygons named are touched, and only they are moved in the grid.
+ *
+ * The summary is set to the number of each kind of change made, and the ids of
+ * the polygons added, replaced, moved or transformed (and not removed after),
+ * from lowest to highest, in a newly allocated list the caller must free.
+ *
+ * If any line is wrong, nothing is changed, and EXIT_FAILURE is returned with
+ * the error saying why and where.
+ */
+int applySceneChanges(scene* s, const char* text, size_t length,
+        sceneSummary* summary, parseError* error){
+    memset(summary, 0, sizeof(sceneSummary));
+    sceneChange* changes;
+    int count = readChanges(text, length, &changes, error);
+    if(count < 0){
+        return(EXIT_FAILURE);
+    }
+    int i;
+    if(checkChanges(s, changes, count, error) != EXIT_SUCCESS){
+        for(i = 0; i < count; i++){
+            if(changes[i].shape != NULL){
+                freePolygon(changes[i].shape);
+            }
+        }
+        free(changes);
+        return(EXIT_FAILURE);
+    }
+
+    int gaps = 0;
+    for(i = 0; i < count; i++){
+        gaps += makeChange(s, &changes[i]);
+        switch(changes[i].type){
+            case CHANGE_ADD: summary->added++; break;
+            case CHANGE_REPLACE: summary->replaced++; break;
+            case CHANGE_REMOVE: summary->removed++; break;
+            default: summary->moved++; break;
+        }
+    }
+    if(gaps > 0){
+        removeGaps(s);
+    }
+
+    //list each polygon still there which changed, once
+    summary->changed = malloc(sizeof(int)*(count+1));
+    for(i = 0; i < count; i++){
+        if(s->slots[changes[i].id] >= 0){
+            summary->changed[summary->changedCount] = changes[i].id;
+            summary->changedCount++;
+        }
+    }
+    qsort(summary->changed, summary->changedCount, sizeof(int), compareIds);
+    int unique = 0;
+    for(i = 0; i < summary->changedCount; i++){
+        if(unique == 0 || summary->changed[unique-1] != summary->changed[i]){
+            summary->changed[unique] = summary->changed[i];
+            unique++;
+        }
+    }
+    summary->changedCount = unique;
+
+    free(changes);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// APPLY SCENE FILE ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function makes every change in the named update file to a scene, as
+ * applySceneChanges does. If the file can't be opened, EXIT_FAILURE is
+ * returned with the error set to line 0.
+ */
+int applySceneFile(scene* s, const char* filename, sceneSummary* summary,
+        parseError* error){
+    memset(summary, 0, sizeof(sceneSummary));
+    FILE* file = fopen(filename, "rb");
+    if(file == NULL){
+        return setChangeError(error, 0, 0, "could not open the file", 0);
+    }
+    size_t capacity = SCENE_READ_SIZE, length = 0, read;
+    char* text = malloc(capacity);
+    while((read = fread(text + length, 1, capacity - length, file)) > 0){
+        length += read;
+        if(length == capacity){
+            capacity = capacity*2;
+            text = realloc(text, capacity);
+        }
+    }
+    fclose(file);
+
+    int result = applySceneChanges(s, text, length, summary, error);
+    free(text);
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FREE SCENE /////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function frees a scene, with all of its polygons.
+ */
+int freeScene(scene* s){
+    freePolygonList(s->polygons);
+    free(s->ids);
+    free(s->slots);
+    freeSpatialGrid(s->grid);
+    free(s);
+    return(EXIT_SUCCESS);
+}
@@ -0,0 +1,59 @@
+/*
+ * File:   scene.h
+ *
+ * This header file externalises the functions in the scene.c file, which
+ * keeps a loaded list of polygons up to date from a log of changes.
+ *
+ * For further details on any function, check there.
+ */
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//how polygons added to a scene are prepared: used as they are, concave ones
+//split into convex pieces, or concave ones replaced by their hulls
+#define SCENE_AS_GIVEN 0
+#define SCENE_SPLIT 1
+#define SCENE_HULL 2
+
+struct spatialGrid;
+
+typedef struct scene{
+    polygon** polygons;
+    int count;
+    int capacity;
+    int* ids;
+    int* slots;
+    int idCapacity;
+    int preparation;
+    struct spatialGrid* grid;
+}scene;
+
+typedef struct sceneSummary{
+    int added;
+    int replaced;
+    int removed;
+    int moved;
+    int* changed;
+    int changedCount;
+}sceneSummary;
+
+scene* buildScene(polygon** list, int count);
+polygon* getScenePolygon(scene* s, int id);
+int refreshScenePolygon(scene* s, int id);
+int findSceneCollisions(scene* s, int id, int** results, int* capacity);
+int applySceneChanges(scene* s, const char* text, size_t length,
+        sceneSummary* summary, parseError* error);
+int applySceneFile(scene* s, const char* filename, sceneSummary* summary,
+        parseError* error);
+int freeScene(scene* s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCENE_H */
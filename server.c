@@ -0,0 +1,524 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          SERVER
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to answer a stream of questions about one
+ * loaded scene, so the scene is only loaded and prepared once however many
+ * questions are asked.
+ *
+ * Questions are read one per line, from the standard input or from any number
+ * of connections to a Unix socket at once, and each is answered with one line,
+ * in the order they were asked:
+ *
+ *      collide A B         collide,A,B,COLLIDE,DISTANCE
+ *      contain A B         contain,A,B,CONTAINED
+ *      fit A B [PRECISION [ITERATIONS [SECONDS [SEED]]]]
+ *                          fit,A,B,SCALE,ROTATION,X,Y,SEED,EVALUATIONS,STOPPED
+ *      count               count,POLYGONS
+ *      quit                (no answer) ends the connection
+ *
+ * with the same meanings as the command line (see cli.c). Settings left out
+ * of a fit take the command line's defaults, except the seed, which is 1 so
+ * the same question always gets the same answer. A question that can't be
+ * answered is answered with "error,REASON". Blank lines are skipped.
+ *
+ * A client doesn't need to wait for each answer before asking the next:
+ * everything sent so far is read at once, every whole line in it is answered,
+ * and all of the answers are sent back together.
+ *
+ * Nothing about the scene changes while it is served. Everything the checks
+ * would otherwise make the first time they need it is made before the first
+ * question, so every connection only reads the scene and they can run at the
+ * same time without locks. Fits work on their own copies, and share one
+ * cache of results.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <signal.h>
+#include <errno.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+#include "vector.h"
+#include "polygon.h"
+#include "collision.h"
+#include "distance.h"
+#include "sampler.h"
+#include "scalecache.h"
+#include "applications.h"
+#include "server.h"
+
+//the size of the first block read from a connection, which is doubled if a
+//line is longer
+#define SERVER_READ_SIZE (1 << 16)
+
+//the number of fit results kept between questions
+#define SERVER_CACHE_SIZE 100000
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SERVER TYPE DEFINITIONS ////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* serverScene is the scene shared by every connection, with the connections
+ * open to a socket, so they can be closed when the server stops. serverOutput
+ * gathers the answers to one batch of questions so they can be sent together,
+ * and serverConnection is what each connection's thread is given.
+ */
+typedef struct serverScene{
+    polygon** polygons;
+    int count;
+    scaleCache* cache;
+    pthread_mutex_t lock;
+    pthread_cond_t closed;
+    int* clients;
+    int clientCount;
+    int clientCapacity;
+}serverScene;
+
+typedef struct serverOutput{
+    char* text;
+    size_t length;
+    size_t capacity;
+}serverOutput;
+
+typedef struct serverConnection{
+    serverScene* scene;
+    int in;
+    int out;
+}serverConnection;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// PREPARE SCENE //////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function makes everything the collision checks would otherwise make
+ * the first time they look at each polygon (see prepareCollisionChecks), so
+ * the connections' threads only ever read the polygons. The pieces and levels
+ * of detail have already been made by whoever loaded the scene.
+ */
+static int prepareScene(serverScene* scene){
+    int i;
+    for(i = 0; i < scene->count; i++){
+        prepareCollisionChecks(scene->polygons[i]);
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// ADD ANSWER /////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function adds one line, written as printf would, to the answers to be
+ * sent.
+ */
+static int addAnswer(serverOutput* output, const char* format, ...){
+    for(;;){
+        va_list arguments;
+        va_start(arguments, format);
+        size_t space = output->capacity - output->length;
+        int written = vsnprintf(output->text + output->length, space, format,
+                arguments);
+        va_end(arguments);
+        if(written < 0){
+            return(EXIT_FAILURE);
+        }
+        if((size_t)written + 1 < space){
+            output->length += written;
+            output->text[output->length++] = '\n';
+            return(EXIT_SUCCESS);
+        }
+        output->capacity = output->capacity*2 + written;
+        output->text = realloc(output->text, output->capacity);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SEND ANSWERS ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function sends every answer gathered, and empties the list. Returns
+ * EXIT_FAILURE if the other end has gone.
+ */
+static int sendAnswers(int out, serverOutput* output){
+    size_t sent = 0;
+    while(sent < output->length){
+        long written = write(out, output->text + sent, output->length - sent);
+        if(written < 0 && errno == EINTR){
+            continue;
+        }
+        if(written <= 0){
+            return(EXIT_FAILURE);
+        }
+        sent += written;
+    }
+    output->length = 0;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ POLYGON ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function reads a polygon's number from a question, and returns the
+ * polygon, or NULL if there isn't one with that number.
+ */
+static polygon* readPolygon(serverScene* scene, const char* text){
+    char* end;
+    long number = strtol(text, &end, 10);
+    if(end == text || *end != '\0' || number < 1 || number > scene->count){
+        return NULL;
+    }
+    return scene->polygons[number-1];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// ANSWER QUESTION ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function answers one line of questions. It returns 1 if the line asks
+ * to end the connection, or 0 otherwise.
+ */
+static int answerQuestion(serverScene* scene, char* line, serverOutput* output){
+    //split the line into words, in place (strtok isn't safe with several
+    //connections at once)
+    char* words[8];
+    int count = 0;
+    char* c = line;
+    for(;;){
+        while(*c == ' ' || *c == '\t' || *c == '\r'){
+            *c++ = '\0';
+        }
+        if(*c == '\0'){
+            break;
+        }
+        if(count == 8){
+            addAnswer(output, "error,too many words");
+            return 0;
+        }
+        words[count++] = c;
+        while(*c != '\0' && *c != ' ' && *c != '\t' && *c != '\r'){
+            c++;
+        }
+    }
+    if(count == 0){
+        return 0;
+    }
+
+    if(strcmp(words[0], "quit") == 0){
+        return 1;
+    }
+    if(strcmp(words[0], "count") == 0){
+        addAnswer(output, "count,%d", scene->count);
+        return 0;
+    }
+
+    int isCollide = (strcmp(words[0], "collide") == 0);
+    int isContain = (strcmp(words[0], "contain") == 0);
+    int isFit = (strcmp(words[0], "fit") == 0);
+    if(!isCollide && !isContain && !isFit){
+        addAnswer(output, "error,unknown question %s", words[0]);
+        return 0;
+    }
+    if(count < 3 || (!isFit && count > 3)){
+        addAnswer(output, "error,%s needs two polygon numbers", words[0]);
+        return 0;
+    }
+    polygon* a = readPolygon(scene, words[1]);
+    polygon* b = readPolygon(scene, words[2]);
+    if(a == NULL || b == NULL){
+        addAnswer(output, "error,no polygon %s", (a == NULL) ? words[1] : words[2]);
+        return 0;
+    }
+
+    if(isCollide){
+        if(checkCollisions(a, b) == 1){
+            clearance* gap = findClearance(a, b, NULL);
+            addAnswer(output, "collide,%s,%s,0,%.10g", words[1], words[2],
+                    gap->distance);
+            freeClearance(gap);
+        }
+        else{
+            addAnswer(output, "collide,%s,%s,1,0", words[1], words[2]);
+        }
+        return 0;
+    }
+    if(isContain){
+        addAnswer(output, "contain,%s,%s,%d", words[1], words[2],
+                checkInsideBoundingBox(a, b));
+        return 0;
+    }
+
+    //a fit, with any of its settings left out taking their defaults
+    int precision = (count > 3) ? atoi(words[3]) : 4;
+    int iterations = (count > 4) ? atoi(words[4]) : 1000;
+    double timeLimit = (count > 5) ? atof(words[5]) : 0;
+    unsigned long seed = (count > 6) ? strtoul(words[6], NULL, 10) : 1;
+    if(precision < 1 || precision > 8 || iterations < 1 || timeLimit < 0){
+        addAnswer(output, "error,bad fit settings");
+        return 0;
+    }
+    fitOptions* options = buildFitOptions(seed, 0);
+    options->timeLimit = timeLimit;
+    options->cache = scene->cache;
+    transformation* t = findMinScaleWithTranslation(a, b, precision,
+            iterations, options);
+    addAnswer(output, "fit,%s,%s,%.10g,%.10g,%.10g,%.10g,%lu,%ld,%d", words[1],
+            words[2], t->scale, t->rotationZ, t->translation->x,
+            t->translation->y, options->seed, options->evaluations,
+            options->stopped);
+    free(t->translation);
+    free(t);
+    free(options);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SERVE CONNECTION ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function answers every question sent on one connection, until the
+ * other end closes it or asks to quit. Whatever has arrived is read at once,
+ * and the answers to every whole line in it are sent together.
+ */
+static int serveConnection(serverScene* scene, int in, int out){
+    size_t capacity = SERVER_READ_SIZE, length = 0;
+    char* buffer = malloc(capacity);
+    serverOutput output;
+    output.capacity = SERVER_READ_SIZE;
+    output.length = 0;
+    output.text = malloc(output.capacity);
+    int finished = 0;
+
+    while(finished == 0){
+        if(length == capacity){
+            capacity = capacity*2;
+            buffer = realloc(buffer, capacity);
+        }
+        long received;
+        do{
+            received = read(in, buffer + length, capacity - length);
+        }while(received < 0 && errno == EINTR);
+        if(received <= 0){
+            //answer a last line with no new line after it
+            if(length > 0){
+                buffer[length] = '\0';
+                answerQuestion(scene, buffer, &output);
+            }
+            break;
+        }
+        length += received;
+
+        //answer every whole line
+        size_t start = 0;
+        char* newLine;
+        while(finished == 0 && (newLine = memchr(buffer + start, '\n',
+                length - start)) != NULL){
+            *newLine = '\0';
+            finished = answerQuestion(scene, buffer + start, &output);
+            start = (newLine - buffer) + 1;
+        }
+        memmove(buffer, buffer + start, length - start);
+        length -= start;
+        if(length == capacity){
+            //make room for the '\0' of a line which fills the buffer
+            capacity = capacity*2;
+            buffer = realloc(buffer, capacity);
+        }
+
+        if(sendAnswers(out, &output) != EXIT_SUCCESS){
+            break;
+        }
+    }
+    sendAnswers(out, &output);
+
+    free(buffer);
+    free(output.text);
+    return(EXIT_SUCCESS);
+}
+
+#ifndef _WIN32
+////////////////////////////////////////////////////////////////////////////////
+/////////////// STOP SERVING ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* Set when the server is asked to stop, so no more connections are taken.
+ */
+static volatile sig_atomic_t stopServing = 0;
+
+static void handleStopSignal(int signal){
+    stopServing = 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// RUN CONNECTION /////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function is run by each connection's own thread. It answers the
+ * connection's questions and then closes it, and takes it off the scene's
+ * list of open connections.
+ */
+static void* runConnection(void* data){
+    serverConnection* connection = data;
+    serverScene* scene = connection->scene;
+    serveConnection(scene, connection->in, connection->out);
+
+    //closed under the lock so the server can't shut down a connection which
+    //has been closed and its number reused
+    pthread_mutex_lock(&scene->lock);
+    int i;
+    for(i = 0; i < scene->clientCount; i++){
+        if(scene->clients[i] == connection->in){
+            scene->clients[i] = scene->clients[--scene->clientCount];
+            break;
+        }
+    }
+    close(connection->in);
+    pthread_cond_signal(&scene->closed);
+    pthread_mutex_unlock(&scene->lock);
+
+    free(connection);
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CLOSE CONNECTIONS //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function ends every open connection, and waits for their threads to
+ * finish with the scene. A question already being answered is finished first.
+ */
+static int closeConnections(serverScene* scene){
+    pthread_mutex_lock(&scene->lock);
+    int i;
+    for(i = 0; i < scene->clientCount; i++){
+        shutdown(scene->clients[i], SHUT_RDWR);
+    }
+    while(scene->clientCount > 0){
+        pthread_cond_wait(&scene->closed, &scene->lock);
+    }
+    pthread_mutex_unlock(&scene->lock);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SERVE SOCKET ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function takes connections to a Unix socket at the given path until
+ * the server is interrupted or terminated, giving each its own thread. The
+ * socket is removed when it stops, and every connection still open is ended.
+ */
+static int serveSocket(serverScene* scene, const char* path){
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(strlen(path) >= sizeof(address.sun_path)){
+        fprintf(stderr, "error: %s: the socket path is too long\n", path);
+        return(EXIT_FAILURE);
+    }
+    strcpy(address.sun_path, path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listener < 0 || bind(listener, (struct sockaddr*)&address,
+            sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0){
+        fprintf(stderr, "error: %s: could not open the socket (%s)\n", path,
+                strerror(errno));
+        if(listener >= 0){
+            close(listener);
+        }
+        return(EXIT_FAILURE);
+    }
+
+    //without SA_RESTART, a signal stops accept so the loop can end
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handleStopSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    fprintf(stderr, "serving %d polygons on %s\n", scene->count, path);
+    while(stopServing == 0){
+        int client = accept(listener, NULL, NULL);
+        if(client < 0){
+            continue;
+        }
+        serverConnection* connection = malloc(sizeof(serverConnection));
+        connection->scene = scene;
+        connection->in = client;
+        connection->out = client;
+
+        pthread_mutex_lock(&scene->lock);
+        if(scene->clientCount == scene->clientCapacity){
+            scene->clientCapacity = scene->clientCapacity*2 + 8;
+            scene->clients = realloc(scene->clients,
+                    sizeof(int)*scene->clientCapacity);
+        }
+        scene->clients[scene->clientCount++] = client;
+        pthread_t thread;
+        if(pthread_create(&thread, NULL, runConnection, connection) != 0){
+            scene->clientCount--;
+            close(client);
+            free(connection);
+        }
+        else{
+            pthread_detach(thread);
+        }
+        pthread_mutex_unlock(&scene->lock);
+    }
+
+    close(listener);
+    unlink(path);
+    closeConnections(scene);
+    return(EXIT_SUCCESS);
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SERVE SCENE ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function answers questions about a list of polygons, which should
+ * already have their pieces and levels of detail, until told to stop. If
+ * socketPath is NULL the questions are read from the standard input and
+ * answered on the standard output, until it ends. Otherwise any number of
+ * clients can connect to a Unix socket made at that path, until the server is
+ * interrupted or terminated. Sockets aren't available on Windows.
+ *
+ * The polygons aren't changed, and aren't freed. Returns EXIT_FAILURE if the
+ * socket couldn't be made.
+ */
+int serveScene(polygon** list, int count, const char* socketPath){
+    serverScene scene;
+    scene.polygons = list;
+    scene.count = count;
+    scene.cache = buildScaleCache(SERVER_CACHE_SIZE);
+    pthread_mutex_init(&scene.lock, NULL);
+    pthread_cond_init(&scene.closed, NULL);
+    scene.clients = NULL;
+    scene.clientCount = 0;
+    scene.clientCapacity = 0;
+    prepareScene(&scene);
+
+    int result = EXIT_SUCCESS;
+#ifdef _WIN32
+    if(socketPath != NULL){
+        fprintf(stderr, "error: sockets aren't available on this system\n");
+        result = EXIT_FAILURE;
+    }
+    else{
+        serveConnection(&scene, 0, 1);
+    }
+#else
+    //a client which goes away mid-answer shouldn't end the server
+    signal(SIGPIPE, SIG_IGN);
+    if(socketPath != NULL){
+        result = serveSocket(&scene, socketPath);
+    }
+    else{
+        serveConnection(&scene, STDIN_FILENO, STDOUT_FILENO);
+    }
+#endif
+
+    freeScaleCache(scene.cache);
+    pthread_mutex_destroy(&scene.lock);
+    pthread_cond_destroy(&scene.closed);
+    free(scene.clients);
+    return result;
+}
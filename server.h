@@ -0,0 +1,23 @@
+/*
+ * File:   server.h
+ *
+ * This header file externalises the functions in the server.c file, which
+ * answers questions about a loaded scene from the standard input or a socket.
+ *
+ * For further details on any function, check there.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int serveScene(polygon** list, int count, const char* socketPath);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SERVER_H */
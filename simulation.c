@@ -0,0 +1,592 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//                          SIMULATION
+//
+////////////////////////////////////////////////////////////////////////////////
+/* This file contains the functions to run a list of polygons forward in time,
+ * a step at a time, such as parts moving along conveyors. Each polygon (a
+ * "body") has a velocity, in distance per second, and a spin, in degrees per
+ * second, and every step:
+ *
+ *  1. moves each body which has a velocity or spin by it, using
+ *     translatePolygon and rotatePolygonZ, and gets it ready to be checked
+ *     (see prepareCollisionChecks);
+ *  2. moves each of them in the broadphase grid (see broadphase.c);
+ *  3. finds every pair of bodies whose boxes overlap in the grid and which
+ *     aren't both still, and checks each pair fully, keeping those which touch
+ *     as the step's contacts, along with the pairs of still bodies which rest
+ *     against each other.
+ *
+ * Bodies with no velocity or spin "sleep": they aren't moved or looked for.
+ * A pair of them can't change, so it is only checked in the first step after
+ * one of them falls asleep, and if it touches it is kept as a resting contact
+ * until one of them wakes. Only the bodies that move, or have just stopped,
+ * cost anything, so a scene of mostly still parts steps quickly however large
+ * it is.
+ *
+ * Moving and checking the bodies is split over several threads, in blocks of
+ * bodies. Each body is only moved by one thread, and once every body has been
+ * moved and made ready the checks only read them. Contacts are listed in
+ * order of their first and then second body, so the result doesn't depend on
+ * the threads.
+ *
+ * A step can be given a budget, in seconds. Bodies are always moved, but once
+ * the step has taken longer than its budget no more blocks of bodies are
+ * checked, and the bodies left are counted as skipped, so a slow step can't
+ * hold up those after it. Their contacts are missing from that step only.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vector.h"
+#include "polygon.h"
+#include "collision.h"
+#include "broadphase.h"
+#include "parallel.h"
+#include "parser.h"
+#include "simulation.h"
+
+//the number of bodies each thread takes at a time
+#define SIMULATION_BLOCK 256
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SIMULATION TYPE DEFINITIONS ////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* A simulationWorker holds what one thread finds while checking the bodies,
+ * so the threads never write to the same place: the ids the grid returns, the
+ * contacts found, and how many pairs and bodies were checked.
+ *
+ * A bodyMotion is one line of a motion file, before it is used.
+ *
+ * The rest states say whether a sleeping body's resting contacts are known:
+ * not at all (it is awake, or has woken since), not yet (it has fallen asleep
+ * since the last step, and is in the settling list), or they are in the list
+ * of resting contacts.
+ */
+typedef struct simulationWorker{
+    int* nearby;
+    int nearbyCapacity;
+    simulationContact* contacts;
+    int contactCount;
+    int contactCapacity;
+    int pairs;
+    int checked;
+}simulationWorker;
+
+#define REST_UNKNOWN 0
+#define REST_SETTLING 1
+#define REST_KNOWN 2
+
+typedef struct bodyMotion{
+    int body;
+    double values[3];
+}bodyMotion;
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// BUILD SIMULATION ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function makes a simulation of a list of count polygons, with every
+ * body still, and all of them to be settled in the first step. The polygons are moved by the simulation but still belong to
+ * the caller, and must be freed after it. Threads is the number of threads to
+ * use: 0 uses one for each processor.
+ */
+simulation* buildSimulation(polygon** list, int count, int threads){
+    simulation* sim = malloc(sizeof(simulation));
+    sim->polygons = list;
+    sim->count = count;
+    sim->velocityX = calloc(count+1, sizeof(double));
+    sim->velocityY = calloc(count+1, sizeof(double));
+    sim->spin = calloc(count+1, sizeof(double));
+    sim->awake = malloc(sizeof(int)*(count+1));
+    sim->awakeSlots = malloc(sizeof(int)*(count+1));
+    sim->awakeCount = 0;
+    sim->restState = malloc(sizeof(char)*(count+1));
+    sim->settling = malloc(sizeof(int)*(count+1));
+    sim->settlingCount = count;
+    sim->resting = NULL;
+    sim->restingCount = 0;
+    sim->restingCapacity = 0;
+    sim->boxes = malloc(sizeof(bounds)*(count+1));
+    sim->budget = 0;
+    sim->step = 0;
+    sim->frameStart = 0;
+    sim->contacts = NULL;
+    sim->contactCapacity = 0;
+    memset(&sim->frame, 0, sizeof(simulationFrame));
+
+    sim->threads = (threads > 0) ? threads : getProcessorCount();
+    sim->workers = calloc(sim->threads, sizeof(simulationWorker));
+
+    //get every body ready to be checked, so the sleeping ones never have to be
+    //again
+    int i;
+    for(i = 0; i < count; i++){
+        sim->awakeSlots[i] = -1;
+        sim->restState[i] = REST_SETTLING;
+        sim->settling[i] = i;
+        prepareCollisionChecks(list[i]);
+        getPolygonBounds(list[i], &sim->boxes[i]);
+    }
+    sim->grid = buildGridOfBoxes(sim->boxes, count, 0);
+    return sim;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SET BODY VELOCITY //////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function sets the velocity and spin of a body, by its index in the
+ * list. A body given no velocity or spin goes to sleep, and is settled in the
+ * next step, and any other wakes, dropping its resting contacts. Returns
+ * EXIT_FAILURE if there is no such body.
+ */
+int setBodyVelocity(simulation* sim, int body, double velocityX,
+        double velocityY, double spin){
+    if(body < 0 || body >= sim->count){
+        return(EXIT_FAILURE);
+    }
+    sim->velocityX[body] = velocityX;
+    sim->velocityY[body] = velocityY;
+    sim->spin[body] = spin;
+
+    int moving = (velocityX != 0 || velocityY != 0 || spin != 0);
+    int slot = sim->awakeSlots[body];
+    if(moving && slot < 0){
+        sim->awakeSlots[body] = sim->awakeCount;
+        sim->awake[sim->awakeCount] = body;
+        sim->awakeCount++;
+        //a body still waiting to settle stays in the list, and is passed over
+        if(sim->restState[body] == REST_KNOWN){
+            sim->restState[body] = REST_UNKNOWN;
+        }
+    }
+    else if(!moving && slot >= 0){
+        //fill its place in the list of awake bodies with the last one
+        sim->awakeCount--;
+        int last = sim->awake[sim->awakeCount];
+        sim->awake[slot] = last;
+        sim->awakeSlots[last] = slot;
+        sim->awakeSlots[body] = -1;
+        if(sim->restState[body] == REST_UNKNOWN){
+            sim->restState[body] = REST_SETTLING;
+            sim->settling[sim->settlingCount] = body;
+            sim->settlingCount++;
+        }
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// READ MOTION ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* These functions read a motion file, which sets the velocity and spin of
+ * bodies, with one body on each line:
+ *
+ *      NUMBER VX VY [SPIN]         set the body with that number (from 1)
+ *      all VX VY [SPIN]            set every body
+ *
+ * where the spin is 0 if it isn't given. Blank lines and lines starting with #
+ * are ignored, and lines are used in order, so an "all" line can be followed
+ * by the bodies which move differently.
+ *
+ * Every line is read before any is used, so if any line is wrong, with the
+ * error set to it, nothing is changed. If the file can't be opened, the error
+ * is set to line 0.
+ */
+static int setMotionError(parseError* error, int line, int column,
+        const char* message){
+    error->line = line;
+    error->column = column;
+    snprintf(error->message, sizeof(error->message), "%s", message);
+    return(EXIT_FAILURE);
+}
+
+static int readMotion(const char* text, const char* start, int line,
+        int count, bodyMotion* motion, parseError* error){
+    const char* c = start;
+    char* end;
+    if(strncmp(c, "all", 3) == 0 && (c[3] == ' ' || c[3] == '\t')){
+        motion->body = -1;
+        c += 3;
+    }
+    else{
+        long number = strtol(c, &end, 10);
+        if(end == c || number < 1 || number > count){
+            return setMotionError(error, line, (int)(c - text) + 1,
+                    "expected the number of a polygon in the file, or all");
+        }
+        motion->body = (int)number - 1;
+        c = end;
+    }
+
+    int i;
+    motion->values[2] = 0;
+    for(i = 0; i < 3; i++){
+        while(*c == ' ' || *c == '\t'){
+            c++;
+        }
+        //the spin can be left out
+        if(i == 2 && (*c == '\0' || *c == '\n' || *c == '\r')){
+            break;
+        }
+        motion->values[i] = strtod(c, &end);
+        if(end == c || !isfinite(motion->values[i])){
+            return setMotionError(error, line, (int)(c - text) + 1,
+                    (i < 2) ? "expected a velocity" : "expected a spin");
+        }
+        c = end;
+    }
+    while(*c == ' ' || *c == '\t' || *c == '\r' || *c == '\n'){
+        c++;
+    }
+    if(*c != '\0'){
+        return setMotionError(error, line, (int)(c - text) + 1,
+                "unexpected text at the end of the line");
+    }
+    return(EXIT_SUCCESS);
+}
+
+int readSimulationMotion(simulation* sim, const char* filename,
+        parseError* error){
+    FILE* file = fopen(filename, "rt");
+    if(file == NULL){
+        return setMotionError(error, 0, 0, "could not open the file");
+    }
+
+    char text[256];
+    int count = 0, capacity = 64, line = 0;
+    bodyMotion* motions = malloc(sizeof(bodyMotion)*capacity);
+    while(fgets(text, sizeof(text), file) != NULL){
+        line++;
+
+        //skip blank lines and comments
+        char* start = text;
+        while(*start == ' ' || *start == '\t'){
+            start++;
+        }
+        if(*start == '#' || *start == '\n' || *start == '\r' || *start == '\0'){
+            continue;
+        }
+
+        if(count == capacity){
+            capacity = capacity*2;
+            motions = realloc(motions, sizeof(bodyMotion)*capacity);
+        }
+        if(readMotion(text, start, line, sim->count, &motions[count], error) !=
+                EXIT_SUCCESS){
+            free(motions);
+            fclose(file);
+            return(EXIT_FAILURE);
+        }
+        count++;
+    }
+    fclose(file);
+
+    int i, j;
+    for(i = 0; i < count; i++){
+        double* v = motions[i].values;
+        if(motions[i].body >= 0){
+            setBodyVelocity(sim, motions[i].body, v[0], v[1], v[2]);
+            continue;
+        }
+        for(j = 0; j < sim->count; j++){
+            setBodyVelocity(sim, j, v[0], v[1], v[2]);
+        }
+    }
+    free(motions);
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// MOVE BODIES ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function moves one block of the awake bodies by their velocity and
+ * spin over the step, gets them ready to be checked, and stores their new
+ * boxes. It is run on several threads at once, each on its own block.
+ */
+static int moveBodies(int index, int thread, void* data){
+    simulation* sim = data;
+    int first = index*SIMULATION_BLOCK;
+    int last = (first + SIMULATION_BLOCK < sim->awakeCount) ?
+            first + SIMULATION_BLOCK : sim->awakeCount;
+    int k;
+    for(k = first; k < last; k++){
+        int i = sim->awake[k];
+        polygon* p = sim->polygons[i];
+        vector move = {sim->velocityX[i]*sim->step,
+                sim->velocityY[i]*sim->step, 0};
+        translatePolygon(p, &move);
+        if(sim->spin[i] != 0){
+            rotatePolygonZ(p, sim->spin[i]*sim->step);
+        }
+        prepareCollisionChecks(p);
+        getPolygonBounds(p, &sim->boxes[i]);
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// ADD CONTACT ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function checks a pair of bodies fully, and if they touch adds them to
+ * a thread's contacts.
+ */
+static int addContact(simulation* sim, simulationWorker* w, int i, int other){
+    w->pairs++;
+    if(checkCollisions(sim->polygons[i], sim->polygons[other]) != 0){
+        return(EXIT_SUCCESS);
+    }
+
+    //the normal points from the first body towards the second, and the depth
+    //is how far the second must move along it to separate. Adding zero turns
+    //-0 into 0
+    if(w->contactCount == w->contactCapacity){
+        w->contactCapacity = (w->contactCapacity > 0) ?
+                w->contactCapacity*2 : 64;
+        w->contacts = realloc(w->contacts,
+                sizeof(simulationContact)*w->contactCapacity);
+    }
+    simulationContact* c = &w->contacts[w->contactCount];
+    c->first = (i < other) ? i : other;
+    c->second = (i < other) ? other : i;
+    vector axis;
+    c->depth = 0 - getSeparation(sim->polygons[c->first],
+            sim->polygons[c->second], &axis);
+    c->normalX = axis.x + 0.0;
+    c->normalY = axis.y + 0.0;
+    w->contactCount++;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// SETTLE BODIES //////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function checks one block of the bodies which have fallen asleep since
+ * the last step against the sleeping bodies near them, adding the pairs which
+ * touch to the thread's contacts, to be kept as resting contacts. A pair of
+ * bodies settling together is only checked by the one with the lower index.
+ * The budget isn't checked, as a pair missed here would never be checked
+ * again.
+ */
+static int settleBodies(int index, int thread, void* data){
+    simulation* sim = data;
+    simulationWorker* w = &sim->workers[thread];
+    int first = index*SIMULATION_BLOCK;
+    int last = (first + SIMULATION_BLOCK < sim->settlingCount) ?
+            first + SIMULATION_BLOCK : sim->settlingCount;
+    int j, k;
+    for(k = first; k < last; k++){
+        int i = sim->settling[k];
+        if(sim->awakeSlots[i] >= 0){
+            continue;
+        }
+        int near = gridQuery(sim->grid, &sim->boxes[i], &w->nearby,
+                &w->nearbyCapacity);
+        for(j = 0; j < near; j++){
+            int other = w->nearby[j];
+            if(other == i || sim->awakeSlots[other] >= 0 ||
+                    (other < i && sim->restState[other] == REST_SETTLING)){
+                continue;
+            }
+            addContact(sim, w, i, other);
+        }
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// CHECK BODIES ///////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function checks one block of the awake bodies against everything near
+ * them in the grid, adding the pairs which touch to the thread's contacts. A
+ * pair of awake bodies is only checked by the one with the lower index. If the
+ * step is over its budget, the block isn't checked, and no more are started.
+ */
+static int checkBodies(int index, int thread, void* data){
+    simulation* sim = data;
+    simulationWorker* w = &sim->workers[thread];
+    if(sim->budget > 0 && getTimeSeconds() - sim->frameStart > sim->budget){
+        return(EXIT_FAILURE);
+    }
+
+    int first = index*SIMULATION_BLOCK;
+    int last = (first + SIMULATION_BLOCK < sim->awakeCount) ?
+            first + SIMULATION_BLOCK : sim->awakeCount;
+    int j, k;
+    for(k = first; k < last; k++){
+        int i = sim->awake[k];
+        int near = gridQuery(sim->grid, &sim->boxes[i], &w->nearby,
+                &w->nearbyCapacity);
+        for(j = 0; j < near; j++){
+            int other = w->nearby[j];
+            if(other == i || (other < i && sim->awakeSlots[other] >= 0)){
+                continue;
+            }
+            addContact(sim, w, i, other);
+        }
+        w->checked++;
+    }
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// GATHER CONTACTS ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function adds the contacts every thread found to the end of a list,
+ * growing it as needed, and empties the threads' contacts. Returns the number
+ * of pairs the threads checked.
+ */
+static int gatherContacts(simulation* sim, simulationContact** list,
+        int* count, int* capacity){
+    int pairs = 0, i;
+    for(i = 0; i < sim->threads; i++){
+        simulationWorker* w = &sim->workers[i];
+        if(*count + w->contactCount > *capacity){
+            *capacity = *count + w->contactCount;
+            *list = realloc(*list, sizeof(simulationContact)*(*capacity));
+        }
+        memcpy(*list + *count, w->contacts,
+                sizeof(simulationContact)*w->contactCount);
+        *count += w->contactCount;
+        pairs += w->pairs;
+        w->contactCount = 0;
+        w->pairs = 0;
+    }
+    return pairs;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// STEP SIMULATION ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function runs the simulation forward by one step of the given number of
+ * seconds. Afterwards the simulation's contacts hold every pair of bodies
+ * which touch (frame.contacts of them), with at least one awake or both
+ * asleep, and its frame describes the step: how many bodies were awake, how
+ * many pairs were checked, how many bodies were skipped for lack of time, and
+ * how long each part took. Pairs with an awake body in a skipped block are the
+ * only ones missing.
+ */
+static int compareContacts(const void* a, const void* b){
+    const simulationContact* x = a;
+    const simulationContact* y = b;
+    if(x->first != y->first){
+        return (x->first < y->first) ? -1 : 1;
+    }
+    return (x->second < y->second) ? -1 : (x->second > y->second);
+}
+
+int stepSimulation(simulation* sim, double step){
+    simulationFrame* f = &sim->frame;
+    sim->step = step;
+    sim->frameStart = getTimeSeconds();
+    int blocks = (sim->awakeCount + SIMULATION_BLOCK - 1)/SIMULATION_BLOCK;
+    int i;
+
+    parallelFor(blocks, sim->threads, moveBodies, sim);
+    double moved = getTimeSeconds();
+
+    //the grid can only be changed by one thread at a time
+    for(i = 0; i < sim->awakeCount; i++){
+        gridUpdate(sim->grid, sim->awake[i], &sim->boxes[sim->awake[i]]);
+    }
+    double gridded = getTimeSeconds();
+
+    //drop the resting contacts of bodies which have woken, and find those of
+    //bodies which have fallen asleep
+    int kept = 0;
+    for(i = 0; i < sim->restingCount; i++){
+        simulationContact* c = &sim->resting[i];
+        if(sim->restState[c->first] == REST_KNOWN &&
+                sim->restState[c->second] == REST_KNOWN){
+            sim->resting[kept] = *c;
+            kept++;
+        }
+    }
+    sim->restingCount = kept;
+    int pairs = 0;
+    if(sim->settlingCount > 0){
+        parallelFor((sim->settlingCount + SIMULATION_BLOCK - 1)/
+                SIMULATION_BLOCK, sim->threads, settleBodies, sim);
+        pairs += gatherContacts(sim, &sim->resting, &sim->restingCount,
+                &sim->restingCapacity);
+        qsort(sim->resting, sim->restingCount, sizeof(simulationContact),
+                compareContacts);
+        for(i = 0; i < sim->settlingCount; i++){
+            int body = sim->settling[i];
+            sim->restState[body] = (sim->awakeSlots[body] < 0) ? REST_KNOWN :
+                    REST_UNKNOWN;
+        }
+        sim->settlingCount = 0;
+    }
+
+    for(i = 0; i < sim->threads; i++){
+        sim->workers[i].checked = 0;
+    }
+    parallelFor(blocks, sim->threads, checkBodies, sim);
+
+    //gather the contacts each thread found after the resting ones, sort them,
+    //and merge the two in order. Each is written no later than it is read
+    int checked = 0;
+    for(i = 0; i < sim->threads; i++){
+        checked += sim->workers[i].checked;
+    }
+    int resting = sim->restingCount, contacts = resting;
+    pairs += gatherContacts(sim, &sim->contacts, &contacts,
+            &sim->contactCapacity);
+    qsort(sim->contacts + resting, contacts - resting,
+            sizeof(simulationContact), compareContacts);
+    int r = 0, a = resting, k = 0;
+    while(r < resting){
+        if(a < contacts &&
+                compareContacts(&sim->contacts[a], &sim->resting[r]) < 0){
+            sim->contacts[k] = sim->contacts[a];
+            a++;
+        }
+        else{
+            sim->contacts[k] = sim->resting[r];
+            r++;
+        }
+        k++;
+    }
+    double finished = getTimeSeconds();
+
+    f->number++;
+    f->time += step;
+    f->awake = sim->awakeCount;
+    f->pairs = pairs;
+    f->contacts = contacts;
+    f->skipped = sim->awakeCount - checked;
+    f->moveSeconds = moved - sim->frameStart;
+    f->gridSeconds = gridded - moved;
+    f->checkSeconds = finished - gridded;
+    f->seconds = finished - sim->frameStart;
+    return(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////// FREE SIMULATION ////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* This function frees a simulation. The polygons are left where the
+ * simulation moved them, and aren't freed.
+ */
+int freeSimulation(simulation* sim){
+    int i;
+    for(i = 0; i < sim->threads; i++){
+        free(sim->workers[i].nearby);
+        free(sim->workers[i].contacts);
+    }
+    free(sim->workers);
+    freeSpatialGrid(sim->grid);
+    free(sim->velocityX);
+    free(sim->velocityY);
+    free(sim->spin);
+    free(sim->awake);
+    free(sim->awakeSlots);
+    free(sim->restState);
+    free(sim->settling);
+    free(sim->resting);
+    free(sim->boxes);
+    free(sim->contacts);
+    free(sim);
+    return(EXIT_SUCCESS);
+}
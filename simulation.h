@@ -0,0 +1,81 @@
+/*
+ * File:   simulation.h
+ *
+ * This header file externalises the functions in the simulation.c file, which
+ * moves polygons by their velocities, a step at a time, and finds what touches
+ * after each step.
+ *
+ * For further details on any function, check there.
+ */
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct spatialGrid;
+struct simulationWorker;
+
+typedef struct simulationContact{
+    int first;
+    int second;
+    double depth;
+    double normalX;
+    double normalY;
+}simulationContact;
+
+typedef struct simulationFrame{
+    long number;
+    double time;
+    int awake;
+    int pairs;
+    int contacts;
+    int skipped;
+    double moveSeconds;
+    double gridSeconds;
+    double checkSeconds;
+    double seconds;
+}simulationFrame;
+
+typedef struct simulation{
+    polygon** polygons;
+    int count;
+    double* velocityX;
+    double* velocityY;
+    double* spin;
+    int* awake;
+    int* awakeSlots;
+    int awakeCount;
+    char* restState;
+    int* settling;
+    int settlingCount;
+    simulationContact* resting;
+    int restingCount;
+    int restingCapacity;
+    bounds* boxes;
+    struct spatialGrid* grid;
+    int threads;
+    struct simulationWorker* workers;
+    double budget;
+    double step;
+    double frameStart;
+    simulationContact* contacts;
+    int contactCapacity;
+    simulationFrame frame;
+}simulation;
+
+simulation* buildSimulation(polygon** list, int count, int threads);
+int setBodyVelocity(simulation* sim, int body, double velocityX,
+        double velocityY, double spin);
+int readSimulationMotion(simulation* sim, const char* filename,
+        parseError* error);
+int stepSimulation(simulation* sim, double step);
+int freeSimulation(simulation* sim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIMULATION_H */
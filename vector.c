@@ -75,4 +75,57 @@ vector* rand2DVector(){
     
     vector* r = createVector(x-1,y-1,0.0);
     return r;
-}
\ No newline at end of file
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//////////////// Seeded Random Numbers /////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+/* These functions provide a small PCG32 random number generator. Unlike rand()
+ * its state is held in a randomState struct rather than globally, so each 
+ * thread can have its own, and the same seed and stream always give the same 
+ * numbers on every platform.
+ * 
+ * The stream selects one of many independent sequences for the same seed: the
+ * fitting code uses the trial number as the stream, so each trial gets the same
+ * numbers no matter which thread runs it.
+ */
+int seedRandom(randomState* r, unsigned long long seed, unsigned long long stream){
+    //the increment must be odd
+    r->state = 0;
+    r->increment = (stream << 1u) | 1u;
+    
+    //step once, add the seed, and step again, as in the reference PCG
+    randomDouble(r);
+    r->state = r->state + seed;
+    randomDouble(r);
+    
+    return(EXIT_SUCCESS);
+}
+
+/* This function returns the next random double from a randomState, between 0
+ * and 1 (never reaching 1).
+ */
+double randomDouble(randomState* r){
+    unsigned long long old = r->state;
+    
+    //advance the state
+    r->state = old * 6364136223846793005ULL + r->increment;
+    
+    //permute the old state into 32 output bits
+    unsigned int xorShifted = (unsigned int)(((old >> 18u) ^ old) >> 27u);
+    unsigned int rot = (unsigned int)(old >> 59u);
+    unsigned int out = (xorShifted >> rot) | (xorShifted << ((-rot) & 31));
+    
+    return (double)out / 4294967296.0;
+}
+
+/* This function works as rand2DVector, but takes its numbers from the given
+ * randomState rather than rand().
+ */
+vector* rand2DVectorFrom(randomState* r){
+    double x = randomDouble(r)*2.0;
+    double y = randomDouble(r)*2.0;
+    
+    vector* v = createVector(x-1,y-1,0.0);
+    return v;
+}
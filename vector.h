@@ -25,6 +25,15 @@ double dotProduct(vector* a, vector* b);
 vector* getLineNormal(vector* a, vector* b);
 vector* rand2DVector();
 
+typedef struct randomState{
+    unsigned long long state;
+    unsigned long long increment;
+}randomState;
+
+int seedRandom(randomState* r, unsigned long long seed, unsigned long long stream);
+double randomDouble(randomState* r);
+vector* rand2DVectorFrom(randomState* r);
+
 #ifdef	__cplusplus
 extern "C" {
 #endif